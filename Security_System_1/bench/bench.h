@@ -0,0 +1,89 @@
+/******************************************************************************
+* File Name:   bench.h
+*
+* Description: Timing helpers shared by the host benchmarks.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Repetitions of a measurement; the fastest one is reported, which filters
+ * out preemption by the host.
+ */
+#define BENCH_REPEAT                       (5u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Written with every result so that the compiler keeps the measured calls. */
+extern volatile uintptr_t bench_sink;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+/******************************************************************************
+ * Function Name: bench_now_ns
+ ******************************************************************************
+ * Summary:
+ *  Returns the monotonic clock of the host in nanoseconds.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint64_t : Time in nanoseconds
+ *
+ ******************************************************************************/
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+#endif /* BENCH_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,281 @@
+/******************************************************************************
+* File Name:   bench_codec.c
+*
+* Description: This file contains the host benchmark of the telemetry codecs:
+*              time to encode a sample of each sensor and size of the payload,
+*              with the text codec against the binary one.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "bench.h"
+
+/* The codec itself, for its static text and binary encoders. */
+#include "../source/telemetry_codec.c"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Samples encoded per measurement. */
+#define BENCH_ENCODES                   (1000000u)
+
+/* Timestamp of the samples, one hour after boot, so that the sizes do not
+ * depend on the uptime of the build machine.
+ */
+#define BENCH_TIMESTAMP_MS              (3600000u)
+
+/* Encoders compared. */
+#define BENCH_TEXT_VALUE                (0)
+#define BENCH_TEXT_RECORD               (1)
+#define BENCH_BINARY                    (2)
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Sample of one of the sensors of the application. */
+typedef struct
+{
+    const char *name;
+    telemetry_type_t type;
+    telemetry_unit_t unit;
+    int32_t value;
+    int8_t exponent;
+} bench_sample_t;
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* Samples as the sensor tasks of main.c produce them. */
+static const bench_sample_t bench_samples[] =
+{
+    { "temperature", TELEMETRY_TYPE_TEMPERATURE, TELEMETRY_UNIT_CELSIUS,    2345,    -2 },
+    { "vibration",   TELEMETRY_TYPE_VIBRATION,   TELEMETRY_UNIT_MICROVOLT, -1234567,  0 },
+    { "button",      TELEMETRY_TYPE_BUTTON,      TELEMETRY_UNIT_NONE,       1,        0 },
+    { "presence",    TELEMETRY_TYPE_PRESENCE,    TELEMETRY_UNIT_NONE,       0,        0 },
+};
+
+/******************************************************************************
+ * Function Name: encode_text_record
+ ******************************************************************************
+ * Summary:
+ *  Reference text encoding that carries the same four fields as the binary
+ *  codec, "<type>,<unit>,<value>,<timestamp>", e.g. "1,1,23.45,3600000".
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to encode
+ *  char *buffer : Output buffer, null-terminated on success
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  size_t : Length of the string, 0 if it does not fit the buffer
+ *
+ ******************************************************************************/
+static size_t encode_text_record(const telemetry_sample_t *sample, char *buffer, size_t size)
+{
+    int written = snprintf(buffer, size, "%u,%u,", (unsigned) sample->type,
+                           (unsigned) sample->unit);
+    size_t value_len;
+
+    if ((written < 0) || ((size_t) written >= size))
+    {
+        return 0;
+    }
+
+    value_len = telemetry_encode_text(sample, &buffer[written], size - (size_t) written);
+    if (value_len == 0)
+    {
+        return 0;
+    }
+
+    size_t len = (size_t) written + value_len;
+    written = snprintf(&buffer[len], size - len, ",%lu", (unsigned long) sample->timestamp_ms);
+    if ((written < 0) || (len + (size_t) written >= size))
+    {
+        return 0;
+    }
+
+    return len + (size_t) written;
+}
+
+/******************************************************************************
+ * Function Name: time_encode
+ ******************************************************************************
+ * Summary:
+ *  Times 'BENCH_ENCODES' encodings of a sample with one of the encoders.
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to encode
+ *  int encoder : 'BENCH_TEXT_VALUE', 'BENCH_TEXT_RECORD' or 'BENCH_BINARY'
+ *  size_t *len : Receives the length of the payload
+ *
+ * Return:
+ *  double : Fastest time per encoding in nanoseconds
+ *
+ ******************************************************************************/
+static double time_encode(const telemetry_sample_t *sample, int encoder, size_t *len)
+{
+    uint8_t buffer[PUBLISH_PAYLOAD_SIZE];
+    double best = 0.0;
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEAT; repeat++)
+    {
+        uint64_t start = bench_now_ns();
+
+        for (uint32_t i = 0; i < BENCH_ENCODES; i++)
+        {
+            switch (encoder)
+            {
+                case BENCH_TEXT_VALUE:
+                    *len = telemetry_encode_text(sample, (char *) buffer, sizeof(buffer));
+                    break;
+
+                case BENCH_TEXT_RECORD:
+                    *len = encode_text_record(sample, (char *) buffer, sizeof(buffer));
+                    break;
+
+                default:
+                    *len = telemetry_encode_binary(sample, buffer, sizeof(buffer));
+                    break;
+            }
+            bench_sink += buffer[0];
+        }
+
+        double ns = (double) (bench_now_ns() - start) / BENCH_ENCODES;
+        if ((repeat == 0) || (ns < best))
+        {
+            best = ns;
+        }
+    }
+
+    return best;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Prints the time to encode a sample of each sensor and the size of the
+ *  payload, with the text codec, with a text record of the same four fields
+ *  as the binary codec, and with the binary codec. The text codec only
+ *  carries the value.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  int : 0 on success
+ *
+ ******************************************************************************/
+int main(void)
+{
+    printf("Telemetry codecs: payload in bytes, time in ns per sample\n");
+    printf("%12s %20s %8s %8s %8s %9s %8s %9s\n", "sample", "text record", "value B",
+           "value ns", "record B", "record ns", "binary B", "binary ns");
+
+    for (size_t i = 0; i < sizeof(bench_samples) / sizeof(bench_samples[0]); i++)
+    {
+        const bench_sample_t *source = &bench_samples[i];
+        char record[PUBLISH_PAYLOAD_SIZE];
+        telemetry_sample_t sample;
+        size_t value_len;
+        size_t record_len;
+        size_t binary_len;
+
+        telemetry_sample_init(&sample, source->type, source->unit, source->value,
+                              source->exponent);
+        sample.timestamp_ms = BENCH_TIMESTAMP_MS;
+        double value_ns = time_encode(&sample, BENCH_TEXT_VALUE, &value_len);
+        double record_ns = time_encode(&sample, BENCH_TEXT_RECORD, &record_len);
+        double binary_ns = time_encode(&sample, BENCH_BINARY, &binary_len);
+
+        if ((value_len == 0) || (record_len == 0) || (binary_len == 0) ||
+            (binary_len > TELEMETRY_BINARY_MAX_SIZE))
+        {
+            printf("Encoding the %s sample failed\n", source->name);
+            return 1;
+        }
+
+        encode_text_record(&sample, record, sizeof(record));
+        printf("%12s %20s %8zu %8.1f %8zu %9.1f %8zu %9.1f\n", source->name, record, value_len,
+               value_ns, record_len, record_ns, binary_len, binary_ns);
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: PublishPayload
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *  const char *topic : Topic
+ *
+ * Return:
+ *  bool : true
+ *
+ ******************************************************************************/
+bool PublishPayload(const void *payload, size_t payload_len, const char *topic)
+{
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: PublishAlarm
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *  const char *topic : Topic
+ *
+ * Return:
+ *  bool : true
+ *
+ ******************************************************************************/
+bool PublishAlarm(const void *payload, size_t payload_len, const char *topic)
+{
+    return true;
+}
+
+/* [] END OF FILE */
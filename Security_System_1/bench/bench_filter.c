@@ -0,0 +1,376 @@
+/******************************************************************************
+* File Name:   bench_filter.c
+*
+* Description: This file contains the host benchmark of the topic filter trie:
+*              time to match an inbound topic with topic_filter_match()
+*              against checking every registered filter in turn, for a growing
+*              number of wildcard filters.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "topic_registry.h"
+#include "topic_filter.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Matches timed per measurement. */
+#define BENCH_MATCHES                   (500000u)
+
+/* Inbound topics cycled through per measurement. */
+#define BENCH_TOPIC_COUNT               (64u)
+
+/* Most filters reported for one topic. */
+#define BENCH_MAX_MATCHES               (8u)
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* Registered filters, for the linear reference. */
+static topic_registry_entry_t *bench_filters[TOPIC_REGISTRY_MAX_TOPICS];
+static size_t bench_filter_count = 0;
+
+/******************************************************************************
+ * Function Name: filter_matches
+ ******************************************************************************
+ * Summary:
+ *  Reference matcher: checks one topic filter against one topic, level by
+ *  level, as the MQTT specification describes it.
+ *
+ * Parameters:
+ *  const char *filter : Topic filter
+ *  size_t filter_len : Length of the filter
+ *  const char *topic : Topic name
+ *  size_t topic_len : Length of the topic
+ *
+ * Return:
+ *  bool : true if the filter matches the topic
+ *
+ ******************************************************************************/
+static bool filter_matches(const char *filter, size_t filter_len,
+                           const char *topic, size_t topic_len)
+{
+    size_t f = 0;
+    size_t t = 0;
+
+    if ((topic_len > 0) && (topic[0] == '$') && (filter_len > 0) &&
+        ((filter[0] == TOPIC_FILTER_SINGLE_LEVEL) || (filter[0] == TOPIC_FILTER_MULTI_LEVEL)))
+    {
+        return false;
+    }
+
+    while (f < filter_len)
+    {
+        if (filter[f] == TOPIC_FILTER_MULTI_LEVEL)
+        {
+            return true;
+        }
+
+        if (filter[f] == TOPIC_FILTER_SINGLE_LEVEL)
+        {
+            if (t > topic_len)
+            {
+                return false;
+            }
+            while ((t < topic_len) && (topic[t] != TOPIC_LEVEL_SEPARATOR))
+            {
+                t++;
+            }
+            f++;
+        }
+        else
+        {
+            while ((f < filter_len) && (filter[f] != TOPIC_LEVEL_SEPARATOR))
+            {
+                if ((t >= topic_len) || (topic[t] != filter[f]))
+                {
+                    return false;
+                }
+                f++;
+                t++;
+            }
+            if ((t < topic_len) && (topic[t] != TOPIC_LEVEL_SEPARATOR))
+            {
+                return false;
+            }
+        }
+
+        if (f == filter_len)
+        {
+            return (t == topic_len);
+        }
+
+        /* Both are at a separator. "a/#" also matches "a". */
+        f++;
+        if ((t == topic_len) && (f < filter_len) && (filter[f] == TOPIC_FILTER_MULTI_LEVEL))
+        {
+            return true;
+        }
+        if (t == topic_len)
+        {
+            return false;
+        }
+        t++;
+    }
+
+    return (t == topic_len);
+}
+
+/******************************************************************************
+ * Function Name: linear_match
+ ******************************************************************************
+ * Summary:
+ *  Matches a topic against every registered filter in turn.
+ *
+ * Parameters:
+ *  const char *topic : Topic name
+ *  size_t topic_len : Length of the topic
+ *  topic_registry_entry_t **matches : Receives the matching filters
+ *  size_t max_matches : Number of elements in 'matches'
+ *
+ * Return:
+ *  size_t : Number of matching filters
+ *
+ ******************************************************************************/
+static size_t linear_match(const char *topic, size_t topic_len,
+                           topic_registry_entry_t **matches, size_t max_matches)
+{
+    size_t match_count = 0;
+
+    for (size_t i = 0; (i < bench_filter_count) && (match_count < max_matches); i++)
+    {
+        if (filter_matches(bench_filters[i]->topic, bench_filters[i]->topic_len, topic, topic_len))
+        {
+            matches[match_count++] = bench_filters[i];
+        }
+    }
+
+    return match_count;
+}
+
+/******************************************************************************
+ * Function Name: add_filter
+ ******************************************************************************
+ * Summary:
+ *  Registers the filter number 'n'. The filters mix the shapes used by the
+ *  application: "deviceN/+/temperature", "deviceN/#" and "+/roomN/humidity".
+ *
+ * Parameters:
+ *  size_t n : Filter number
+ *
+ * Return:
+ *  bool : true if the filter was added
+ *
+ ******************************************************************************/
+static bool add_filter(size_t n)
+{
+    const topic_config_t config = { TOPIC_STORAGE_QUEUE, TOPIC_OVERFLOW_DROP_NEWEST, 10u, 128u, NULL };
+    char filter[TOPIC_MAX_LENGTH + 1];
+    topic_registry_entry_t *entry;
+
+    switch (n % 3u)
+    {
+        case 0:
+            snprintf(filter, sizeof(filter), "device%zu/+/temperature", n / 3u);
+            break;
+
+        case 1:
+            snprintf(filter, sizeof(filter), "device%zu/#", n / 3u);
+            break;
+
+        default:
+            snprintf(filter, sizeof(filter), "+/room%zu/humidity", n / 3u);
+            break;
+    }
+
+    entry = topic_registry_add(filter, strlen(filter), &config);
+    if ((entry == NULL) || !topic_filter_add(entry))
+    {
+        printf("Adding the filter %s failed\n", filter);
+        return false;
+    }
+
+    bench_filters[bench_filter_count++] = entry;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: time_matches
+ ******************************************************************************
+ * Summary:
+ *  Times 'BENCH_MATCHES' matches cycling through a set of topics, with the
+ *  trie or with the linear reference, and checks that both agree.
+ *
+ * Parameters:
+ *  char topics[][TOPIC_MAX_LENGTH + 1] : Topics to match
+ *  int linear : Non-zero for the linear reference
+ *  size_t *matched : Receives the number of matches per topic, on average
+ *
+ * Return:
+ *  double : Fastest time per match in nanoseconds
+ *
+ ******************************************************************************/
+static double time_matches(char topics[][TOPIC_MAX_LENGTH + 1], int linear, double *matched)
+{
+    topic_registry_entry_t *matches[BENCH_MAX_MATCHES];
+    size_t lens[BENCH_TOPIC_COUNT];
+    double best = 0.0;
+    size_t total = 0;
+
+    for (size_t i = 0; i < BENCH_TOPIC_COUNT; i++)
+    {
+        lens[i] = strlen(topics[i]);
+    }
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEAT; repeat++)
+    {
+        uint64_t start = bench_now_ns();
+        size_t n = 0;
+
+        total = 0;
+        for (uint32_t i = 0; i < BENCH_MATCHES; i++)
+        {
+            total += linear ? linear_match(topics[n], lens[n], matches, BENCH_MAX_MATCHES) :
+                              topic_filter_match(topics[n], lens[n], matches, BENCH_MAX_MATCHES);
+            bench_sink += (uintptr_t) matches[0];
+            n = (n + 1u) % BENCH_TOPIC_COUNT;
+        }
+
+        double ns = (double) (bench_now_ns() - start) / BENCH_MATCHES;
+        if ((repeat == 0) || (ns < best))
+        {
+            best = ns;
+        }
+    }
+
+    *matched = (double) total / BENCH_MATCHES;
+    return best;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Adds the filter counts given on the command line one after the other and
+ *  prints the time to match an inbound topic with the trie and with the
+ *  linear reference. Half of the inbound topics match a filter, the other
+ *  half matches none.
+ *
+ * Parameters:
+ *  int argc : Argument count
+ *  char *argv[] : Filter counts, ascending
+ *
+ * Return:
+ *  int : 0 on success
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    static char topics[BENCH_TOPIC_COUNT][TOPIC_MAX_LENGTH + 1];
+
+    printf("Topic filter trie, %u nodes: ns per inbound topic\n", (unsigned) TOPIC_FILTER_MAX_NODES);
+    printf("%8s %10s %12s %12s\n", "filters", "matches", "trie", "linear");
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        size_t count = (size_t) strtoul(argv[arg], NULL, 10);
+        double trie_matched;
+        double linear_matched;
+
+        if ((count == 0) || (count > TOPIC_REGISTRY_MAX_TOPICS) || (count < bench_filter_count))
+        {
+            printf("%8zu skipped, the registry holds up to %u filters\n", count,
+                   (unsigned) TOPIC_REGISTRY_MAX_TOPICS);
+            continue;
+        }
+
+        while (bench_filter_count < count)
+        {
+            if (!add_filter(bench_filter_count))
+            {
+                return 1;
+            }
+        }
+
+        /* Topics spread over the devices and rooms of the filters. */
+        for (size_t i = 0; i < BENCH_TOPIC_COUNT; i++)
+        {
+            size_t id = (i * 7u) % ((count + 2u) / 3u);
+
+            switch (i % 4u)
+            {
+                case 0:
+                    snprintf(topics[i], sizeof(topics[i]), "device%zu/room%zu/temperature", id, id);
+                    break;
+
+                case 1:
+                    snprintf(topics[i], sizeof(topics[i]), "hall/room%zu/humidity", id);
+                    break;
+
+                case 2:
+                    snprintf(topics[i], sizeof(topics[i]), "sensor%zu/room%zu/temperature", id, id);
+                    break;
+
+                default:
+                    snprintf(topics[i], sizeof(topics[i]), "hall/room%zu/pressure", id);
+                    break;
+            }
+        }
+
+        double trie_ns = time_matches(topics, 0, &trie_matched);
+        double linear_ns = time_matches(topics, 1, &linear_matched);
+
+        if (trie_matched != linear_matched)
+        {
+            printf("The trie and the linear reference disagree (%.2f and %.2f matches)\n",
+                   trie_matched, linear_matched);
+            return 1;
+        }
+
+        printf("%8zu %10.2f %12.1f %12.1f\n", count, trie_matched, trie_ns, linear_ns);
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,446 @@
+/******************************************************************************
+* File Name:   bench_isr_ring.c
+*
+* Description: This file contains the host stress test of the ISR ring of the
+*              publisher (publish_isr_ring.c): several producer threads push
+*              at the same time while one or more consumer threads pop, and
+*              every message is checked to arrive exactly once, intact and,
+*              with one consumer, in order.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "bench.h"
+
+/* Yields at the race points of the ring, see bench_preempt(). */
+static void bench_preempt(void);
+#define PUBLISH_ISR_PREEMPT()           bench_preempt()
+
+#include "../source/publish_isr_ring.c"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Messages pushed by each producer. */
+#define BENCH_MESSAGES                  (50000u)
+
+/* Most producers and consumers of a run. */
+#define BENCH_MAX_PRODUCERS             (8u)
+#define BENCH_MAX_CONSUMERS             (4u)
+
+/* Seconds without a message popped before a run is declared stalled. */
+#define BENCH_STALL_SECONDS             (5u)
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Outcome of one message of a producer. */
+typedef struct
+{
+    atomic_uchar pushed;        /* Taken by publish_isr_push() */
+    atomic_uchar popped;        /* Times publish_isr_pop() returned it */
+} bench_message_t;
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* Topic of each producer, only the pointer goes through the ring. */
+static const char *const bench_topics[BENCH_MAX_PRODUCERS] =
+{
+    "isr/0", "isr/1", "isr/2", "isr/3", "isr/4", "isr/5", "isr/6", "isr/7"
+};
+
+/* Outcome of every message, per producer. */
+static bench_message_t *bench_messages[BENCH_MAX_PRODUCERS];
+
+/* Producers still running, pushes refused by a full ring, and the failures
+ * seen by the consumers.
+ */
+static atomic_uint bench_producers_running;
+static atomic_ulong bench_ring_full;
+static atomic_uint bench_corrupt;
+static atomic_uint bench_out_of_order;
+
+/* Messages popped since the start, watched for progress by the watchdog. */
+static atomic_ulong bench_progress;
+
+/* Set when a run has a single consumer, so the order can be checked. */
+static bool bench_check_order;
+
+/* State of the random generator of each thread. */
+static __thread uint32_t bench_random;
+
+/******************************************************************************
+ * Function Name: bench_preempt
+ ******************************************************************************
+ * Summary:
+ *  Called at the race points of the ring. Yields at random one time in four,
+ *  so that the other threads run between the steps of a push or pop as a
+ *  nested interrupt would, even on a single core.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void bench_preempt(void)
+{
+    if (bench_random == 0)
+    {
+        bench_random = (uint32_t) (uintptr_t) &bench_random | 1u;
+    }
+
+    /* xorshift32 */
+    bench_random ^= bench_random << 13;
+    bench_random ^= bench_random >> 17;
+    bench_random ^= bench_random << 5;
+
+    if ((bench_random & 3u) == 0)
+    {
+        sched_yield();
+    }
+}
+
+/******************************************************************************
+ * Function Name: producer_thread
+ ******************************************************************************
+ * Summary:
+ *  Interrupt handler of the stress test: pushes 'BENCH_MESSAGES' messages
+ *  "<producer>:<index>" and records which ones the ring took. A push refused
+ *  by a full ring is counted and retried after yielding to the consumers, so
+ *  that every message goes through the ring even on a single core.
+ *
+ * Parameters:
+ *  void *arg : Producer number
+ *
+ * Return:
+ *  void * : NULL
+ *
+ ******************************************************************************/
+static void *producer_thread(void *arg)
+{
+    unsigned int producer = (unsigned int) (uintptr_t) arg;
+    char payload[PUBLISH_ISR_PAYLOAD_SIZE + 1];
+
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        int len = snprintf(payload, sizeof(payload), "%u:%lu", producer, (unsigned long) i);
+
+        while (!publish_isr_push(bench_topics[producer], payload, (size_t) len))
+        {
+            atomic_fetch_add(&bench_ring_full, 1u);
+            sched_yield();
+        }
+        atomic_store(&bench_messages[producer][i].pushed, 1u);
+    }
+
+    atomic_fetch_sub(&bench_producers_running, 1u);
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: consume
+ ******************************************************************************
+ * Summary:
+ *  Checks one popped message and records it.
+ *
+ * Parameters:
+ *  const publish_isr_entry_t *entry : Popped message
+ *  long *last : Index of the last message popped per producer by this
+ *               consumer
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void consume(const publish_isr_entry_t *entry, long *last)
+{
+    char payload[PUBLISH_ISR_PAYLOAD_SIZE + 1];
+    unsigned int producer;
+    unsigned long index;
+
+    memcpy(payload, entry->payload, entry->payload_len);
+    payload[entry->payload_len] = '\0';
+
+    if ((sscanf(payload, "%u:%lu", &producer, &index) != 2) ||
+        (producer >= BENCH_MAX_PRODUCERS) || (index >= BENCH_MESSAGES) ||
+        (entry->topic != bench_topics[producer]))
+    {
+        atomic_fetch_add(&bench_corrupt, 1u);
+        return;
+    }
+
+    atomic_fetch_add(&bench_progress, 1u);
+    atomic_fetch_add(&bench_messages[producer][index].popped, 1u);
+    if (bench_check_order && ((long) index <= last[producer]))
+    {
+        atomic_fetch_add(&bench_out_of_order, 1u);
+    }
+    last[producer] = (long) index;
+}
+
+/******************************************************************************
+ * Function Name: consumer_thread
+ ******************************************************************************
+ * Summary:
+ *  Publisher task of the stress test: pops messages until the producers are
+ *  done and the ring is empty.
+ *
+ * Parameters:
+ *  void *arg : Unused
+ *
+ * Return:
+ *  void * : Number of messages popped
+ *
+ ******************************************************************************/
+static void *consumer_thread(void *arg)
+{
+    long last[BENCH_MAX_PRODUCERS];
+    publish_isr_entry_t entry;
+    uintptr_t popped = 0;
+    bool done = false;
+
+    for (size_t i = 0; i < BENCH_MAX_PRODUCERS; i++)
+    {
+        last[i] = -1;
+    }
+
+    while (!done)
+    {
+        /* Read before popping, so that an empty ring after the last producer
+         * finished means that every message was seen.
+         */
+        done = (atomic_load(&bench_producers_running) == 0);
+
+        while (publish_isr_pop(&entry))
+        {
+            consume(&entry, last);
+            popped++;
+            done = false;
+        }
+        sched_yield();
+    }
+
+    return (void *) popped;
+}
+
+/******************************************************************************
+ * Function Name: watchdog_thread
+ ******************************************************************************
+ * Summary:
+ *  Fails the test when no message was popped for 'BENCH_STALL_SECONDS'
+ *  seconds: a corrupted ring leaves the producers spinning on a full ring or
+ *  the consumers on an entry that is never published.
+ *
+ * Parameters:
+ *  void *arg : Unused
+ *
+ * Return:
+ *  void * : Never returns
+ *
+ ******************************************************************************/
+static void *watchdog_thread(void *arg)
+{
+    unsigned long last = atomic_load(&bench_progress);
+
+    for (;;)
+    {
+        sleep(BENCH_STALL_SECONDS);
+
+        unsigned long now = atomic_load(&bench_progress);
+        if (now == last)
+        {
+            printf("STALLED after %lu messages\nFAILED\n", now);
+            fflush(stdout);
+            _exit(1);
+        }
+        last = now;
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: run
+ ******************************************************************************
+ * Summary:
+ *  Runs the producers and consumers against the ring and checks that every
+ *  message the ring took was popped exactly once and intact, and that a
+ *  single consumer saw the messages of each producer in order.
+ *
+ * Parameters:
+ *  unsigned int producers : Number of producer threads
+ *  unsigned int consumers : Number of consumer threads
+ *
+ * Return:
+ *  bool : true if every message was pushed and none was lost, duplicated,
+ *         corrupted or reordered
+ *
+ ******************************************************************************/
+static bool run(unsigned int producers, unsigned int consumers)
+{
+    pthread_t producer_threads[BENCH_MAX_PRODUCERS];
+    pthread_t consumer_threads[BENCH_MAX_CONSUMERS];
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t lost = 0;
+    uint64_t duplicated = 0;
+
+    for (unsigned int p = 0; p < producers; p++)
+    {
+        memset(bench_messages[p], 0, BENCH_MESSAGES * sizeof(bench_message_t));
+    }
+    atomic_store(&bench_producers_running, producers);
+    atomic_store(&bench_ring_full, 0u);
+    atomic_store(&bench_corrupt, 0u);
+    atomic_store(&bench_out_of_order, 0u);
+    bench_check_order = (consumers == 1u);
+
+    uint64_t start = bench_now_ns();
+    for (unsigned int c = 0; c < consumers; c++)
+    {
+        pthread_create(&consumer_threads[c], NULL, consumer_thread, NULL);
+    }
+    for (unsigned int p = 0; p < producers; p++)
+    {
+        pthread_create(&producer_threads[p], NULL, producer_thread, (void *) (uintptr_t) p);
+    }
+    for (unsigned int p = 0; p < producers; p++)
+    {
+        pthread_join(producer_threads[p], NULL);
+    }
+    for (unsigned int c = 0; c < consumers; c++)
+    {
+        void *count;
+        pthread_join(consumer_threads[c], &count);
+        popped += (uintptr_t) count;
+    }
+    double seconds = (double) (bench_now_ns() - start) / 1e9;
+
+    for (unsigned int p = 0; p < producers; p++)
+    {
+        for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+        {
+            unsigned int taken = atomic_load(&bench_messages[p][i].pushed);
+            unsigned int seen = atomic_load(&bench_messages[p][i].popped);
+
+            pushed += taken;
+            lost += (taken > seen) ? (taken - seen) : 0u;
+            duplicated += (seen > taken) ? (seen - taken) : 0u;
+        }
+    }
+
+    printf("%9u %9u %10llu %10llu %8llu %10llu %6llu %10u %10u %10.1f\n", producers, consumers,
+           (unsigned long long) pushed, (unsigned long long) popped,
+           (unsigned long long) lost, (unsigned long long) atomic_load(&bench_ring_full),
+           (unsigned long long) duplicated, atomic_load(&bench_corrupt),
+           atomic_load(&bench_out_of_order), (double) popped / seconds / 1e6);
+
+    return ((pushed == (uint64_t) producers * BENCH_MESSAGES) && (lost == 0) &&
+            (duplicated == 0) && (popped == pushed) &&
+            (atomic_load(&bench_corrupt) == 0) && (atomic_load(&bench_out_of_order) == 0));
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Stress test of the ISR ring of the publisher: producer threads push
+ *  concurrently, as nested interrupt handlers would, while consumer threads
+ *  pop, as the publisher tasks do. The producer and consumer counts are
+ *  given as pairs on the command line, e.g. "4 1 4 2".
+ *
+ * Parameters:
+ *  int argc : Argument count
+ *  char *argv[] : Producer and consumer counts
+ *
+ * Return:
+ *  int : 0 if every run passed
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    pthread_t watchdog;
+    bool passed = true;
+
+    for (size_t p = 0; p < BENCH_MAX_PRODUCERS; p++)
+    {
+        bench_messages[p] = malloc(BENCH_MESSAGES * sizeof(bench_message_t));
+        if (bench_messages[p] == NULL)
+        {
+            return 1;
+        }
+    }
+
+    pthread_create(&watchdog, NULL, watchdog_thread, NULL);
+    pthread_detach(watchdog);
+
+    printf("ISR ring, %u entries, %u messages per producer\n", (unsigned) PUBLISH_ISR_RING_SIZE,
+           (unsigned) BENCH_MESSAGES);
+    printf("%9s %9s %10s %10s %8s %10s %6s %10s %10s %10s\n", "producers", "consumers",
+           "pushed", "popped", "lost", "ring full", "dup", "corrupt", "reordered", "Mmsg/s");
+
+    for (int arg = 1; arg + 1 < argc; arg += 2)
+    {
+        unsigned int producers = (unsigned int) strtoul(argv[arg], NULL, 10);
+        unsigned int consumers = (unsigned int) strtoul(argv[arg + 1], NULL, 10);
+
+        if ((producers == 0) || (producers > BENCH_MAX_PRODUCERS) ||
+            (consumers == 0) || (consumers > BENCH_MAX_CONSUMERS))
+        {
+            printf("Skipped %u producers and %u consumers\n", producers, consumers);
+            continue;
+        }
+
+        passed &= run(producers, consumers);
+    }
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+    return passed ? 0 : 1;
+}
+
+/* [] END OF FILE */
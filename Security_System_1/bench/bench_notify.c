@@ -0,0 +1,512 @@
+/******************************************************************************
+* File Name:   bench_notify.c
+*
+* Description: This file contains the host benchmark of the delivery of
+*              actuator commands by the subscriber task: a queue of message
+*              pool blocks against a mailbox and a task notification value, in
+*              storage, time spent in the MQTT callback and latency until the
+*              actuator task holds the command.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+/* The subscriber task itself, for its static storage functions. */
+#include "../source/subscriber_task.c"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Messages delivered per measurement. */
+#define BENCH_MESSAGES                  (200000u)
+
+/* Messages handed from the MQTT callback to a waiting task per path. */
+#define BENCH_HANDOVERS                 (20000u)
+
+/* Command payload of the actuator topics. */
+#define BENCH_PAYLOAD                   "1"
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Delivery path: the storage kind of an actuator topic. */
+typedef struct
+{
+    const char *name;
+    const char *topic;
+    topic_config_t config;
+} bench_path_t;
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* The queue of the original actuator tasks, the one-byte mailbox and the
+ * task notification value, with the settings the firmware uses.
+ */
+static const bench_path_t bench_paths[] =
+{
+    { "queue",   "bench/queue",   TOPIC_CONFIG_DEFAULT },
+    { "mailbox", "bench/mailbox", TOPIC_CONFIG_COMMAND },
+    { "notify",  "bench/notify",  TOPIC_CONFIG_VALUE },
+};
+
+/* Hand-over between the MQTT callback and the waiting actuator task. */
+static _Atomic(TaskHandle_t) bench_actuator = NULL;
+static atomic_bool bench_attached = false;
+static atomic_bool bench_waiting = false;
+static atomic_uint_fast64_t bench_received_ns = 0;
+
+/******************************************************************************
+ * Function Name: bench_deliver
+ ******************************************************************************
+ * Summary:
+ *  Runs the MQTT subscription callback for one command of a path.
+ *
+ * Parameters:
+ *  const bench_path_t *path : Delivery path
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void bench_deliver(const bench_path_t *path)
+{
+    cy_mqtt_publish_info_t info =
+    {
+        .qos = CY_MQTT_QOS1,
+        .topic = path->topic,
+        .topic_len = (uint16_t) strlen(path->topic),
+        .payload = BENCH_PAYLOAD,
+        .payload_len = sizeof(BENCH_PAYLOAD) - 1u
+    };
+
+    mqtt_subscription_callback(&info);
+}
+
+/******************************************************************************
+ * Function Name: bench_receive
+ ******************************************************************************
+ * Summary:
+ *  Receives one command of a path the way an actuator task does.
+ *
+ * Parameters:
+ *  const bench_path_t *path : Delivery path
+ *  TickType_t wait : Ticks to wait for the command
+ *
+ * Return:
+ *  bool : true if the command was received
+ *
+ ******************************************************************************/
+static bool bench_receive(const bench_path_t *path, TickType_t wait)
+{
+    char buffer[MESSAGE_POOL_PAYLOAD_SIZE + 1];
+    uint32_t value;
+
+    if (path->config.kind == TOPIC_STORAGE_NOTIFY)
+    {
+        return (topic_receive_value(path->topic, &value, wait) && (value == 1u));
+    }
+
+    return ((topic_receive(path->topic, buffer, sizeof(buffer), wait) == 1u) &&
+            (buffer[0] == BENCH_PAYLOAD[0]));
+}
+
+/******************************************************************************
+ * Function Name: bench_attach
+ ******************************************************************************
+ * Summary:
+ *  Registers the calling thread as the consuming task of a path.
+ *
+ * Parameters:
+ *  const bench_path_t *path : Delivery path
+ *
+ * Return:
+ *  bool : true if the storage was created
+ *
+ ******************************************************************************/
+static bool bench_attach(const bench_path_t *path)
+{
+    return (add_storage_for_topic(path->topic, strlen(path->topic),
+                                  xTaskGetCurrentTaskHandle(), &path->config) != NULL);
+}
+
+/******************************************************************************
+ * Function Name: time_path
+ ******************************************************************************
+ * Summary:
+ *  Delivers and receives 'BENCH_MESSAGES' commands in the calling thread and
+ *  times both sides separately, without the cost of reading the clock.
+ *
+ * Parameters:
+ *  const bench_path_t *path : Delivery path, consumed by the calling thread
+ *  double *callback_ns : Receives the time in the MQTT callback per command
+ *  double *receive_ns : Receives the time in the receiving task per command
+ *
+ * Return:
+ *  bool : true if every command was received
+ *
+ ******************************************************************************/
+static bool time_path(const bench_path_t *path, double *callback_ns, double *receive_ns)
+{
+    uint64_t clock_ns = UINT64_MAX;
+
+    /* Cost of reading the clock, taken off every interval */
+    for (uint32_t i = 0; i < 1000u; i++)
+    {
+        uint64_t start = bench_now_ns();
+        uint64_t end = bench_now_ns();
+        clock_ns = ((end - start) < clock_ns) ? (end - start) : clock_ns;
+    }
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEAT; repeat++)
+    {
+        uint64_t deliver_total = 0;
+        uint64_t receive_total = 0;
+
+        for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+        {
+            uint64_t start = bench_now_ns();
+            bench_deliver(path);
+            uint64_t delivered = bench_now_ns();
+            bool received = bench_receive(path, 0);
+            uint64_t end = bench_now_ns();
+
+            if (!received)
+            {
+                return false;
+            }
+            deliver_total += (delivered - start) - clock_ns;
+            receive_total += (end - delivered) - clock_ns;
+        }
+
+        double deliver_ns = (double) deliver_total / BENCH_MESSAGES;
+        double received_ns = (double) receive_total / BENCH_MESSAGES;
+        if ((repeat == 0) || (deliver_ns + received_ns < *callback_ns + *receive_ns))
+        {
+            *callback_ns = deliver_ns;
+            *receive_ns = received_ns;
+        }
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: actuator_thread
+ ******************************************************************************
+ * Summary:
+ *  Actuator task of the hand-over measurement: announces its task handle
+ *  and, once its storage is attached, waits for the commands of a path and
+ *  stamps the time each one arrives.
+ *
+ * Parameters:
+ *  void *arg : Delivery path
+ *
+ * Return:
+ *  void * : NULL
+ *
+ ******************************************************************************/
+static void *actuator_thread(void *arg)
+{
+    const bench_path_t *path = arg;
+
+    atomic_store(&bench_actuator, xTaskGetCurrentTaskHandle());
+    while (!atomic_load(&bench_attached))
+    {
+    }
+
+    for (uint32_t i = 0; i < BENCH_HANDOVERS; i++)
+    {
+        atomic_store(&bench_waiting, true);
+        if (bench_receive(path, portMAX_DELAY))
+        {
+            atomic_store(&bench_received_ns, bench_now_ns());
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: compare_u64
+ ******************************************************************************
+ * Summary:
+ *  qsort() comparison of two 64-bit values.
+ *
+ * Parameters:
+ *  const void *a : First value
+ *  const void *b : Second value
+ *
+ * Return:
+ *  int : Negative, zero or positive as 'a' is less, equal or greater
+ *
+ ******************************************************************************/
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/******************************************************************************
+ * Function Name: time_handover
+ ******************************************************************************
+ * Summary:
+ *  Measures the latency from the start of the MQTT callback until a waiting
+ *  actuator task holds the command, one command at a time. The actuator
+ *  runs in a thread of its own, attached to a topic of its own.
+ *
+ * Parameters:
+ *  const bench_path_t *path : Delivery path
+ *  uint64_t *median_ns : Receives the median latency
+ *  uint64_t *p99_ns : Receives the 99th percentile
+ *
+ * Return:
+ *  bool : true if the actuator could be attached
+ *
+ ******************************************************************************/
+static bool time_handover(const bench_path_t *path, uint64_t *median_ns, uint64_t *p99_ns)
+{
+    static uint64_t samples[BENCH_HANDOVERS];
+    char topic[TOPIC_MAX_LENGTH + 1];
+    bench_path_t handover = *path;
+    TaskHandle_t actuator;
+    pthread_t thread;
+
+    snprintf(topic, sizeof(topic), "%s/task", path->topic);
+    handover.topic = topic;
+
+    atomic_store(&bench_actuator, NULL);
+    atomic_store(&bench_attached, false);
+    atomic_store(&bench_waiting, false);
+    pthread_create(&thread, NULL, actuator_thread, &handover);
+    while ((actuator = atomic_load(&bench_actuator)) == NULL)
+    {
+    }
+
+    if (add_storage_for_topic(handover.topic, strlen(handover.topic), actuator,
+                              &handover.config) == NULL)
+    {
+        pthread_cancel(thread);
+        return false;
+    }
+    atomic_store(&bench_attached, true);
+
+    for (uint32_t i = 0; i < BENCH_HANDOVERS; i++)
+    {
+        /* Give the actuator time to block on its storage again */
+        while (!atomic_exchange(&bench_waiting, false))
+        {
+        }
+        usleep(20);
+
+        atomic_store(&bench_received_ns, 0);
+        uint64_t sent = bench_now_ns();
+        bench_deliver(&handover);
+        while (atomic_load(&bench_received_ns) == 0)
+        {
+        }
+        samples[i] = atomic_load(&bench_received_ns) - sent;
+    }
+
+    pthread_join(thread, NULL);
+    qsort(samples, BENCH_HANDOVERS, sizeof(samples[0]), compare_u64);
+    *median_ns = samples[BENCH_HANDOVERS / 2u];
+    *p99_ns = samples[(BENCH_HANDOVERS * 99u) / 100u];
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Compares the delivery of a one-byte actuator command through a queue of
+ *  message pool blocks, through a mailbox and through a task notification
+ *  value: the storage reserved per actuator, the time spent in the MQTT
+ *  callback and in the receiving task, and the latency until a waiting
+ *  task holds the command.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  int : 0 on success
+ *
+ ******************************************************************************/
+int main(void)
+{
+    printf("Actuator command \"%s\": storage in bytes, time in ns\n", BENCH_PAYLOAD);
+    printf("%8s %8s %10s %10s %12s %12s\n", "path", "storage", "callback", "receive",
+           "latency p50", "latency p99");
+
+    for (size_t i = 0; i < sizeof(bench_paths) / sizeof(bench_paths[0]); i++)
+    {
+        const bench_path_t *path = &bench_paths[i];
+        double callback_ns = 0.0;
+        double receive_ns = 0.0;
+        uint64_t median_ns;
+        uint64_t p99_ns;
+
+        if (!bench_attach(path) || !time_path(path, &callback_ns, &receive_ns) ||
+            !time_handover(path, &median_ns, &p99_ns))
+        {
+            printf("Delivery through the %s failed\n", path->name);
+            return 1;
+        }
+
+        printf("%8s %8zu %10.1f %10.1f %12llu %12llu\n", path->name,
+               topic_storage_size(&path->config), callback_ns, receive_ns,
+               (unsigned long long) median_ns, (unsigned long long) p99_ns);
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: PublishMessage
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  const char* data : Payload
+ *  const char* topic : Topic
+ *
+ * Return:
+ *  bool : true
+ *
+ ******************************************************************************/
+bool PublishMessage(const char* data, const char* topic)
+{
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: publisher_tx_peak
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  size_t : 0
+ *
+ ******************************************************************************/
+size_t publisher_tx_peak(void)
+{
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publish_rate_limit_diagnostics(void)
+{
+}
+
+/******************************************************************************
+ * Function Name: publish_lane_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the publisher task, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publish_lane_diagnostics(void)
+{
+}
+
+/******************************************************************************
+ * Function Name: link_quality_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for link_quality.c, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void link_quality_diagnostics(void)
+{
+}
+
+/******************************************************************************
+ * Function Name: wire_stats_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for wire_stats.c, which the benchmark does not measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void wire_stats_diagnostics(void)
+{
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,218 @@
+/******************************************************************************
+* File Name:   bench_registry.c
+*
+* Description: This file contains the host benchmark of the topic registry:
+*              lookup time of topic_registry_find() against the linear
+*              strcmp() scan it replaced, for a given number of registered
+*              topics.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "topic_registry.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Lookups timed per measurement. */
+#define BENCH_LOOKUPS                   (2000000u)
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* Topic names of the run, and the names looked up for misses. */
+static char **bench_topics;
+static char **bench_missing;
+
+/******************************************************************************
+ * Function Name: linear_find
+ ******************************************************************************
+ * Summary:
+ *  Lookup of the original get_queue_for_topic(): strcmp() on every
+ *  registered topic in turn. The original also walked the unused slots up to
+ *  'topic_capacity'; only the registered topics are compared here.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name
+ *  size_t count : Number of registered topics
+ *
+ * Return:
+ *  const char * : Registered name, NULL if not found
+ *
+ ******************************************************************************/
+static const char *linear_find(const char *topic, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strcmp(bench_topics[i], topic) == 0)
+        {
+            return bench_topics[i];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: time_lookups
+ ******************************************************************************
+ * Summary:
+ *  Times 'BENCH_LOOKUPS' lookups cycling through a set of names, with the
+ *  registry or with the linear scan.
+ *
+ * Parameters:
+ *  char **names : Names to look up
+ *  size_t name_count : Number of names
+ *  size_t topic_count : Number of registered topics
+ *  int linear : Non-zero for the linear scan
+ *
+ * Return:
+ *  double : Fastest time per lookup in nanoseconds
+ *
+ ******************************************************************************/
+static double time_lookups(char **names, size_t name_count, size_t topic_count, int linear)
+{
+    size_t *lens = malloc(name_count * sizeof(size_t));
+    double best = 0.0;
+
+    for (size_t i = 0; i < name_count; i++)
+    {
+        lens[i] = strlen(names[i]);
+    }
+
+    for (uint32_t repeat = 0; repeat < BENCH_REPEAT; repeat++)
+    {
+        uint64_t start = bench_now_ns();
+        size_t n = 0;
+
+        for (uint32_t i = 0; i < BENCH_LOOKUPS; i++)
+        {
+            if (linear)
+            {
+                bench_sink += (uintptr_t) linear_find(names[n], topic_count);
+            }
+            else
+            {
+                bench_sink += (uintptr_t) topic_registry_find(names[n], lens[n]);
+            }
+            n = (n + 1u == name_count) ? 0u : n + 1u;
+        }
+
+        double ns = (double) (bench_now_ns() - start) / BENCH_LOOKUPS;
+        if ((repeat == 0) || (ns < best))
+        {
+            best = ns;
+        }
+    }
+
+    free(lens);
+    return best;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Registers the topic counts given on the command line one after the other
+ *  and prints the lookup time of the registry and of the linear scan, for
+ *  registered (hit) and unregistered (miss) topics. The registry of the
+ *  binary must have room for the largest count.
+ *
+ * Parameters:
+ *  int argc : Argument count
+ *  char *argv[] : Topic counts, ascending
+ *
+ * Return:
+ *  int : 0 on success
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    const topic_config_t config = { TOPIC_STORAGE_QUEUE, TOPIC_OVERFLOW_DROP_NEWEST, 10u, 128u, NULL };
+    size_t registered = 0;
+
+    bench_topics = calloc(TOPIC_REGISTRY_MAX_TOPICS, sizeof(char *));
+    bench_missing = calloc(TOPIC_REGISTRY_MAX_TOPICS, sizeof(char *));
+
+    printf("Topic registry, %u slots: ns per lookup\n", (unsigned) TOPIC_REGISTRY_SLOTS);
+    printf("%8s %12s %12s %12s %12s\n", "topics", "hash hit", "hash miss", "linear hit", "linear miss");
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        size_t count = (size_t) strtoul(argv[arg], NULL, 10);
+
+        if ((count == 0) || (count > TOPIC_REGISTRY_MAX_TOPICS) || (count < registered))
+        {
+            printf("%8zu skipped, the registry holds up to %u topics\n", count,
+                   (unsigned) TOPIC_REGISTRY_MAX_TOPICS);
+            continue;
+        }
+
+        /* Names shaped like the topics of the application. */
+        for (; registered < count; registered++)
+        {
+            char name[TOPIC_MAX_LENGTH + 1];
+
+            snprintf(name, sizeof(name), "device%zu/sensor/%zu", registered / 8u, registered);
+            bench_topics[registered] = strdup(name);
+            snprintf(name, sizeof(name), "device%zu/actuator/%zu", registered / 8u, registered);
+            bench_missing[registered] = strdup(name);
+
+            if (topic_registry_add(bench_topics[registered], strlen(bench_topics[registered]),
+                                   &config) == NULL)
+            {
+                printf("Registering %s failed\n", bench_topics[registered]);
+                return 1;
+            }
+        }
+
+        printf("%8zu %12.1f %12.1f %12.1f %12.1f\n", count,
+               time_lookups(bench_topics, count, count, 0),
+               time_lookups(bench_missing, count, count, 0),
+               time_lookups(bench_topics, count, count, 1),
+               time_lookups(bench_missing, count, count, 1));
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,312 @@
+/******************************************************************************
+* File Name:   bench_window.c
+*
+* Description: This file contains the host benchmark of the publish window:
+*              the QoS 1 publish throughput of the publisher tasks
+*              (publisher_task.c, built as is) against a broker stand-in that
+*              acknowledges each PUBLISH after an injected round trip time. It
+*              is built once with a window of one publisher task and once with
+*              PUBLISH_WINDOW_SIZE tasks.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "publisher_task.h"
+#include "cy_mqtt_api.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Messages published per round trip time. */
+#define BENCH_MESSAGES                  (150u)
+
+/* Topics the messages are spread over. The messages of a topic are published
+ * one after the other, so the window needs several topics to fill up.
+ */
+#define BENCH_TOPICS                    (8u)
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+volatile uintptr_t bench_sink;
+
+/* Topics of the messages, as the sensor tasks use one topic each. */
+static const char *const bench_topics[BENCH_TOPICS] =
+{
+    "bench/0", "bench/1", "bench/2", "bench/3", "bench/4", "bench/5", "bench/6", "bench/7"
+};
+
+/******************************************************************************
+ * Function Name: publisher_thread
+ ******************************************************************************
+ * Summary:
+ *  Runs one of the 'PUBLISH_WINDOW_SIZE' publisher tasks.
+ *
+ * Parameters:
+ *  void *arg : Unused
+ *
+ * Return:
+ *  void * : Never returns
+ *
+ ******************************************************************************/
+static void *publisher_thread(void *arg)
+{
+    publisher_task(NULL);
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: time_window
+ ******************************************************************************
+ * Summary:
+ *  Hands 'BENCH_MESSAGES' QoS 1 messages to the publisher tasks as fast as
+ *  publish slots free up, and measures the time until the broker stand-in has
+ *  acknowledged all of them. Messages go through publisher_replay(), so none
+ *  is coalesced with a queued message of its topic.
+ *
+ * Parameters:
+ *  uint32_t rtt_ms : PUBACK round trip injected into cy_mqtt_publish()
+ *  unsigned int *peak : Receives the most publishes in flight at once
+ *
+ * Return:
+ *  double : Messages acknowledged per second
+ *
+ ******************************************************************************/
+static double time_window(uint32_t rtt_ms, unsigned int *peak)
+{
+    char payload[12];
+
+    mqtt_host_publish_rtt_us = rtt_ms * 1000u;
+    atomic_store(&mqtt_host_publish_count, 0u);
+    atomic_store(&mqtt_host_publish_peak, 0u);
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_MESSAGES; i++)
+    {
+        int len = snprintf(payload, sizeof(payload), "%lu", (unsigned long) i);
+
+        /* Every slot is in use until a publish is acknowledged. */
+        while (!publisher_replay(payload, (size_t) len, bench_topics[i % BENCH_TOPICS], false))
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    while (atomic_load(&mqtt_host_publish_count) < BENCH_MESSAGES)
+    {
+        vTaskDelay(1);
+    }
+    double seconds = (double) (bench_now_ns() - start) / 1e9;
+
+    *peak = atomic_load(&mqtt_host_publish_peak);
+    return BENCH_MESSAGES / seconds;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Prints the QoS 1 publish throughput of the publisher for each PUBACK round
+ *  trip time given in milliseconds on the command line, with the window of
+ *  'PUBLISH_WINDOW_SIZE' publisher tasks it was built with.
+ *
+ * Parameters:
+ *  int argc : Argument count
+ *  char *argv[] : Round trip times in milliseconds
+ *
+ * Return:
+ *  int : 0 on success
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    pthread_t thread;
+
+    if (!publisher_create_queues())
+    {
+        printf("Failed to create the publisher queues\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < PUBLISH_WINDOW_SIZE; i++)
+    {
+        pthread_create(&thread, NULL, publisher_thread, NULL);
+        pthread_detach(thread);
+    }
+
+    printf("Publish window %u, %u QoS 1 messages on %u topics\n", (unsigned) PUBLISH_WINDOW_SIZE,
+           (unsigned) BENCH_MESSAGES, (unsigned) BENCH_TOPICS);
+    printf("%8s %10s %10s %10s\n", "RTT ms", "msgs/s", "ceiling", "in flight");
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        uint32_t rtt_ms = (uint32_t) strtoul(argv[arg], NULL, 10);
+        unsigned int peak;
+
+        if (rtt_ms == 0)
+        {
+            continue;
+        }
+
+        double rate = time_window(rtt_ms, &peak);
+        printf("%8lu %10.1f %10.1f %10u\n", (unsigned long) rtt_ms, rate,
+               PUBLISH_WINDOW_SIZE * 1000.0 / rtt_ms, peak);
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: mqtt_is_connected
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the MQTT client task: the broker is always reachable.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : true
+ *
+ ******************************************************************************/
+bool mqtt_is_connected(void)
+{
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: outbox_store
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the outbox, which no successful publish uses.
+ *
+ * Parameters:
+ *  const char *topic : Topic name
+ *  size_t topic_len : Length of the topic name
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *
+ * Return:
+ *  bool : false, nothing is stored
+ *
+ ******************************************************************************/
+bool outbox_store(const char *topic, size_t topic_len, const void *payload,
+                  size_t payload_len)
+{
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_publish_begin
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the link quality estimator, which the benchmark does not
+ *  measure.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  int : -1, the publish is not sampled
+ *
+ ******************************************************************************/
+int link_quality_publish_begin(void)
+{
+    return -1;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_publish_end
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the link quality estimator.
+ *
+ * Parameters:
+ *  int handle : Handle returned by link_quality_publish_begin()
+ *  bool acknowledged : Whether the publish was acknowledged
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void link_quality_publish_end(int handle, bool acknowledged)
+{
+}
+
+/******************************************************************************
+ * Function Name: wire_stats_publish
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the wire statistics.
+ *
+ * Parameters:
+ *  const char *topic : Topic name
+ *  size_t topic_len : Length of the topic name
+ *  size_t payload_len : Length of the payload
+ *  bool qos0 : Whether the publish is QoS 0
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void wire_stats_publish(const char *topic, size_t topic_len, size_t payload_len, bool qos0)
+{
+}
+
+/******************************************************************************
+ * Function Name: print_heap_usage
+ ******************************************************************************
+ * Summary:
+ *  Stand-in for the heap report of main.c.
+ *
+ * Parameters:
+ *  char *msg : Message of the report
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void print_heap_usage(char *msg)
+{
+}
+
+/* [] END OF FILE */
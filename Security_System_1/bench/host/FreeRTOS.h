@@ -0,0 +1,98 @@
+/******************************************************************************
+* File Name:   FreeRTOS.h
+*
+* Description: Host stand-in for the FreeRTOS kernel header, used by the
+*              benchmarks in bench/. Only what the benchmarked sources use is
+*              declared.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Same tick rate as configs/COMPONENT_CM4/FreeRTOSConfig.h. */
+#define configTICK_RATE_HZ                 (1000u)
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES (4)
+#define configTOTAL_HEAP_SIZE              (10240)
+#define configASSERT(x)                    do { if (!(x)) { abort(); } } while (0)
+
+#define portTICK_PERIOD_MS                 ((TickType_t) 1000u / configTICK_RATE_HZ)
+#define portMAX_DELAY                      ((TickType_t) 0xFFFFFFFFu)
+
+#define pdFALSE                            ((BaseType_t) 0)
+#define pdTRUE                             ((BaseType_t) 1)
+#define pdFAIL                             (pdFALSE)
+#define pdPASS                             (pdTRUE)
+#define errQUEUE_FULL                      ((BaseType_t) 0)
+
+#define pdMS_TO_TICKS(ms)                  ((TickType_t) (((TickType_t) (ms) * configTICK_RATE_HZ) / 1000u))
+#define pdTICKS_TO_MS(ticks)               ((TickType_t) (((TickType_t) (ticks) * 1000u) / configTICK_RATE_HZ))
+
+/* Critical sections are one process-wide recursive lock. */
+#define taskENTER_CRITICAL()               vPortEnterCritical()
+#define taskEXIT_CRITICAL()                vPortExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR()      (vPortEnterCritical(), 0u)
+#define taskEXIT_CRITICAL_FROM_ISR(x)      ((void) (x), vPortExitCritical())
+#define portYIELD_FROM_ISR(x)              ((void) (x))
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#endif /* INC_FREERTOS_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,98 @@
+/******************************************************************************
+* File Name:   cyhal.h
+*
+* Description: Host stand-in for the GPIO functions of the HAL, see
+*              mqtt_host.c.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef CYHAL_H
+#define CYHAL_H
+
+#include <stdbool.h>
+
+#include "cy_mqtt_api.h"
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+typedef int cyhal_gpio_t;
+
+typedef enum
+{
+    CYHAL_GPIO_IRQ_NONE = 0,
+    CYHAL_GPIO_IRQ_RISE = 1,
+    CYHAL_GPIO_IRQ_FALL = 2,
+    CYHAL_GPIO_IRQ_BOTH = 3
+} cyhal_gpio_event_t;
+
+typedef void (*cyhal_gpio_event_callback_t)(void *callback_arg, cyhal_gpio_event_t event);
+
+/* Callback of a pin interrupt, never raised on the host. */
+typedef struct
+{
+    cyhal_gpio_event_callback_t callback;
+    void *callback_arg;
+} cyhal_gpio_callback_data_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+/* Cortex-M intrinsics, brought in by the HAL on the target. */
+static inline uint32_t __CLZ(uint32_t value)
+{
+    return (value == 0u) ? 32u : (uint32_t) __builtin_clz(value);
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t reversed = 0;
+
+    for (uint32_t bit = 0; bit < 32u; bit++)
+    {
+        reversed = (reversed << 1) | ((value >> bit) & 1u);
+    }
+
+    return reversed;
+}
+
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, int direction, int drive_mode, bool init_val);
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value);
+
+#endif /* CYHAL_H */
+
+/* [] END OF FILE */
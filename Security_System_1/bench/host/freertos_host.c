@@ -0,0 +1,1054 @@
+/******************************************************************************
+* File Name:   freertos_host.c
+*
+* Description: This file implements the FreeRTOS functions used by the
+*              benchmarked sources on top of the C library and POSIX threads
+*              of the host, so that the application sources can be built and
+*              measured on a PC.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "message_buffer.h"
+#include "semphr.h"
+#include "timers.h"
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Notification array of a task. */
+struct host_task
+{
+    pthread_mutex_t lock;
+    pthread_cond_t notified;
+    uint32_t value[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    bool pending[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+};
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Lock taken by taskENTER_CRITICAL(), recursive and created on first use. */
+static pthread_mutex_t host_critical;
+static pthread_once_t host_critical_once = PTHREAD_ONCE_INIT;
+
+/* Task of the calling thread, created by xTaskGetCurrentTaskHandle(). */
+static __thread struct host_task *host_current_task = NULL;
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static void host_critical_init(void);
+static void host_lock_init(pthread_mutex_t *lock, pthread_cond_t *cond);
+static bool host_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t wait,
+                      const struct timespec *deadline);
+static void host_deadline(TickType_t wait, struct timespec *deadline);
+
+/******************************************************************************
+ * Function Name: pvPortMalloc
+ ******************************************************************************
+ * Summary:
+ *  Allocates from the heap of the host.
+ *
+ * Parameters:
+ *  size_t size : Bytes to allocate
+ *
+ * Return:
+ *  void * : Allocated block, NULL if none
+ *
+ ******************************************************************************/
+void *pvPortMalloc(size_t size)
+{
+    return malloc(size);
+}
+
+/******************************************************************************
+ * Function Name: vPortFree
+ ******************************************************************************
+ * Summary:
+ *  Frees a block allocated by pvPortMalloc().
+ *
+ * Parameters:
+ *  void *ptr : Block to free
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+/******************************************************************************
+ * Function Name: vPortEnterCritical
+ ******************************************************************************
+ * Summary:
+ *  Enters a critical section. Nests like the one of the Cortex-M port.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vPortEnterCritical(void)
+{
+    pthread_once(&host_critical_once, host_critical_init);
+    pthread_mutex_lock(&host_critical);
+}
+
+/******************************************************************************
+ * Function Name: vPortExitCritical
+ ******************************************************************************
+ * Summary:
+ *  Leaves a critical section.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vPortExitCritical(void)
+{
+    pthread_mutex_unlock(&host_critical);
+}
+
+/******************************************************************************
+ * Function Name: xTaskGetTickCount
+ ******************************************************************************
+ * Summary:
+ *  Returns the milliseconds elapsed on the monotonic clock of the host, i.e.
+ *  ticks at 'configTICK_RATE_HZ'.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  TickType_t : Tick count
+ *
+ ******************************************************************************/
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t) ((uint64_t) now.tv_sec * configTICK_RATE_HZ +
+                         (uint64_t) now.tv_nsec / (1000000000u / configTICK_RATE_HZ));
+}
+
+/******************************************************************************
+ * Function Name: xTaskGetCurrentTaskHandle
+ ******************************************************************************
+ * Summary:
+ *  Returns the task of the calling thread, created on the first call.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  TaskHandle_t : Task of the calling thread
+ *
+ ******************************************************************************/
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (host_current_task == NULL)
+    {
+        host_current_task = calloc(1, sizeof(struct host_task));
+        configASSERT(host_current_task != NULL);
+        host_lock_init(&host_current_task->lock, &host_current_task->notified);
+    }
+
+    return host_current_task;
+}
+
+/******************************************************************************
+ * Function Name: vTaskDelay
+ ******************************************************************************
+ * Summary:
+ *  Puts the calling thread to sleep.
+ *
+ * Parameters:
+ *  TickType_t ticks : Ticks to sleep
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec delay =
+    {
+        .tv_sec = ticks / configTICK_RATE_HZ,
+        .tv_nsec = (long) (ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ)
+    };
+
+    nanosleep(&delay, NULL);
+}
+
+/******************************************************************************
+ * Function Name: xTaskNotifyIndexed
+ ******************************************************************************
+ * Summary:
+ *  Updates a notification value of a task and wakes it up if it waits for it.
+ *
+ * Parameters:
+ *  TaskHandle_t task : Task to notify
+ *  UBaseType_t index : Index in the notification array
+ *  uint32_t value : Value used by 'action'
+ *  eNotifyAction action : How the notification value is updated
+ *
+ * Return:
+ *  BaseType_t : pdFAIL if the action is eSetValueWithoutOverwrite and a
+ *               notification is still pending, else pdPASS
+ *
+ ******************************************************************************/
+BaseType_t xTaskNotifyIndexed(TaskHandle_t task, UBaseType_t index, uint32_t value,
+                              eNotifyAction action)
+{
+    BaseType_t result = pdPASS;
+
+    pthread_mutex_lock(&task->lock);
+    switch (action)
+    {
+        case eSetBits:
+            task->value[index] |= value;
+            break;
+
+        case eIncrement:
+            task->value[index]++;
+            break;
+
+        case eSetValueWithOverwrite:
+            task->value[index] = value;
+            break;
+
+        case eSetValueWithoutOverwrite:
+            if (task->pending[index])
+            {
+                result = pdFAIL;
+            }
+            else
+            {
+                task->value[index] = value;
+            }
+            break;
+
+        case eNoAction:
+        default:
+            break;
+    }
+
+    if (result == pdPASS)
+    {
+        task->pending[index] = true;
+        pthread_cond_broadcast(&task->notified);
+    }
+    pthread_mutex_unlock(&task->lock);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: xTaskNotifyWaitIndexed
+ ******************************************************************************
+ * Summary:
+ *  Waits for a notification of the calling task.
+ *
+ * Parameters:
+ *  UBaseType_t index : Index in the notification array
+ *  uint32_t clear_on_entry : Bits cleared before waiting
+ *  uint32_t clear_on_exit : Bits cleared after a notification
+ *  uint32_t *value : Receives the notification value, may be NULL
+ *  TickType_t wait : Ticks to wait
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if a notification was received, pdFALSE on timeout
+ *
+ ******************************************************************************/
+BaseType_t xTaskNotifyWaitIndexed(UBaseType_t index, uint32_t clear_on_entry,
+                                  uint32_t clear_on_exit, uint32_t *value, TickType_t wait)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    BaseType_t result = pdFALSE;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&task->lock);
+    if (!task->pending[index])
+    {
+        task->value[index] &= ~clear_on_entry;
+    }
+    while (!task->pending[index] && host_wait(&task->notified, &task->lock, wait, &deadline))
+    {
+    }
+
+    if (value != NULL)
+    {
+        *value = task->value[index];
+    }
+    if (task->pending[index])
+    {
+        task->value[index] &= ~clear_on_exit;
+        task->pending[index] = false;
+        result = pdTRUE;
+    }
+    pthread_mutex_unlock(&task->lock);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: ulTaskNotifyTakeIndexed
+ ******************************************************************************
+ * Summary:
+ *  Waits for the notification value of the calling task to be non-zero and
+ *  decrements or clears it.
+ *
+ * Parameters:
+ *  UBaseType_t index : Index in the notification array
+ *  BaseType_t clear_on_exit : pdTRUE to clear the value, pdFALSE to decrement it
+ *  TickType_t wait : Ticks to wait
+ *
+ * Return:
+ *  uint32_t : Notification value before it was decremented or cleared
+ *
+ ******************************************************************************/
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear_on_exit, TickType_t wait)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    uint32_t value;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&task->lock);
+    while ((task->value[index] == 0) && host_wait(&task->notified, &task->lock, wait, &deadline))
+    {
+    }
+
+    value = task->value[index];
+    if (value != 0)
+    {
+        task->value[index] = (clear_on_exit != pdFALSE) ? 0 : (value - 1u);
+    }
+    task->pending[index] = false;
+    pthread_mutex_unlock(&task->lock);
+
+    return value;
+}
+
+/******************************************************************************
+ * Function Name: xTaskNotifyStateClearIndexed
+ ******************************************************************************
+ * Summary:
+ *  Clears a pending notification without changing its value.
+ *
+ * Parameters:
+ *  TaskHandle_t task : Task, NULL for the calling task
+ *  UBaseType_t index : Index in the notification array
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if a notification was pending
+ *
+ ******************************************************************************/
+BaseType_t xTaskNotifyStateClearIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    BaseType_t result;
+
+    if (task == NULL)
+    {
+        task = xTaskGetCurrentTaskHandle();
+    }
+
+    pthread_mutex_lock(&task->lock);
+    result = task->pending[index] ? pdTRUE : pdFALSE;
+    task->pending[index] = false;
+    pthread_mutex_unlock(&task->lock);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: xQueueCreate
+ ******************************************************************************
+ * Summary:
+ *  Creates a queue.
+ *
+ * Parameters:
+ *  UBaseType_t length : Number of items the queue holds
+ *  UBaseType_t item_size : Bytes per item
+ *
+ * Return:
+ *  QueueHandle_t : Queue, NULL if out of memory
+ *
+ ******************************************************************************/
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = pvPortMalloc(sizeof(struct host_queue) + (length * item_size));
+
+    if (queue != NULL)
+    {
+        host_lock_init(&queue->lock, &queue->changed);
+        queue->length = length;
+        queue->item_size = item_size;
+        queue->count = 0;
+        queue->head = 0;
+        queue->items = (uint8_t *) (queue + 1);
+    }
+
+    return queue;
+}
+
+/******************************************************************************
+ * Function Name: vQueueDelete
+ ******************************************************************************
+ * Summary:
+ *  Deletes a queue no thread waits on.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    vPortFree(queue);
+}
+
+/******************************************************************************
+ * Function Name: xQueueSendToBack
+ ******************************************************************************
+ * Summary:
+ *  Copies an item to the back of a queue, waiting for space if it is full.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue
+ *  const void *item : Item to copy
+ *  TickType_t wait : Ticks to wait for space
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if the item was sent, errQUEUE_FULL on timeout
+ *
+ ******************************************************************************/
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    struct timespec deadline;
+    BaseType_t result = errQUEUE_FULL;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while ((queue->count == queue->length) &&
+           host_wait(&queue->changed, &queue->lock, wait, &deadline))
+    {
+    }
+
+    if (queue->count < queue->length)
+    {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        if (queue->item_size != 0)
+        {
+            memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+        }
+        queue->count++;
+        pthread_cond_broadcast(&queue->changed);
+        result = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: xQueueOverwrite
+ ******************************************************************************
+ * Summary:
+ *  Writes the item of a queue of length one, whether it is full or not.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue of length one
+ *  const void *item : Item to copy
+ *
+ * Return:
+ *  BaseType_t : pdPASS
+ *
+ ******************************************************************************/
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    pthread_mutex_lock(&queue->lock);
+    memcpy(queue->items, item, queue->item_size);
+    queue->head = 0;
+    queue->count = 1;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdPASS;
+}
+
+/******************************************************************************
+ * Function Name: xQueueReceive
+ ******************************************************************************
+ * Summary:
+ *  Copies the item at the front of a queue out and removes it, waiting for
+ *  one if the queue is empty.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue
+ *  void *item : Receives the item
+ *  TickType_t wait : Ticks to wait for an item
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if an item was received, pdFALSE on timeout
+ *
+ ******************************************************************************/
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    struct timespec deadline;
+    BaseType_t result = pdFALSE;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while ((queue->count == 0) && host_wait(&queue->changed, &queue->lock, wait, &deadline))
+    {
+    }
+
+    if (queue->count != 0)
+    {
+        if (queue->item_size != 0)
+        {
+            memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+        }
+        queue->head = (queue->head + 1u) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->changed);
+        result = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: uxQueueMessagesWaiting
+ ******************************************************************************
+ * Summary:
+ *  Returns the number of items in a queue.
+ *
+ * Parameters:
+ *  QueueHandle_t queue : Queue
+ *
+ * Return:
+ *  UBaseType_t : Number of items
+ *
+ ******************************************************************************/
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    UBaseType_t count;
+
+    pthread_mutex_lock(&queue->lock);
+    count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+
+    return count;
+}
+
+/******************************************************************************
+ * Function Name: xSemaphoreCreateCounting
+ ******************************************************************************
+ * Summary:
+ *  Creates a counting semaphore, a queue of items without data as in
+ *  FreeRTOS.
+ *
+ * Parameters:
+ *  UBaseType_t max_count : Highest count
+ *  UBaseType_t initial_count : Count on creation
+ *
+ * Return:
+ *  SemaphoreHandle_t : Semaphore, NULL if out of memory
+ *
+ ******************************************************************************/
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SemaphoreHandle_t semaphore = xQueueCreate(max_count, 0);
+
+    for (UBaseType_t i = 0; (semaphore != NULL) && (i < initial_count); i++)
+    {
+        xSemaphoreGive(semaphore);
+    }
+
+    return semaphore;
+}
+
+/******************************************************************************
+ * Function Name: xTimerCreate
+ ******************************************************************************
+ * Summary:
+ *  Creates a software timer. Host timers never expire: no benchmark waits
+ *  for one, they only need to exist.
+ *
+ * Parameters:
+ *  const char *name : Name of the timer
+ *  TickType_t period : Period in ticks
+ *  UBaseType_t auto_reload : pdTRUE to restart the timer when it expires
+ *  void *id : Identifier of the timer
+ *  TimerCallbackFunction_t callback : Function called when the timer expires
+ *
+ * Return:
+ *  TimerHandle_t : Timer, NULL if out of memory
+ *
+ ******************************************************************************/
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *id, TimerCallbackFunction_t callback)
+{
+    TimerHandle_t timer = pvPortMalloc(sizeof(struct host_timer));
+
+    if (timer != NULL)
+    {
+        timer->id = id;
+        timer->active = false;
+    }
+
+    return timer;
+}
+
+/******************************************************************************
+ * Function Name: xTimerChangePeriod
+ ******************************************************************************
+ * Summary:
+ *  Changes the period of a timer and starts it.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Timer
+ *  TickType_t period : New period in ticks
+ *  TickType_t wait : Ticks to wait for the timer command queue
+ *
+ * Return:
+ *  BaseType_t : pdPASS
+ *
+ ******************************************************************************/
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait)
+{
+    timer->active = true;
+    return pdPASS;
+}
+
+/******************************************************************************
+ * Function Name: xTimerDelete
+ ******************************************************************************
+ * Summary:
+ *  Deletes a timer.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Timer
+ *  TickType_t wait : Ticks to wait for the timer command queue
+ *
+ * Return:
+ *  BaseType_t : pdPASS
+ *
+ ******************************************************************************/
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t wait)
+{
+    vPortFree(timer);
+    return pdPASS;
+}
+
+/******************************************************************************
+ * Function Name: xTimerIsTimerActive
+ ******************************************************************************
+ * Summary:
+ *  Tells whether a timer was started.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Timer
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if the timer was started, else pdFALSE
+ *
+ ******************************************************************************/
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    return timer->active ? pdTRUE : pdFALSE;
+}
+
+/******************************************************************************
+ * Function Name: pvTimerGetTimerID
+ ******************************************************************************
+ * Summary:
+ *  Returns the identifier of a timer.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Timer
+ *
+ * Return:
+ *  void * : Identifier
+ *
+ ******************************************************************************/
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+/******************************************************************************
+ * Function Name: vTimerSetTimerID
+ ******************************************************************************
+ * Summary:
+ *  Sets the identifier of a timer.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Timer
+ *  void *id : Identifier
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vTimerSetTimerID(TimerHandle_t timer, void *id)
+{
+    timer->id = id;
+}
+
+/******************************************************************************
+ * Function Name: xMessageBufferCreate
+ ******************************************************************************
+ * Summary:
+ *  Creates a message buffer.
+ *
+ * Parameters:
+ *  size_t size : Bytes of the buffer, length prefixes included
+ *
+ * Return:
+ *  MessageBufferHandle_t : Message buffer, NULL if out of memory
+ *
+ ******************************************************************************/
+MessageBufferHandle_t xMessageBufferCreate(size_t size)
+{
+    MessageBufferHandle_t buffer = pvPortMalloc(sizeof(struct host_message_buffer) + size);
+
+    if (buffer != NULL)
+    {
+        host_lock_init(&buffer->lock, &buffer->changed);
+        buffer->size = size;
+        buffer->used = 0;
+        buffer->data = (uint8_t *) (buffer + 1);
+    }
+
+    return buffer;
+}
+
+/******************************************************************************
+ * Function Name: vMessageBufferDelete
+ ******************************************************************************
+ * Summary:
+ *  Deletes a message buffer no thread waits on.
+ *
+ * Parameters:
+ *  MessageBufferHandle_t buffer : Message buffer
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void vMessageBufferDelete(MessageBufferHandle_t buffer)
+{
+    pthread_cond_destroy(&buffer->changed);
+    pthread_mutex_destroy(&buffer->lock);
+    vPortFree(buffer);
+}
+
+/******************************************************************************
+ * Function Name: xMessageBufferSend
+ ******************************************************************************
+ * Summary:
+ *  Copies a message to a message buffer, waiting for space if needed.
+ *
+ * Parameters:
+ *  MessageBufferHandle_t buffer : Message buffer
+ *  const void *data : Message
+ *  size_t length : Bytes of the message
+ *  TickType_t wait : Ticks to wait for space
+ *
+ * Return:
+ *  size_t : Bytes written, 0 on timeout
+ *
+ ******************************************************************************/
+size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void *data, size_t length,
+                          TickType_t wait)
+{
+    const size_t needed = sizeof(configMESSAGE_BUFFER_LENGTH_TYPE) + length;
+    struct timespec deadline;
+    size_t written = 0;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&buffer->lock);
+    while ((buffer->size - buffer->used < needed) && (needed <= buffer->size) &&
+           host_wait(&buffer->changed, &buffer->lock, wait, &deadline))
+    {
+    }
+
+    if (buffer->size - buffer->used >= needed)
+    {
+        configMESSAGE_BUFFER_LENGTH_TYPE prefix = length;
+        memcpy(&buffer->data[buffer->used], &prefix, sizeof(prefix));
+        memcpy(&buffer->data[buffer->used + sizeof(prefix)], data, length);
+        buffer->used += needed;
+        pthread_cond_broadcast(&buffer->changed);
+        written = length;
+    }
+    pthread_mutex_unlock(&buffer->lock);
+
+    return written;
+}
+
+/******************************************************************************
+ * Function Name: xMessageBufferReceive
+ ******************************************************************************
+ * Summary:
+ *  Copies the oldest message out of a message buffer and removes it, waiting
+ *  for one if the buffer is empty. A message longer than 'max_length' stays
+ *  in the buffer.
+ *
+ * Parameters:
+ *  MessageBufferHandle_t buffer : Message buffer
+ *  void *data : Receives the message
+ *  size_t max_length : Size of 'data'
+ *  TickType_t wait : Ticks to wait for a message
+ *
+ * Return:
+ *  size_t : Bytes of the message, 0 if none was received
+ *
+ ******************************************************************************/
+size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void *data, size_t max_length,
+                             TickType_t wait)
+{
+    configMESSAGE_BUFFER_LENGTH_TYPE length = 0;
+    struct timespec deadline;
+
+    host_deadline(wait, &deadline);
+    pthread_mutex_lock(&buffer->lock);
+    while ((buffer->used == 0) && host_wait(&buffer->changed, &buffer->lock, wait, &deadline))
+    {
+    }
+
+    if (buffer->used != 0)
+    {
+        memcpy(&length, buffer->data, sizeof(length));
+        if (length <= max_length)
+        {
+            size_t consumed = sizeof(length) + length;
+            memcpy(data, &buffer->data[sizeof(length)], length);
+            memmove(buffer->data, &buffer->data[consumed], buffer->used - consumed);
+            buffer->used -= consumed;
+            pthread_cond_broadcast(&buffer->changed);
+        }
+        else
+        {
+            length = 0;
+        }
+    }
+    pthread_mutex_unlock(&buffer->lock);
+
+    return length;
+}
+
+/******************************************************************************
+ * Function Name: xMessageBufferReset
+ ******************************************************************************
+ * Summary:
+ *  Discards the messages of a message buffer.
+ *
+ * Parameters:
+ *  MessageBufferHandle_t buffer : Message buffer
+ *
+ * Return:
+ *  BaseType_t : pdPASS
+ *
+ ******************************************************************************/
+BaseType_t xMessageBufferReset(MessageBufferHandle_t buffer)
+{
+    pthread_mutex_lock(&buffer->lock);
+    buffer->used = 0;
+    pthread_cond_broadcast(&buffer->changed);
+    pthread_mutex_unlock(&buffer->lock);
+
+    return pdPASS;
+}
+
+/******************************************************************************
+ * Function Name: xMessageBufferIsEmpty
+ ******************************************************************************
+ * Summary:
+ *  Checks if a message buffer holds no message.
+ *
+ * Parameters:
+ *  MessageBufferHandle_t buffer : Message buffer
+ *
+ * Return:
+ *  BaseType_t : pdTRUE if the buffer is empty
+ *
+ ******************************************************************************/
+BaseType_t xMessageBufferIsEmpty(MessageBufferHandle_t buffer)
+{
+    BaseType_t empty;
+
+    pthread_mutex_lock(&buffer->lock);
+    empty = (buffer->used == 0) ? pdTRUE : pdFALSE;
+    pthread_mutex_unlock(&buffer->lock);
+
+    return empty;
+}
+
+/******************************************************************************
+ * Function Name: host_critical_init
+ ******************************************************************************
+ * Summary:
+ *  Creates the recursive lock of the critical sections.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void host_critical_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&host_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/******************************************************************************
+ * Function Name: host_lock_init
+ ******************************************************************************
+ * Summary:
+ *  Creates the lock and the condition of a task, queue or message buffer.
+ *  The condition waits on the monotonic clock, like the ticks.
+ *
+ * Parameters:
+ *  pthread_mutex_t *lock : Lock to create
+ *  pthread_cond_t *cond : Condition to create
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void host_lock_init(pthread_mutex_t *lock, pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_mutex_init(lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/******************************************************************************
+ * Function Name: host_deadline
+ ******************************************************************************
+ * Summary:
+ *  Converts a timeout in ticks to a deadline on the monotonic clock.
+ *
+ * Parameters:
+ *  TickType_t wait : Ticks to wait
+ *  struct timespec *deadline : Receives the deadline
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void host_deadline(TickType_t wait, struct timespec *deadline)
+{
+    uint64_t ns;
+
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    ns = (uint64_t) deadline->tv_nsec + ((uint64_t) wait * (1000000000u / configTICK_RATE_HZ));
+    deadline->tv_sec += (time_t) (ns / 1000000000u);
+    deadline->tv_nsec = (long) (ns % 1000000000u);
+}
+
+/******************************************************************************
+ * Function Name: host_wait
+ ******************************************************************************
+ * Summary:
+ *  Waits on a condition until it is signalled or the deadline passes.
+ *
+ * Parameters:
+ *  pthread_cond_t *cond : Condition
+ *  pthread_mutex_t *lock : Lock held by the caller
+ *  TickType_t wait : Ticks to wait, 0 returns at once and portMAX_DELAY
+ *                    waits forever
+ *  const struct timespec *deadline : Deadline from host_deadline()
+ *
+ * Return:
+ *  bool : false if the wait timed out, else true
+ *
+ ******************************************************************************/
+static bool host_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t wait,
+                      const struct timespec *deadline)
+{
+    if (wait == 0)
+    {
+        return false;
+    }
+
+    if (wait == portMAX_DELAY)
+    {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+
+    return (pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,88 @@
+/******************************************************************************
+* File Name:   message_buffer.h
+*
+* Description: Host stand-in for the FreeRTOS message buffer API, see
+*              freertos_host.c.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef INC_MESSAGE_BUFFER_H
+#define INC_MESSAGE_BUFFER_H
+
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Type of the length stored in front of each message, as in FreeRTOS. */
+#define configMESSAGE_BUFFER_LENGTH_TYPE   size_t
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Message buffer: length prefixed messages stored back to back. */
+struct host_message_buffer
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     /* Signalled on every send and receive */
+    size_t size;
+    size_t used;
+    uint8_t *data;
+};
+
+typedef struct host_message_buffer *MessageBufferHandle_t;
+
+/* Control block of a message buffer, what topic_storage_size() accounts for. */
+typedef struct host_message_buffer StaticMessageBuffer_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+MessageBufferHandle_t xMessageBufferCreate(size_t size);
+void vMessageBufferDelete(MessageBufferHandle_t buffer);
+size_t xMessageBufferSend(MessageBufferHandle_t buffer, const void *data, size_t length,
+                          TickType_t wait);
+size_t xMessageBufferReceive(MessageBufferHandle_t buffer, void *data, size_t max_length,
+                             TickType_t wait);
+BaseType_t xMessageBufferReset(MessageBufferHandle_t buffer);
+BaseType_t xMessageBufferIsEmpty(MessageBufferHandle_t buffer);
+
+#endif /* INC_MESSAGE_BUFFER_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,247 @@
+/******************************************************************************
+* File Name:   mqtt_host.c
+*
+* Description: This file implements host stand-ins for the MQTT library, the
+*              GPIO functions of the HAL and the log and trace modules.
+*              Nothing is sent or printed, so that a benchmark measures the
+*              application code alone.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "cyhal.h"
+#include "cy_mqtt_api.h"
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Defined by mqtt_task.c on the target. */
+cy_mqtt_t mqtt_connection = NULL;
+QueueHandle_t mqtt_task_q = NULL;
+
+/* Injected PUBACK round trip and publish counters, see cy_mqtt_api.h. */
+volatile uint32_t mqtt_host_publish_rtt_us = 0;
+atomic_uint mqtt_host_publish_count = 0;
+atomic_uint mqtt_host_publish_peak = 0;
+
+/* Publishes currently blocked in cy_mqtt_publish(). */
+static atomic_uint mqtt_host_in_flight = 0;
+
+/******************************************************************************
+ * Function Name: cy_mqtt_publish
+ ******************************************************************************
+ * Summary:
+ *  Accepts a PUBLISH and returns when the broker would have acknowledged it,
+ *  after 'mqtt_host_publish_rtt_us' microseconds. Concurrent publishes wait
+ *  at the same time, as the MQTT library tracks several outgoing publishes.
+ *
+ * Parameters:
+ *  cy_mqtt_t handle : MQTT connection
+ *  cy_mqtt_publish_info_t *pub_msg : Message to publish
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS
+ *
+ ******************************************************************************/
+cy_rslt_t cy_mqtt_publish(cy_mqtt_t handle, cy_mqtt_publish_info_t *pub_msg)
+{
+    uint32_t rtt_us = mqtt_host_publish_rtt_us;
+    unsigned int in_flight = atomic_fetch_add(&mqtt_host_in_flight, 1u) + 1u;
+    unsigned int peak = atomic_load(&mqtt_host_publish_peak);
+
+    while ((in_flight > peak) &&
+           !atomic_compare_exchange_weak(&mqtt_host_publish_peak, &peak, in_flight))
+    {
+    }
+
+    if (rtt_us != 0)
+    {
+        struct timespec rtt = { .tv_sec = rtt_us / 1000000u,
+                                .tv_nsec = (long) (rtt_us % 1000000u) * 1000L };
+        nanosleep(&rtt, NULL);
+    }
+
+    atomic_fetch_sub(&mqtt_host_in_flight, 1u);
+    atomic_fetch_add(&mqtt_host_publish_count, 1u);
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: cy_mqtt_subscribe
+ ******************************************************************************
+ * Summary:
+ *  Grants every subscription the QoS it requests.
+ *
+ * Parameters:
+ *  cy_mqtt_t handle : MQTT connection
+ *  cy_mqtt_subscribe_info_t *sub_info : Topic filters
+ *  uint8_t sub_count : Number of topic filters
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS
+ *
+ ******************************************************************************/
+cy_rslt_t cy_mqtt_subscribe(cy_mqtt_t handle, cy_mqtt_subscribe_info_t *sub_info,
+                            uint8_t sub_count)
+{
+    for (uint8_t i = 0; i < sub_count; i++)
+    {
+        sub_info[i].allocated_qos = sub_info[i].qos;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: cy_mqtt_unsubscribe
+ ******************************************************************************
+ * Summary:
+ *  Accepts an UNSUBSCRIBE.
+ *
+ * Parameters:
+ *  cy_mqtt_t handle : MQTT connection
+ *  cy_mqtt_unsubscribe_info_t *unsub_info : Topic filters
+ *  uint8_t unsub_count : Number of topic filters
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS
+ *
+ ******************************************************************************/
+cy_rslt_t cy_mqtt_unsubscribe(cy_mqtt_t handle, cy_mqtt_unsubscribe_info_t *unsub_info,
+                              uint8_t unsub_count)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: cyhal_gpio_init
+ ******************************************************************************
+ * Summary:
+ *  Accepts the initialization of a pin.
+ *
+ * Parameters:
+ *  cyhal_gpio_t pin : Pin
+ *  int direction : Direction
+ *  int drive_mode : Drive mode
+ *  bool init_val : Initial level
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS
+ *
+ ******************************************************************************/
+cy_rslt_t cyhal_gpio_init(cyhal_gpio_t pin, int direction, int drive_mode, bool init_val)
+{
+    return CY_RSLT_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: cyhal_gpio_write
+ ******************************************************************************
+ * Summary:
+ *  Ignores the write to a pin.
+ *
+ * Parameters:
+ *  cyhal_gpio_t pin : Pin
+ *  bool value : Level
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void cyhal_gpio_write(cyhal_gpio_t pin, bool value)
+{
+}
+
+/******************************************************************************
+ * Function Name: log_write
+ ******************************************************************************
+ * Summary:
+ *  Discards a log record. The records of log_task.c only cost the formatting
+ *  into its ring buffer, which the benchmarks leave out.
+ *
+ * Parameters:
+ *  int level : Log level
+ *  const char *module : Module prefix
+ *  const char *format : printf() format, followed by its arguments
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void log_write(int level, const char *module, const char *format, ...)
+{
+}
+
+/******************************************************************************
+ * Function Name: trace_log_write
+ ******************************************************************************
+ * Summary:
+ *  Discards a trace record.
+ *
+ * Parameters:
+ *  uint32_t id : Trace event, followed by its arguments
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void trace_log_write(uint32_t id, ...)
+{
+}
+
+/******************************************************************************
+ * Function Name: trace_log_dump
+ ******************************************************************************
+ * Summary:
+ *  Nothing to dump, no trace record is kept.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void trace_log_dump(void)
+{
+}
+
+/* [] END OF FILE */
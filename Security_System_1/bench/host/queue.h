@@ -0,0 +1,88 @@
+/******************************************************************************
+* File Name:   queue.h
+*
+* Description: Host stand-in for the FreeRTOS queue API, see freertos_host.c.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#include <pthread.h>
+
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define xQueueSend(queue, item, wait)      xQueueSendToBack((queue), (item), (wait))
+#define xQueueSendFromISR(queue, item, woken) \
+    ((void) (woken), xQueueSendToBack((queue), (item), 0))
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Queue of fixed size items, a ring guarded by a lock of its own. */
+struct host_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     /* Signalled on every send and receive */
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t *items;
+};
+
+typedef struct host_queue *QueueHandle_t;
+
+/* Control block of a queue, what topic_storage_size() accounts for. */
+typedef struct host_queue StaticQueue_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif /* INC_QUEUE_H */
+
+/* [] END OF FILE */
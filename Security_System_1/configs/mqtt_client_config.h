@@ -69,6 +69,63 @@
 #define MQTT_PUB_TOPIC                    "ledstatus"
 #define MQTT_SUB_TOPIC                    "ledstatus"
 
+/* Prefix of the diagnostics topics below. Publishes on these topics leave no
+ * trace records and no link or wire samples, so that a report does not give
+ * the next report something to carry.
+ */
+#define MQTT_DIAGNOSTICS_TOPIC_PREFIX     "diagnostics/"
+
+/* Topic on which the per-topic drop and overwrite counters are published. */
+#define MQTT_DIAGNOSTICS_TOPIC            "diagnostics/topics"
+
+/* Topic on which the per-topic suppressed publish counts are published. */
+#define MQTT_RATE_LIMIT_DIAGNOSTICS_TOPIC "diagnostics/rate_limits"
+
+/* Topic on which the queueing delay of each publisher lane is published. */
+#define MQTT_LANE_DIAGNOSTICS_TOPIC       "diagnostics/lanes"
+
+/* Topic on which the reconnection statistics are published after each
+ * reconnection.
+ */
+#define MQTT_CONNECTION_DIAGNOSTICS_TOPIC "diagnostics/connection"
+
+/* Topic on which the MQTT connection times, mostly the TLS handshake, are
+ * published after each reconnection.
+ */
+#define MQTT_HANDSHAKE_DIAGNOSTICS_TOPIC  "diagnostics/handshake"
+
+/* Topic on which the round-trip estimate and the keep-alive interval are
+ * published, see link_quality.h.
+ */
+#define MQTT_LINK_DIAGNOSTICS_TOPIC       "diagnostics/link"
+
+/* Topic on which the peak use of the RX and TX buffers is published. */
+#define MQTT_BUFFER_DIAGNOSTICS_TOPIC     "diagnostics/buffers"
+
+/* Topic on which the bytes of the publishes are published, with the MQTT 5
+ * topic alias estimate, see wire_stats.h.
+ */
+#define MQTT_WIRE_DIAGNOSTICS_TOPIC       "diagnostics/wire"
+
+/* Topic on which the tokenized trace is dumped, see trace_log.h. With
+ * TRACE_DUMP_OVER_MQTT set to 0 the trace is printed over the UART instead.
+ */
+#define MQTT_TRACE_TOPIC                  "diagnostics/trace"
+#define TRACE_DUMP_OVER_MQTT              (1)
+
+/* Topic of the periodic snapshot carrying the latest reading of every
+ * member sensor, and its period in milliseconds.
+ */
+#define MQTT_SNAPSHOT_TOPIC               "snapshot"
+#define SNAPSHOT_PERIOD_MS                (10000u)
+
+/* Payload codec of the sensor telemetry: TELEMETRY_CODEC_TEXT (0) publishes
+ * the bare value as a decimal string, TELEMETRY_CODEC_BINARY (1) publishes a
+ * record of 4 to 12 bytes with the type, value, unit and timestamp, see
+ * telemetry_codec.h and scripts/telemetry_decode.py.
+ */
+#define TELEMETRY_CODEC                   (0)
+
 /* Set the QoS that is associated with the MQTT publish, and subscribe messages.
  * Valid choices are 0, 1, and 2. Other values should not be used in this macro.
  */
@@ -103,14 +160,38 @@
 /* The timeout in milliseconds for MQTT operations in this example. */
 #define MQTT_TIMEOUT_MS                   ( 5000 )
 
-/* The keep-alive interval in seconds used for MQTT ping request. */
+/* The keep-alive interval in seconds used for MQTT ping request. It is the
+ * interval of the first connection and the longest one; the interval of a
+ * reconnection is adapted down to MQTT_KEEP_ALIVE_MIN_SECONDS, see
+ * link_quality.h.
+ */
 #define MQTT_KEEP_ALIVE_SECONDS           ( 60 )
+#define MQTT_KEEP_ALIVE_MIN_SECONDS       ( 15 )
+
+/* Set this macro to 1 to connect without a clean session. The broker then
+ * keeps the subscriptions and queues the QoS 1 messages for the client while
+ * it is disconnected, so a reconnection needs no resubscription and loses no
+ * commands. The client identifier must not change between connections: with
+ * GENERATE_UNIQUE_CLIENT_ID the suffix is taken from the MAC address instead
+ * of a timestamp.
+ */
+#define MQTT_PERSISTENT_SESSION           ( 0 )
+
+/* The MQTT library does not report the session present flag of the CONNACK.
+ * After a reconnection, the client publishes a QoS 1 probe to a topic of its
+ * own, '<client identifier>/session'; the probe only comes back if the broker
+ * kept the subscription, i.e. the session. Time in milliseconds to wait for
+ * it before subscribing again.
+ */
+#define MQTT_SESSION_PROBE_TIMEOUT_MS     ( 2000 )
 
 /* Every active MQTT connection must have a unique client identifier. If you
  * are using the above 'MQTT_CLIENT_IDENTIFIER' as client ID for multiple MQTT
  * connections simultaneously, set this macro to 1. The device will then
  * generate a unique client identifier by appending a timestamp to the
  * 'MQTT_CLIENT_IDENTIFIER' string. Example: 'psoc6-mqtt-client5927'
+ * With MQTT_PERSISTENT_SESSION, the last three bytes of the MAC address are
+ * appended instead. Example: 'psoc6-mqtt-client0a1b2c'
  */
 #define GENERATE_UNIQUE_CLIENT_ID         ( 1 )
 
@@ -150,17 +231,33 @@
 /* A Network buffer is allocated for sending and receiving MQTT packets over
  * the network. Specify the size of this buffer using this macro.
  *
+ * The MQTT library sends a PUBLISH straight from the memory of the caller,
+ * so the buffer only has to hold the packets that are received, and the
+ * CONNECT and SUBSCRIBE packets: it is the RX buffer. An incoming message
+ * must fit in it whole; larger payloads are sent as a stream of chunks, see
+ * payload_stream.h. The TX size is the payload size of a publish slot,
+ * 'PUBLISH_PAYLOAD_SIZE' in publisher_task.h.
+ *
  * Note: The minimum buffer size is defined by 'CY_MQTT_MIN_NETWORK_BUFFER_SIZE'
  * macro in the MQTT library. Please ensure this macro value is larger than
  * 'CY_MQTT_MIN_NETWORK_BUFFER_SIZE'.
  */
-#define MQTT_NETWORK_BUFFER_SIZE          ( 2 * CY_MQTT_MIN_NETWORK_BUFFER_SIZE )
+#define MQTT_RX_BUFFER_SIZE               ( 2 * CY_MQTT_MIN_NETWORK_BUFFER_SIZE )
+#define MQTT_NETWORK_BUFFER_SIZE          ( MQTT_RX_BUFFER_SIZE )
 
-/* Maximum MQTT connection re-connection limit. */
-#define MAX_MQTT_CONN_RETRIES            (150u)
+/* Backoff between failed Wi-Fi and MQTT connection attempts, which are
+ * retried until they succeed. The delay before the n-th retry is drawn at
+ * random from [d/2, d], d = min(RECONNECT_BACKOFF_MAX_MS,
+ * RECONNECT_BACKOFF_BASE_MS * 2^n), so that devices that lost the same
+ * access point or broker do not retry in lockstep.
+ */
+#define RECONNECT_BACKOFF_BASE_MS        (1000u)
+#define RECONNECT_BACKOFF_MAX_MS         (60000u)
 
-/* MQTT re-connection time interval in milliseconds. */
-#define MQTT_CONN_RETRY_INTERVAL_MS      (2000)
+/* Drops the connection every SIMULATED_OUTAGE_INTERVAL_MS milliseconds, to
+ * measure the reconnection. 0 disables the simulated outages.
+ */
+#define SIMULATED_OUTAGE_INTERVAL_MS     (0u)
 
 
 /**************** MQTT CLIENT CERTIFICATE CONFIGURATION MACROS ****************/
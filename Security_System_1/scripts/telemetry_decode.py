@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Decodes sensor telemetry payloads published with TELEMETRY_CODEC_BINARY,
+single samples as well as snapshots.
+
+The layout is described in source/telemetry_codec.h. Payloads are given as
+hex strings on the command line, or as raw bytes on stdin, e.g. piped from
+'mosquitto_sub -t thermistor -C 1'.
+
+    python3 telemetry_decode.py 11fed22480dddb01
+"""
+
+import sys
+
+BINARY_MIN_SIZE = 4
+SNAPSHOT_VERSION = 0x81
+SNAPSHOT_HEADER_SIZE = 2
+
+TYPES = {1: "temperature", 2: "vibration", 3: "button", 4: "presence"}
+UNITS = {0: "", 1: "degC", 2: "uV"}
+
+
+def read_varint(payload, offset):
+    """Returns a varint of at most 32 bits and the offset after it."""
+    value = 0
+    for shift in range(0, 35, 7):
+        if offset >= len(payload):
+            raise ValueError("truncated varint")
+        byte = payload[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value & 0xFFFFFFFF, offset
+    raise ValueError("varint longer than 5 bytes")
+
+
+def decode_at(payload, offset):
+    """Returns the fields of the binary payload at 'offset' as a dict, and the
+    offset after it."""
+    if len(payload) - offset < BINARY_MIN_SIZE:
+        raise ValueError("expected at least %d bytes, got %d"
+                         % (BINARY_MIN_SIZE, len(payload) - offset))
+
+    kind = payload[offset] >> 4
+    unit = payload[offset] & 0x0F
+    exponent = payload[offset + 1] - 256 if payload[offset + 1] > 127 else payload[offset + 1]
+    zigzag, offset = read_varint(payload, offset + 2)
+    timestamp_ms, offset = read_varint(payload, offset)
+    value = (zigzag >> 1) ^ -(zigzag & 1)
+
+    return {
+        "type": TYPES.get(kind, "type %d" % kind),
+        "value": value * 10 ** exponent if exponent >= 0 else value / 10 ** -exponent,
+        "unit": UNITS.get(unit, "unit %d" % unit),
+        "timestamp_ms": timestamp_ms,
+    }, offset
+
+
+def decode(payload):
+    """Returns the fields of a binary payload as a dict."""
+    sample, offset = decode_at(payload, 0)
+    if offset != len(payload):
+        raise ValueError("%d bytes after the sample" % (len(payload) - offset))
+    return sample
+
+
+def decode_snapshot(payload):
+    """Returns the samples of a binary snapshot as a list of dicts."""
+    if len(payload) < SNAPSHOT_HEADER_SIZE or payload[0] != SNAPSHOT_VERSION:
+        raise ValueError("not a snapshot")
+
+    samples = []
+    offset = SNAPSHOT_HEADER_SIZE
+    for _ in range(payload[1]):
+        sample, offset = decode_at(payload, offset)
+        samples.append(sample)
+    if offset != len(payload):
+        raise ValueError("snapshot of %d samples has %d bytes" % (payload[1], len(payload)))
+
+    return samples
+
+
+def main():
+    if len(sys.argv) > 1:
+        payload = bytes.fromhex("".join(sys.argv[1:]))
+    else:
+        payload = sys.stdin.buffer.read()
+
+    try:
+        if payload[:1] == bytes([SNAPSHOT_VERSION]):
+            samples = decode_snapshot(payload)
+        else:
+            samples = [decode(payload)]
+    except ValueError as error:
+        print("telemetry_decode: %s" % error, file=sys.stderr)
+        return 1
+
+    for sample in samples:
+        print("%(type)s %(value)s %(unit)s at %(timestamp_ms)d ms" % sample)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Decodes the tokenized trace of source/trace_log.c.
+
+The event table is read from source/trace_events.h, the same file the
+firmware is built from, so the format strings never need to be on the device.
+Keep the table of the firmware that produced the trace.
+
+Dumps are given as hex strings on the command line, or on stdin either as a
+UART capture, whose lines starting with "TRACE " are decoded, or as the raw
+bytes of one MQTT dump, e.g. piped from
+'mosquitto_sub -t diagnostics/trace -C 1'.
+
+    python3 trace_decode.py 0100000f030073000000000000002a000000
+"""
+
+import os
+import re
+import struct
+import sys
+
+FORMAT_VERSION = 1
+DUMP_HEADER_SIZE = 3
+RECORD_HEADER_FORMAT = "<BHI"
+RECORD_HEADER_SIZE = struct.calcsize(RECORD_HEADER_FORMAT)
+
+EVENTS_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "..", "source", "trace_events.h")
+EVENT_PATTERN = re.compile(r'^TRACE_EVENT\(\s*(\w+)\s*,\s*(\d+)\s*,\s*"([isS]*)"\s*,\s*"(.*)"\s*\)')
+
+
+def load_events(path=EVENTS_PATH):
+    """Returns the events of trace_events.h as {id: (name, arguments, format)}."""
+    events = {}
+    with open(path) as table:
+        for line in table:
+            match = EVENT_PATTERN.match(line.strip())
+            if match:
+                name, event_id, arguments, text = match.groups()
+                events[int(event_id)] = (name, arguments, text)
+    return events
+
+
+def decode_record(record, events):
+    """Returns the timestamp and the text of one record."""
+    _, event_id, timestamp_ms = struct.unpack_from(RECORD_HEADER_FORMAT, record)
+    if event_id not in events:
+        return timestamp_ms, "unknown event %d: %s" % (event_id, record.hex())
+
+    name, arguments, text = events[event_id]
+    values = []
+    offset = RECORD_HEADER_SIZE
+    for argument in arguments:
+        # The firmware leaves out the arguments that did not fit the record
+        if argument == "i" and offset + 4 <= len(record):
+            values.append(struct.unpack_from("<I", record, offset)[0])
+            offset += 4
+        elif argument in "sS" and offset + 1 <= len(record):
+            length = record[offset]
+            values.append(record[offset + 1:offset + 1 + length].decode("utf-8", "replace"))
+            offset += 1 + length
+        else:
+            values.append("?")
+
+    try:
+        return timestamp_ms, text % tuple(values)
+    except TypeError:
+        return timestamp_ms, "%s %s" % (name, values)
+
+
+def decode_dump(dump, events):
+    """Returns the number of lost records and the decoded records of a dump."""
+    if len(dump) < DUMP_HEADER_SIZE or dump[0] != FORMAT_VERSION:
+        raise ValueError("not a trace dump of layout version %d" % FORMAT_VERSION)
+
+    lost = struct.unpack_from("<H", dump, 1)[0]
+    records = []
+    offset = DUMP_HEADER_SIZE
+    while offset < len(dump):
+        length = dump[offset]
+        if length < RECORD_HEADER_SIZE or offset + length > len(dump):
+            raise ValueError("truncated record at offset %d" % offset)
+        records.append(decode_record(dump[offset:offset + length], events))
+        offset += length
+    return lost, records
+
+
+def read_dumps():
+    """Returns the dumps given on the command line or on stdin."""
+    if len(sys.argv) > 1:
+        return [bytes.fromhex(argument) for argument in sys.argv[1:]]
+
+    data = sys.stdin.buffer.read()
+    if data[:1] == bytes([FORMAT_VERSION]):
+        return [data]
+
+    return [bytes.fromhex(line.split(None, 1)[1])
+            for line in data.decode("ascii", "replace").splitlines()
+            if line.startswith("TRACE ")]
+
+
+def main():
+    events = load_events()
+
+    for dump in read_dumps():
+        try:
+            lost, records = decode_dump(dump, events)
+        except ValueError as error:
+            print("trace_decode: %s" % error, file=sys.stderr)
+            return 1
+
+        if lost:
+            print("-- %d records lost --" % lost)
+        for timestamp_ms, text in records:
+            print("%10d ms  %s" % (timestamp_ms, text))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
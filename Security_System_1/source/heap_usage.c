@@ -48,6 +48,11 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+/* Log module of this file, see log_task.h. */
+#define LOG_MODULE  "Heap"
+#define LOG_MODULE_LEVEL  LOG_LEVEL_HEAP
+#include "log_task.h"
+
 /* ARM compiler also defines __GNUC__ */
 #if defined (__GNUC__) && !defined(__ARMCC_VERSION)
 #include <malloc.h>
@@ -68,13 +73,15 @@
 * Function Name: print_heap_usage
 ********************************************************************************
 * Summary:
-* Prints the available heap and utilized heap by using mallinfo().
+* Logs the available heap and utilized heap by using mallinfo(), at the
+* debug level of the "Heap" module.
 *
 *******************************************************************************/
 void print_heap_usage(char *msg)
 {
     /* ARM compiler also defines __GNUC__ */
-#if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION)
+#if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION) && \
+    (LOG_LEVEL_HEAP >= LOG_LEVEL_DEBUG)
     struct mallinfo mall_info = mallinfo();
 
     extern uint8_t __HeapBase;  /* Symbol exported by the linker. */
@@ -84,17 +91,14 @@ void print_heap_usage(char *msg)
     uint8_t* heap_limit = (uint8_t *)&__HeapLimit;
     uint32_t heap_size = (uint32_t)(heap_limit - heap_base);
 
-    printf("\r\n\n********** Heap Usage **********\r\n");
-    printf(msg);
-    printf("\r\nTotal available heap        : %"PRIu32" bytes/%.2f KB\r\n", heap_size, TO_KB(heap_size));
+    LOG_DBG("%s", msg);
+    LOG_DBG("Total available heap        : %"PRIu32" bytes/%.2f KB", heap_size, TO_KB(heap_size));
 
-    printf("Maximum heap utilized so far: %u bytes/%.2f KB, %.2f%% of available heap\r\n",
+    LOG_DBG("Maximum heap utilized so far: %u bytes/%.2f KB, %.2f%% of available heap",
             mall_info.arena, TO_KB(mall_info.arena), ((float) mall_info.arena * 100u)/heap_size);
 
-    printf("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap\r\n",
+    LOG_DBG("Heap in use at this point   : %u bytes/%.2f KB, %.2f%% of available heap",
             mall_info.uordblks, TO_KB(mall_info.uordblks), ((float) mall_info.uordblks * 100u)/heap_size);
-
-    printf("********************************\r\n\n");
 #endif /* #if defined(PRINT_HEAP_USAGE) && defined (__GNUC__) && !defined(__ARMCC_VERSION) */
 }
 
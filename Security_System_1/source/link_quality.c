@@ -0,0 +1,521 @@
+/******************************************************************************
+* File Name:   link_quality.c
+*
+* Description: This file contains the round-trip time estimator of the MQTT
+*              link. The MQTT library answers the keep-alive PINGREQ itself,
+*              so the round trip is measured on the QoS 1 publishes instead:
+*              cy_mqtt_publish() returns when the PUBACK arrives. A publish
+*              that outlasts the estimate by far reports a dead link to the
+*              MQTT client task, long before the keep-alive would.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+
+#include "mqtt_task.h"
+#include "mqtt_client_config.h"
+#include "link_quality.h"
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Round-trip statistics. 'srtt_x8' and 'rttvar_x4' hold the smoothed round
+ * trip and its mean deviation scaled by 8 and 4, as in RFC 6298.
+ */
+typedef struct
+{
+    uint32_t samples;
+    int32_t srtt_x8;
+    int32_t rttvar_x4;
+    uint32_t min_rtt_ms;
+    uint32_t max_rtt_ms;
+    uint32_t stalls;                    /* Dead links found by the stall timer */
+    uint32_t reported;                  /* 'samples' at the last report */
+} link_stats_t;
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+/* Shared by the publisher tasks and the timer service task, accessed in
+ * critical sections.
+ */
+static link_stats_t link_stats;
+
+/* Tick at which each timed publish was sent, 0 for a free entry. */
+static TickType_t link_outstanding[LINK_MAX_OUTSTANDING];
+
+/* Timed publishes found overdue, and the number of overdue publishes since
+ * the last publish acknowledged in time.
+ */
+static bool link_overdue[LINK_MAX_OUTSTANDING];
+static uint32_t link_overdue_count = 0;
+
+/* One-shot timer due when the oldest timed publish stalls. */
+static TimerHandle_t link_stall_timer = NULL;
+
+/* Keep-alive interval of the next connection, in seconds. */
+static uint16_t link_keep_alive_sec = MQTT_KEEP_ALIVE_SECONDS;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void link_stall_arm(TickType_t now);
+static void link_stall_check(TimerHandle_t timer);
+
+/******************************************************************************
+ * Function Name: link_quality_init
+ ******************************************************************************
+ * Summary:
+ *  Creates the stall timer. Called by the MQTT client task before the
+ *  publisher tasks are created.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : false if the timer could not be created
+ *
+ ******************************************************************************/
+bool link_quality_init(void)
+{
+    link_stall_timer = xTimerCreate("Link stall", 1, pdFALSE, NULL, link_stall_check);
+    return (link_stall_timer != NULL);
+}
+
+/******************************************************************************
+ * Function Name: link_quality_publish_begin
+ ******************************************************************************
+ * Summary:
+ *  Starts timing a publish that is about to be sent, and arms the stall
+ *  timer if it is the only publish in flight.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  int : Handle for link_quality_publish_end(), -1 if no entry is free
+ *
+ ******************************************************************************/
+int link_quality_publish_begin(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    int handle = -1;
+    bool first = true;
+
+    /* 0 marks a free entry. */
+    if (now == 0)
+    {
+        now = 1;
+    }
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < LINK_MAX_OUTSTANDING; i++)
+    {
+        if (link_outstanding[i] != 0)
+        {
+            first = false;
+        }
+        else if (handle < 0)
+        {
+            link_outstanding[i] = now;
+            link_overdue[i] = false;
+            handle = (int) i;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if ((handle >= 0) && first)
+    {
+        link_stall_arm(now);
+    }
+
+    return handle;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_publish_end
+ ******************************************************************************
+ * Summary:
+ *  Ends the timing of a publish. The round trip of an acknowledged publish
+ *  updates the estimate; a failed publish is not sampled.
+ *
+ * Parameters:
+ *  int handle : Handle returned by link_quality_publish_begin()
+ *  bool acknowledged : true if the PUBACK arrived
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void link_quality_publish_end(int handle, bool acknowledged)
+{
+    if ((handle < 0) || (handle >= (int) LINK_MAX_OUTSTANDING))
+    {
+        return;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    bool idle = true;
+
+    taskENTER_CRITICAL();
+    uint32_t rtt = (now - link_outstanding[handle]) * portTICK_PERIOD_MS;
+    link_outstanding[handle] = 0;
+
+    if (acknowledged)
+    {
+        if (!link_overdue[handle])
+        {
+            link_overdue_count = 0;
+        }
+
+        if (link_stats.samples == 0)
+        {
+            link_stats.srtt_x8 = (int32_t) (rtt << 3);
+            link_stats.rttvar_x4 = (int32_t) (rtt << 1);
+            link_stats.min_rtt_ms = rtt;
+            link_stats.max_rtt_ms = rtt;
+        }
+        else
+        {
+            /* srtt += (rtt - srtt) / 8, rttvar += (|rtt - srtt| - rttvar) / 4 */
+            int32_t error = (int32_t) rtt - (link_stats.srtt_x8 >> 3);
+
+            link_stats.srtt_x8 += error;
+            if (error < 0)
+            {
+                error = -error;
+            }
+            link_stats.rttvar_x4 += error - (link_stats.rttvar_x4 >> 2);
+
+            if (rtt < link_stats.min_rtt_ms)
+            {
+                link_stats.min_rtt_ms = rtt;
+            }
+            if (rtt > link_stats.max_rtt_ms)
+            {
+                link_stats.max_rtt_ms = rtt;
+            }
+        }
+        link_stats.samples++;
+    }
+
+    for (uint32_t i = 0; i < LINK_MAX_OUTSTANDING; i++)
+    {
+        if (link_outstanding[i] != 0)
+        {
+            idle = false;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (idle)
+    {
+        xTimerStop(link_stall_timer, 0);
+    }
+    else
+    {
+        link_stall_arm(now);
+    }
+}
+
+/******************************************************************************
+ * Function Name: link_quality_rto_ms
+ ******************************************************************************
+ * Summary:
+ *  Returns the retransmission timeout of RFC 6298, srtt + 4 * rttvar,
+ *  bounded by 'LINK_RTO_MIN_MS' and 'LINK_RTO_MAX_MS'.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Timeout in milliseconds, 0 before the first sample
+ *
+ ******************************************************************************/
+uint32_t link_quality_rto_ms(void)
+{
+    uint32_t rto;
+
+    taskENTER_CRITICAL();
+    if (link_stats.samples == 0)
+    {
+        rto = 0;
+    }
+    else
+    {
+        rto = (uint32_t) ((link_stats.srtt_x8 >> 3) + link_stats.rttvar_x4);
+        if (rto < LINK_RTO_MIN_MS)
+        {
+            rto = LINK_RTO_MIN_MS;
+        }
+        else if (rto > LINK_RTO_MAX_MS)
+        {
+            rto = LINK_RTO_MAX_MS;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return rto;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_stall_ms
+ ******************************************************************************
+ * Summary:
+ *  Returns how long a publish may wait for its PUBACK before it is overdue:
+ *  'LINK_STALL_RTO_FACTOR' retransmission timeouts, at least
+ *  'LINK_STALL_MIN_MS'.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  uint32_t : Time in milliseconds, 0 while no round trip is known
+ *
+ ******************************************************************************/
+uint32_t link_quality_stall_ms(void)
+{
+    uint32_t stall = link_quality_rto_ms() * LINK_STALL_RTO_FACTOR;
+
+    if ((stall > 0) && (stall < LINK_STALL_MIN_MS))
+    {
+        stall = LINK_STALL_MIN_MS;
+    }
+
+    return stall;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_next_keep_alive
+ ******************************************************************************
+ * Summary:
+ *  Returns the keep-alive interval for the next connection, which only
+ *  takes effect at the CONNECT. A link that was lost halves it, down to
+ *  'MQTT_KEEP_ALIVE_MIN_SECONDS', so that an idle dead link is found sooner
+ *  and an idle timeout on the path is less likely. A connection that lasted
+ *  'LINK_KEEP_ALIVE_STABLE_MS' doubles it, up to 'MQTT_KEEP_ALIVE_SECONDS'.
+ *
+ * Parameters:
+ *  bool link_lost : true if the previous connection was lost, false if it
+ *                   was closed on purpose
+ *  uint32_t connected_ms : Duration of the previous connection
+ *
+ * Return:
+ *  uint16_t : Keep-alive interval in seconds
+ *
+ ******************************************************************************/
+uint16_t link_quality_next_keep_alive(bool link_lost, uint32_t connected_ms)
+{
+    if (connected_ms >= LINK_KEEP_ALIVE_STABLE_MS)
+    {
+        link_keep_alive_sec *= 2u;
+    }
+    else if (link_lost)
+    {
+        link_keep_alive_sec /= 2u;
+    }
+
+    if (link_keep_alive_sec < MQTT_KEEP_ALIVE_MIN_SECONDS)
+    {
+        link_keep_alive_sec = MQTT_KEEP_ALIVE_MIN_SECONDS;
+    }
+    else if (link_keep_alive_sec > MQTT_KEEP_ALIVE_SECONDS)
+    {
+        link_keep_alive_sec = MQTT_KEEP_ALIVE_SECONDS;
+    }
+
+    return link_keep_alive_sec;
+}
+
+/******************************************************************************
+ * Function Name: link_quality_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the link quality on 'MQTT_LINK_DIAGNOSTICS_TOPIC' as a JSON
+ *  object, if round trips other than that of the previous report were
+ *  measured since.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void link_quality_diagnostics(void)
+{
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+    link_stats_t stats;
+
+    taskENTER_CRITICAL();
+    stats = link_stats;
+    /* The report is itself a publish, and is sampled. */
+    if (link_stats.samples > (link_stats.reported + 1u))
+    {
+        link_stats.reported = link_stats.samples + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    if (stats.samples <= (stats.reported + 1u))
+    {
+        return;
+    }
+
+    int written = snprintf(payload, sizeof(payload),
+                           "{\"samples\":%lu,\"srtt_ms\":%lu,\"rttvar_ms\":%lu,\"rto_ms\":%lu,"
+                           "\"min_ms\":%lu,\"max_ms\":%lu,\"stalls\":%lu,\"keep_alive_s\":%u}",
+                           (unsigned long) stats.samples,
+                           (unsigned long) (stats.srtt_x8 >> 3),
+                           (unsigned long) (stats.rttvar_x4 >> 2),
+                           (unsigned long) link_quality_rto_ms(),
+                           (unsigned long) stats.min_rtt_ms,
+                           (unsigned long) stats.max_rtt_ms,
+                           (unsigned long) stats.stalls,
+                           (unsigned) connection_info.keep_alive_sec);
+    if ((written > 0) && ((size_t) written < sizeof(payload)))
+    {
+        PublishMessage(payload, MQTT_LINK_DIAGNOSTICS_TOPIC);
+    }
+}
+
+/******************************************************************************
+ * Function Name: link_stall_arm
+ ******************************************************************************
+ * Summary:
+ *  Arms the stall timer for the oldest publish in flight that is not overdue
+ *  yet.
+ *
+ * Parameters:
+ *  TickType_t now : Current tick count
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void link_stall_arm(TickType_t now)
+{
+    uint32_t stall = link_quality_stall_ms();
+    TickType_t oldest_age = 0;
+    bool waiting = false;
+
+    if (stall == 0)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < LINK_MAX_OUTSTANDING; i++)
+    {
+        if ((link_outstanding[i] != 0) && !link_overdue[i])
+        {
+            waiting = true;
+            if ((now - link_outstanding[i]) > oldest_age)
+            {
+                oldest_age = now - link_outstanding[i];
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (!waiting)
+    {
+        return;
+    }
+
+    TickType_t period = pdMS_TO_TICKS(stall);
+    period = (oldest_age < period) ? (period - oldest_age) : 1;
+    xTimerChangePeriod(link_stall_timer, period, 0);
+}
+
+/******************************************************************************
+ * Function Name: link_stall_check
+ ******************************************************************************
+ * Summary:
+ *  Callback of the stall timer. Counts the publishes that have waited too
+ *  long for their PUBACK, and asks the MQTT client task to drop the
+ *  connection once 'LINK_STALL_COUNT' publishes in a row were overdue. Then
+ *  re-arms the timer for the oldest publish that is not overdue. Runs in the
+ *  timer service task and must not block.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Stall timer
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void link_stall_check(TimerHandle_t timer)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t stall = pdMS_TO_TICKS(link_quality_stall_ms());
+    bool stalled = false;
+
+    (void) timer;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < LINK_MAX_OUTSTANDING; i++)
+    {
+        if ((link_outstanding[i] != 0) && !link_overdue[i] &&
+            ((now - link_outstanding[i]) >= stall))
+        {
+            link_overdue[i] = true;
+            link_overdue_count++;
+        }
+    }
+    if (link_overdue_count >= LINK_STALL_COUNT)
+    {
+        link_overdue_count = 0;
+        link_stats.stalls++;
+        stalled = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (stalled)
+    {
+        mqtt_task_cmd_t mqtt_task_cmd = HANDLE_LINK_STALL;
+        xQueueSend(mqtt_task_q, &mqtt_task_cmd, 0);
+    }
+
+    link_stall_arm(now);
+}
+
+/* [] END OF FILE */
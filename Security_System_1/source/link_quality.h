@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name:   link_quality.h
+*
+* Description: This file is the public interface of link_quality.c, which
+*              estimates the round-trip time to the MQTT broker and adapts the
+*              keep-alive interval.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef LINK_QUALITY_H_
+#define LINK_QUALITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "publisher_task.h"
+#include "mqtt_client_config.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Bounds of the retransmission timeout derived from the round-trip time. */
+#define LINK_RTO_MIN_MS                    (200u)
+#define LINK_RTO_MAX_MS                    (10000u)
+
+/* A publish still waiting for its PUBACK after this many retransmission
+ * timeouts, and at least LINK_STALL_MIN_MS, is overdue. The floor keeps a
+ * slow PUBACK that the MQTT library would still wait for from counting.
+ * LINK_STALL_COUNT overdue publishes in a row mark the link as dead.
+ */
+#define LINK_STALL_RTO_FACTOR              (2u)
+#define LINK_STALL_MIN_MS                  (MQTT_TIMEOUT_MS)
+#define LINK_STALL_COUNT                   (2u)
+
+/* A connection that lasts this long doubles the keep-alive interval of the
+ * next connection, up to MQTT_KEEP_ALIVE_SECONDS.
+ */
+#define LINK_KEEP_ALIVE_STABLE_MS          (30u * 60u * 1000u)
+
+/* Number of publishes timed at the same time, one per publisher task. */
+#define LINK_MAX_OUTSTANDING               (PUBLISH_WINDOW_SIZE)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool link_quality_init(void);
+int link_quality_publish_begin(void);
+void link_quality_publish_end(int handle, bool acknowledged);
+uint32_t link_quality_rto_ms(void);
+uint32_t link_quality_stall_ms(void);
+uint16_t link_quality_next_keep_alive(bool link_lost, uint32_t connected_ms);
+void link_quality_diagnostics(void);
+
+#endif /* LINK_QUALITY_H_ */
+
+/* [] END OF FILE */
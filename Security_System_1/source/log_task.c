@@ -0,0 +1,237 @@
+/******************************************************************************
+* File Name:   log_task.c
+*
+* Description: This file contains the deferred logging facility. Tasks format
+*              their log records into a ring buffer, and a low priority task
+*              prints them over the retarget-io UART, so that no hot path
+*              waits for the UART.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Task header files */
+#include "log_task.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1u)) != 0u
+    #error "LOG_BUFFER_SIZE must be a power of two."
+#endif
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static size_t log_pop(char *record);
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* FreeRTOS task handle of the log task. */
+TaskHandle_t log_task_handle;
+
+/* Ring buffer of records. A record is its length in one byte followed by its
+ * text without terminator. 'head' and 'tail' run freely and are only changed
+ * inside a critical section.
+ */
+static uint8_t log_ring[LOG_BUFFER_SIZE];
+static uint32_t log_head = 0;
+static uint32_t log_tail = 0;
+
+/* Records that did not fit the ring, and the count last printed. */
+static uint32_t log_dropped = 0;
+static uint32_t log_reported = 0;
+
+/* Prefixes of the log levels. */
+static const char *const log_level_prefix[] =
+{
+    [LOG_LEVEL_NONE]    = "",
+    [LOG_LEVEL_ERROR]   = "Error: ",
+    [LOG_LEVEL_WARNING] = "Warning: ",
+    [LOG_LEVEL_INFO]    = "",
+    [LOG_LEVEL_DEBUG]   = ""
+};
+
+/******************************************************************************
+ * Function Name: log_task
+ ******************************************************************************
+ * Summary:
+ *  Task that prints the records of the ring buffer whenever log_write() adds
+ *  some, and reports the records that were dropped because the ring was full.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void log_task(void *pvParameters)
+{
+    char record[LOG_RECORD_SIZE + 1];
+    uint32_t dropped;
+
+    /* To avoid compiler warnings */
+    (void) pvParameters;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (log_pop(record) > 0)
+        {
+            printf("%s", record);
+        }
+
+        dropped = log_dropped;
+        if (dropped != log_reported)
+        {
+            printf("  Log: %lu records dropped\n", (unsigned long) (dropped - log_reported));
+            log_reported = dropped;
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_write
+ ******************************************************************************
+ * Summary:
+ *  Formats a record as "  <module>: <text>" followed by a line break, copies
+ *  it into the ring buffer and wakes the log task. Never blocks; a record
+ *  that does not fit is dropped and counted. Use the LOG_ERR(), LOG_WRN(),
+ *  LOG_INF() and LOG_DBG() macros rather than calling it directly.
+ *
+ * Parameters:
+ *  int level : Log level of the record
+ *  const char *module : Module name
+ *  const char *format : printf() format of the text, without line break
+ *  ... : Arguments of the format
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void log_write(int level, const char *module, const char *format, ...)
+{
+    char record[LOG_RECORD_SIZE + 1];
+    va_list args;
+    int len;
+
+    len = snprintf(record, sizeof(record), "  %s: %s", module, log_level_prefix[level]);
+    if ((len < 0) || (len >= (int) LOG_RECORD_SIZE))
+    {
+        return;
+    }
+
+    va_start(args, format);
+    int written = vsnprintf(&record[len], sizeof(record) - len, format, args);
+    va_end(args);
+
+    if (written < 0)
+    {
+        return;
+    }
+
+    /* Truncated records keep their line break. */
+    len = ((len + written) < (int) LOG_RECORD_SIZE) ? (len + written) : ((int) LOG_RECORD_SIZE - 1);
+    record[len++] = '\n';
+
+    taskENTER_CRITICAL();
+    if ((LOG_BUFFER_SIZE - (log_tail - log_head)) < (uint32_t) (len + 1))
+    {
+        log_dropped++;
+        len = 0;
+    }
+    else
+    {
+        log_ring[log_tail % LOG_BUFFER_SIZE] = (uint8_t) len;
+        for (int i = 0; i < len; i++)
+        {
+            log_ring[(log_tail + 1u + i) % LOG_BUFFER_SIZE] = (uint8_t) record[i];
+        }
+        log_tail += len + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    if ((len > 0) && (log_task_handle != NULL))
+    {
+        xTaskNotifyGive(log_task_handle);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_pop
+ ******************************************************************************
+ * Summary:
+ *  Takes the oldest record out of the ring buffer.
+ *
+ * Parameters:
+ *  char *record : Receives the null-terminated record, at least
+ *                 'LOG_RECORD_SIZE' + 1 bytes
+ *
+ * Return:
+ *  size_t : Length of the record, 0 if the ring is empty
+ *
+ ******************************************************************************/
+static size_t log_pop(char *record)
+{
+    size_t len = 0;
+
+    taskENTER_CRITICAL();
+    if (log_head != log_tail)
+    {
+        len = log_ring[log_head % LOG_BUFFER_SIZE];
+        for (size_t i = 0; i < len; i++)
+        {
+            record[i] = (char) log_ring[(log_head + 1u + i) % LOG_BUFFER_SIZE];
+        }
+        log_head += len + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    record[len] = '\0';
+    return len;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,148 @@
+/******************************************************************************
+* File Name:   log_task.h
+*
+* Description: This file is the public interface of log_task.c. It defines
+*              the compile-time log levels and the logging macros.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef LOG_TASK_H_
+#define LOG_TASK_H_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Task parameters for Log Task. Lowest application priority, the UART is only
+ * written when nothing else has to run.
+ */
+#define LOG_TASK_PRIORITY                     (1)
+#define LOG_TASK_STACK_SIZE                   (1024 * 1)
+
+/* Size in bytes of the ring buffer holding the records not yet printed. A
+ * record takes one byte more than its text.
+ */
+#define LOG_BUFFER_SIZE                       (2048u)
+
+/* Longest record, including the module prefix and the line break. Longer
+ * records are truncated.
+ */
+#define LOG_RECORD_SIZE                       (128u)
+
+/* Log levels. A module prints the records up to its level. */
+#define LOG_LEVEL_NONE                        (0)
+#define LOG_LEVEL_ERROR                       (1)
+#define LOG_LEVEL_WARNING                     (2)
+#define LOG_LEVEL_INFO                        (3)
+#define LOG_LEVEL_DEBUG                       (4)
+
+/* Log level of each module. Can be overridden from the Makefile, e.g.
+ * DEFINES+=LOG_LEVEL_PUBLISHER=4.
+ */
+#ifndef LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DEFAULT                     LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_LEVEL_MAIN
+#define LOG_LEVEL_MAIN                        LOG_LEVEL_DEFAULT
+#endif
+
+#ifndef LOG_LEVEL_PUBLISHER
+#define LOG_LEVEL_PUBLISHER                   LOG_LEVEL_DEFAULT
+#endif
+
+#ifndef LOG_LEVEL_SUBSCRIBER
+#define LOG_LEVEL_SUBSCRIBER                  LOG_LEVEL_DEFAULT
+#endif
+
+/* Heap usage reports are only of interest while debugging. */
+#ifndef LOG_LEVEL_HEAP
+#define LOG_LEVEL_HEAP                        LOG_LEVEL_DEBUG
+#endif
+
+/* Logging macros of a module. A source file defines LOG_MODULE, the prefix
+ * of its records, and LOG_MODULE_LEVEL before including this header. The
+ * macros of the levels above LOG_MODULE_LEVEL compile to nothing, their
+ * arguments are not evaluated. They must not be used from interrupt
+ * handlers.
+ */
+#if defined(LOG_MODULE) && defined(LOG_MODULE_LEVEL)
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERR(...)        log_write(LOG_LEVEL_ERROR, LOG_MODULE, __VA_ARGS__)
+#else
+#define LOG_ERR(...)        do { } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARNING
+#define LOG_WRN(...)        log_write(LOG_LEVEL_WARNING, LOG_MODULE, __VA_ARGS__)
+#else
+#define LOG_WRN(...)        do { } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INF(...)        log_write(LOG_LEVEL_INFO, LOG_MODULE, __VA_ARGS__)
+#else
+#define LOG_INF(...)        do { } while (0)
+#endif
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DBG(...)        log_write(LOG_LEVEL_DEBUG, LOG_MODULE, __VA_ARGS__)
+#else
+#define LOG_DBG(...)        do { } while (0)
+#endif
+
+#endif /* defined(LOG_MODULE) && defined(LOG_MODULE_LEVEL) */
+
+/*******************************************************************************
+* Extern Variables
+********************************************************************************/
+extern TaskHandle_t log_task_handle;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void log_task(void *pvParameters);
+void log_write(int level, const char *module, const char *format, ...);
+
+#endif /* LOG_TASK_H_ */
+
+/* [] END OF FILE */
@@ -45,6 +45,15 @@
 
 #include "mqtt_task.h"
 #include "subscriber_task.h"
+#include "publisher_task.h"
+#include "telemetry_codec.h"
+#include "snapshot_task.h"
+#include "outbox_task.h"
+
+/* Log module of this file, see log_task.h. */
+#define LOG_MODULE          "Main"
+#define LOG_MODULE_LEVEL    LOG_LEVEL_MAIN
+#include "log_task.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -85,6 +94,23 @@
 #define LAMP_OUT_PIN 	P9_4
 #define PIEZO_IN_PIN	P10_5
 #define RADAR_IN_PIN	P9_2
+
+/* Token bucket of the edge-triggered sensor topics: sustained publishes per
+ * second and the number of edges that can be published back to back. The
+ * last suppressed edge is always published once the rate allows it.
+ */
+#define EDGE_SENSOR_PUBLISH_RATE	(5u)
+#define EDGE_SENSOR_PUBLISH_BURST	(3u)
+
+/* Snapshot membership of the sensors: 1 puts the latest reading of the
+ * sensor into the periodic snapshot on MQTT_SNAPSHOT_TOPIC, 0 leaves it
+ * out. Routine readings of a member are only sent with the snapshot, urgent
+ * events (edges, threshold crossings) are always published right away.
+ */
+#define BUTTON_IN_SNAPSHOT		(1)
+#define THERMISTOR_IN_SNAPSHOT	(1)
+#define RADAR_IN_SNAPSHOT		(1)
+#define PIEZO_IN_SNAPSHOT		(1)
 /*******************************************************************************
 * Global Variables
 *******************************************************************************/
@@ -113,9 +139,10 @@ uint8_t uart_read_value;
 /* Timer object used for blinking the LED */
 cyhal_timer_t led_blink_timer;
 /* Include serial flash library and QSPI memory configurations only for the
- * kits that require the Wi-Fi firmware to be loaded in external QSPI NOR flash.
+ * kits that require the Wi-Fi firmware to be loaded in external QSPI NOR flash,
+ * or that keep the outbox there.
  */
-#if defined(CY_DEVICE_PSOC6A512K)
+#if defined(CY_DEVICE_PSOC6A512K) || OUTBOX_ENABLED
 #include "cy_serial_flash_qspi.h"
 #include "cycfg_qspi_memslot.h"
 #endif
@@ -143,25 +170,24 @@ void lock_task(void *arg)
 	//vTaskDelay(20000);
 	/* Initialize hardware */
 	char topic[] = "lock";
-	char data[128];
+	uint32_t command;
 	int value = 0;
 
 	float degrees = 0;
 	float dutycycle = 0;
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
-	vTaskDelay(1000);
+	topic_config_t topic_config = TOPIC_CONFIG_VALUE;
+	if (subscribe_request(topic, &topic_config) == CY_MQTT_QOS_INVALID){
+		printf("Subscription to %s failed\n", topic);
+	}
 	cyhal_gpio_write_internal((P5_4), 0);
 	for (;;)
 	{
-		QueueHandle_t queue1 = get_queue_for_topic(topic);
-		xQueueReceive(queue1, &data, pdMS_TO_TICKS(portMAX_DELAY));
+		if (!topic_receive_value(topic, &command, portMAX_DELAY)){continue;}
 
-		if(data[0] == '0'){ //unlock
+		if(command == 0){ //unlock
 			value = 0;
 			degrees = 160;
-		}else if(data[0] == '1'){ //lock
+		}else if(command == 1){ //lock
 			value = 1;
 			degrees = 70;
 		}else{continue;}
@@ -193,11 +219,12 @@ void buttonTask(void *arg)
 	while(mqttConnected == 0){}
 
 	char topic[] = "button";
-	char data[128] = "0";
+	telemetry_sample_t sample;
+	snapshot_member_t *member = BUTTON_IN_SNAPSHOT ? snapshot_register(topic) : NULL;
 	int value = 0;
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+	if (!publisher_set_rate_limit(topic, EDGE_SENSOR_PUBLISH_RATE, EDGE_SENSOR_PUBLISH_BURST)){
+		printf("Rate limit for %s could not be set\n", topic);
+	}
 	vTaskDelay(1000);
 	int prevValue = 0;
 	for (;;)
@@ -208,14 +235,8 @@ void buttonTask(void *arg)
 		}
 
 		prevValue = value;
-		//sprintf(data, "%d", value);
-		if(value == 0){
-			data[0] = '0';
-		}else{
-			data[0] = '1';
-		}
-		//data[1] = 0;
-		PublishMessage( data, topic);
+		telemetry_sample_init(&sample, TELEMETRY_TYPE_BUTTON, TELEMETRY_UNIT_NONE, (value == 0) ? 0 : 1, 0);
+		snapshot_report(member, topic, &sample, true);
 		vTaskDelay(10);
 	}
 }
@@ -233,21 +254,20 @@ void buzzer_task(void *arg)
 	//vTaskDelay(20000);
 	/* Initialize hardware */
 	char topic[] = "buzzer";
-	char data[128] = "0";
+	uint32_t command;
 	int value = 0;
 
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
-	vTaskDelay(1000);
+	topic_config_t topic_config = TOPIC_CONFIG_VALUE;
+	if (subscribe_request(topic, &topic_config) == CY_MQTT_QOS_INVALID){
+		printf("Subscription to %s failed\n", topic);
+	}
 	for (;;)
 	{
-		QueueHandle_t queue1 = get_queue_for_topic(topic);
-		xQueueReceive(queue1, &data, pdMS_TO_TICKS(portMAX_DELAY));
+		if (!topic_receive_value(topic, &command, portMAX_DELAY)){continue;}
 
-		if(data[0] == '0'){
+		if(command == 0){
 			value = 0;
-		}else if(data[0] == '1'){
+		}else if(command == 1){
 			value = 1;
 		}else{continue;}
 
@@ -269,7 +289,7 @@ void ledTask(void *arg)
 	while(mqttConnected == 0){}
 	/* Initialize hardware */
 	char topic[] = "led";
-	char data[128] = "3";
+	uint32_t command;
 	int value = 0;
 
 	//printf("Value = %s \n", data);
@@ -280,18 +300,17 @@ void ledTask(void *arg)
 	//printf("Value2 = %d \n", value);
 
 	//subscribe_to_topic(topic);
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
-	vTaskDelay(1000);
+	topic_config_t topic_config = TOPIC_CONFIG_VALUE;
+	if (subscribe_request(topic, &topic_config) == CY_MQTT_QOS_INVALID){
+		printf("Subscription to %s failed\n", topic);
+	}
 	for (;;)
 	{
-		QueueHandle_t queue1 = get_queue_for_topic(topic);
-		xQueueReceive(queue1, &data, pdMS_TO_TICKS(portMAX_DELAY));
+		if (!topic_receive_value(topic, &command, portMAX_DELAY)){continue;}
 
 		//sscanf(data, "%d", &value);
 
-		if(data[0] == '1'){
+		if(command == 1){
 			value = 0;
 		}else{
 			value = 1;
@@ -313,20 +332,19 @@ void lampTask(void *arg)
 	while(mqttConnected == 0){}
 	/* Initialize hardware */
 	char topic[] = "led";
-	char data[128] = "3";
+	uint32_t command;
 	int value = 0;
 
 	//subscribe_to_topic(topic);
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
-	vTaskDelay(1000);
+	topic_config_t topic_config = TOPIC_CONFIG_VALUE;
+	if (subscribe_request(topic, &topic_config) == CY_MQTT_QOS_INVALID){
+		printf("Subscription to %s failed\n", topic);
+	}
 	for (;;)
 	{
-		QueueHandle_t queue1 = get_queue_for_topic(topic);
-		xQueueReceive(queue1, &data, pdMS_TO_TICKS(portMAX_DELAY));
+		if (!topic_receive_value(topic, &command, portMAX_DELAY)){continue;}
 
-		if(data[0] == '1'){
+		if(command == 1){
 			value = 1;
 		}else{
 			value = 0;
@@ -344,17 +362,16 @@ void thermistorTask(void *arg)
 	while(mqttConnected == 0){}
 	/* Initialize hardware */
 	char topic[] = "thermistor";
-	char data[20];
-	int value = 0;
+	telemetry_sample_t sample;
+	snapshot_member_t *member = THERMISTOR_IN_SNAPSHOT ? snapshot_register(topic) : NULL;
 	//subscribe_to_topic(topic);
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
 	for (;;)
 	{
         float temperature = mtb_thermistor_ntc_gpio_get_temp(&thermistor);
-		sprintf(data, "%.2f", temperature);
-        PublishMessage( data, topic);
+		/* Hundredths of a degree, rounded half away from zero */
+		int32_t centi_celsius = (int32_t)(temperature * 100.0f + ((temperature < 0.0f) ? -0.5f : 0.5f));
+		telemetry_sample_init(&sample, TELEMETRY_TYPE_TEMPERATURE, TELEMETRY_UNIT_CELSIUS, centi_celsius, -2);
+		snapshot_report(member, topic, &sample, false);
 		vTaskDelay(100000);
 	}
 }
@@ -371,7 +388,7 @@ void pirTask(void *arg)
 	for (;;)
 	{
 		pirValue = cyhal_gpio_read(P8_0);
-		printf("PIR VALUE: %d\n", pirValue);
+		LOG_DBG("PIR VALUE: %d", pirValue);
 		if(pirValue == 1){
 			//printf("PIR ACTIVATED\n");
 		}
@@ -388,11 +405,12 @@ void radarTask(void *arg)
 
 
 	char topic[] = "radar";
-	char data[128] = "0";
+	telemetry_sample_t sample;
+	snapshot_member_t *member = RADAR_IN_SNAPSHOT ? snapshot_register(topic) : NULL;
 	int value = 0;
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+	if (!publisher_set_rate_limit(topic, EDGE_SENSOR_PUBLISH_RATE, EDGE_SENSOR_PUBLISH_BURST)){
+		printf("Rate limit for %s could not be set\n", topic);
+	}
 	vTaskDelay(1000);
 	int prevValue = 0;
 	for (;;)
@@ -403,14 +421,8 @@ void radarTask(void *arg)
 		}
 
 		prevValue = value;
-		//sprintf(data, "%d", value);
-		if(value == 0){
-			data[0] = '0';
-		}else{
-			data[0] = '1';
-		}
-		//data[1] = 0;
-		PublishMessage( data, topic);
+		telemetry_sample_init(&sample, TELEMETRY_TYPE_PRESENCE, TELEMETRY_UNIT_NONE, (value == 0) ? 0 : 1, 0);
+		snapshot_report(member, topic, &sample, true);
 		vTaskDelay(10);
 	}
 }
@@ -421,11 +433,9 @@ void piezoTask(void *arg){
 	while(mqttConnected == 0){}
 		/* Initialize hardware */
 	char topic[] = "device1/piezo";
-	char data[20];
+	telemetry_sample_t sample;
+	snapshot_member_t *member = PIEZO_IN_SNAPSHOT ? snapshot_register("piezo") : NULL;
 	//subscribe_to_topic(topic);
-	subscriber_data_t subscriber_q_data;
-	subscriber_q_data.topic = topic;
-	xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
 
 	/* ADC Channel 0 Object */
 	cyhal_adc_channel_t adc_chan_0_obj;
@@ -443,8 +453,8 @@ void piezoTask(void *arg){
 	for(;;){
 		uint32_t adc_out = cyhal_adc_read_uv(&adc_chan_0_obj);
 		if(adc_out >threshold){
-			sprintf(data, "%.2lu", adc_out);
-			PublishMessage( data, topic);
+			telemetry_sample_init(&sample, TELEMETRY_TYPE_VIBRATION, TELEMETRY_UNIT_MICROVOLT, (int32_t)adc_out, 0);
+			snapshot_report(member, topic, &sample, true);
 			vTaskDelay(2000);
 		}
 		vTaskDelay(50);
@@ -505,13 +515,15 @@ int main()
     CY_ASSERT(result == CY_RSLT_SUCCESS);
 
 
-#if defined(CY_DEVICE_PSOC6A512K)
+#if defined(CY_DEVICE_PSOC6A512K) || OUTBOX_ENABLED
     /* Initialize the QSPI serial NOR flash with clock frequency of 50 MHz. */
     const uint32_t bus_frequency = 50000000lu;
     cy_serial_flash_qspi_init(smifMemConfigs[0], CYBSP_QSPI_D0, CYBSP_QSPI_D1,
                                   CYBSP_QSPI_D2, CYBSP_QSPI_D3, NC, NC, NC, NC,
                                   CYBSP_QSPI_SCK, CYBSP_QSPI_SS, bus_frequency);
+#endif
 
+#if OUTBOX_FLASH_XIP
     /* Enable the XIP mode to get the Wi-Fi firmware from the external flash. */
     cy_serial_flash_qspi_enable_xip(true);
 #endif
@@ -557,6 +569,10 @@ int main()
 
 
 
+	 /* Create the Log task first, it prints the records of all other tasks. */
+	 xTaskCreate(log_task, "Log task", LOG_TASK_STACK_SIZE,
+				 NULL, LOG_TASK_PRIORITY, &log_task_handle);
+
 	 /* Create the MQTT Client task. */
 	 xTaskCreate(mqtt_client_task, "MQTT Client task", MQTT_CLIENT_TASK_STACK_SIZE*2,
 				 NULL, MQTT_CLIENT_TASK_PRIORITY, NULL);
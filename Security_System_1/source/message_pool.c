@@ -0,0 +1,185 @@
+/******************************************************************************
+* File Name:   message_pool.c
+*
+* Description: This file contains a statically sized pool of reference-counted
+*              message blocks. Blocks are allocated and released without
+*              locks or heap calls, so the pool can be used from the MQTT
+*              receive context.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "cyhal.h"
+
+#include "message_pool.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (MESSAGE_POOL_BLOCKS > 32u) || (MESSAGE_POOL_BLOCKS == 0u)
+    #error "MESSAGE_POOL_BLOCKS must be between 1 and 32."
+#endif
+
+/* Bitmap with one bit set for every block of the pool. */
+#define MESSAGE_POOL_ALL_FREE   ((MESSAGE_POOL_BLOCKS == 32u) ? 0xFFFFFFFFu : \
+                                 ((1u << MESSAGE_POOL_BLOCKS) - 1u))
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Storage of the message blocks. */
+static message_block_t message_pool_blocks[MESSAGE_POOL_BLOCKS];
+
+/* Bitmap of the free blocks, bit n is set when block n is free. */
+static atomic_uint message_pool_free = MESSAGE_POOL_ALL_FREE;
+
+/* Usage counters. */
+static atomic_uint message_pool_in_use = 0;
+static atomic_uint message_pool_high_water = 0;
+static atomic_uint message_pool_exhausted = 0;
+
+/******************************************************************************
+ * Function Name: message_pool_alloc
+ ******************************************************************************
+ * Summary:
+ *  Takes a free block from the pool. The lowest free bit of the bitmap is
+ *  claimed with a compare-and-swap, which is retried if another context
+ *  changed the bitmap in between. The block is returned with a reference
+ *  count of one.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  message_block_t * : Allocated block, NULL if the pool is exhausted
+ *
+ ******************************************************************************/
+message_block_t *message_pool_alloc(void)
+{
+    unsigned int free_mask = atomic_load(&message_pool_free);
+    unsigned int index;
+    unsigned int in_use;
+    unsigned int high_water;
+
+    do
+    {
+        if (free_mask == 0u)
+        {
+            atomic_fetch_add(&message_pool_exhausted, 1u);
+            return NULL;
+        }
+
+        /* Index of the lowest set bit. */
+        index = __CLZ(__RBIT(free_mask));
+    } while (!atomic_compare_exchange_weak(&message_pool_free, &free_mask,
+                                           free_mask & ~(1u << index)));
+
+    /* Track the largest number of blocks in use at once. */
+    in_use = atomic_fetch_add(&message_pool_in_use, 1u) + 1u;
+    high_water = atomic_load(&message_pool_high_water);
+    while ((in_use > high_water) &&
+           !atomic_compare_exchange_weak(&message_pool_high_water, &high_water, in_use))
+    {
+    }
+
+    atomic_store(&message_pool_blocks[index].ref_count, 1u);
+    return &message_pool_blocks[index];
+}
+
+/******************************************************************************
+ * Function Name: message_pool_retain
+ ******************************************************************************
+ * Summary:
+ *  Adds a reference to a block.
+ *
+ * Parameters:
+ *  message_block_t *block : Block allocated from the pool
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void message_pool_retain(message_block_t *block)
+{
+    atomic_fetch_add(&block->ref_count, 1u);
+}
+
+/******************************************************************************
+ * Function Name: message_pool_release
+ ******************************************************************************
+ * Summary:
+ *  Drops a reference to a block. The block returns to the pool when its last
+ *  reference is dropped.
+ *
+ * Parameters:
+ *  message_block_t *block : Block allocated from the pool
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void message_pool_release(message_block_t *block)
+{
+    unsigned int index = (unsigned int) (block - message_pool_blocks);
+
+    if (atomic_fetch_sub(&block->ref_count, 1u) == 1u)
+    {
+        atomic_fetch_sub(&message_pool_in_use, 1u);
+        atomic_fetch_or(&message_pool_free, 1u << index);
+    }
+}
+
+/******************************************************************************
+ * Function Name: message_pool_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Reads the usage counters of the pool.
+ *
+ * Parameters:
+ *  message_pool_stats_t *stats : Structure that receives the counters
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void message_pool_get_stats(message_pool_stats_t *stats)
+{
+    stats->in_use = atomic_load(&message_pool_in_use);
+    stats->high_water = atomic_load(&message_pool_high_water);
+    stats->exhausted = atomic_load(&message_pool_exhausted);
+}
+
+/* [] END OF FILE */
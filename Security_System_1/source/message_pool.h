@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name:   message_pool.h
+*
+* Description: This file is the public interface of message_pool.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef MESSAGE_POOL_H_
+#define MESSAGE_POOL_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "topic_registry.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of message blocks in the pool. The free list is a 32-bit bitmap, so
+ * the pool cannot hold more than 32 blocks.
+ */
+#define MESSAGE_POOL_BLOCKS                (16u)
+
+/* Largest payload (excluding the null terminator) a message block can hold.
+ * Longer payloads are truncated.
+ */
+#define MESSAGE_POOL_PAYLOAD_SIZE          (128u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Reference-counted message block. */
+typedef struct
+{
+    atomic_uint ref_count;
+    uint16_t topic_len;
+    uint16_t payload_len;
+    char topic[TOPIC_MAX_LENGTH + 1];               /* Null-terminated */
+    char payload[MESSAGE_POOL_PAYLOAD_SIZE + 1];    /* Null-terminated */
+} message_block_t;
+
+/* Usage counters of the pool. */
+typedef struct
+{
+    uint32_t in_use;            /* Blocks currently allocated */
+    uint32_t high_water;        /* Most blocks ever allocated at once */
+    uint32_t exhausted;         /* Allocations that failed for lack of blocks */
+} message_pool_stats_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+message_block_t *message_pool_alloc(void);
+void message_pool_retain(message_block_t *block);
+void message_pool_release(message_block_t *block);
+void message_pool_get_stats(message_pool_stats_t *stats);
+
+#endif /* MESSAGE_POOL_H_ */
+
+/* [] END OF FILE */
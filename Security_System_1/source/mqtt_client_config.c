@@ -143,7 +143,7 @@ cy_mqtt_connect_info_t connection_info =
     .username_len = 0,
     .password = NULL,
     .password_len = 0,
-    .clean_session = true,
+    .clean_session = (MQTT_PERSISTENT_SESSION == 0),
     .keep_alive_sec = MQTT_KEEP_ALIVE_SECONDS,
 #if ENABLE_LWT_MESSAGE
     .will_info = &will_msg_info
@@ -55,6 +55,10 @@
 #include "mqtt_task.h"
 #include "subscriber_task.h"
 #include "publisher_task.h"
+#include "snapshot_task.h"
+#include "outbox_task.h"
+#include "link_quality.h"
+#include "wire_stats.h"
 
 /* Configuration file for Wi-Fi and MQTT client */
 #include "wifi_config.h"
@@ -127,6 +131,20 @@ QueueHandle_t mqtt_task_q;
 /* Flag to denote initialization status of various operations. */
 uint32_t status_flag;
 
+/* Connection state for other tasks to wait on, see CONNECTION_WIFI_UP_BIT
+ * and CONNECTION_MQTT_UP_BIT. Created before any task that uses it.
+ */
+EventGroupHandle_t mqtt_connection_events;
+
+/* Connection statistics, only written by the MQTT client task. */
+static mqtt_connection_stats_t connection_stats;
+
+/* State of the random generator of the backoff jitter. */
+static uint32_t connection_random_state;
+
+/* Tick of the last successful MQTT connection. */
+static TickType_t connection_up_tick;
+
 /* Pointer to the network buffer needed by the MQTT library for MQTT send and 
  * receive operations.
  */
@@ -138,6 +156,12 @@ uint8_t *mqtt_network_buffer = NULL;
 static cy_rslt_t wifi_connect(void);
 static cy_rslt_t mqtt_init(void);
 static cy_rslt_t mqtt_connect(void);
+static void connection_establish(void);
+static void connection_recover(TickType_t outage_tick, bool link_lost);
+static void connection_simulate_outage(void);
+static void connection_seed_random(void);
+static uint32_t connection_backoff_ms(uint32_t attempt);
+static void connection_publish_stats(void);
 
 static void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *user_data);
 static void cleanup(void);
@@ -171,18 +195,35 @@ void mqtt_client_task(void *pvParameters)
 
 	printf("Adcded \n");
     mqtt_task_cmd_t mqtt_status;
-    subscriber_data_t subscriber_q_data;
-    publisher_data_t publisher_q_data;
 
     /* Configure the Wi-Fi interface as a Wi-Fi STA (i.e. Client). */
     cy_wcm_config_t config = {.interface = CY_WCM_INTERFACE_TYPE_STA};
 
+    /* Simulated outages wake the task up while the connection is up. */
+    const TickType_t outage_interval = (SIMULATED_OUTAGE_INTERVAL_MS > 0u) ?
+                                       pdMS_TO_TICKS(SIMULATED_OUTAGE_INTERVAL_MS) : portMAX_DELAY;
+
     /* To avoid compiler warnings */
     (void) pvParameters;
 
     /* Create a message queue to communicate with other tasks and callbacks. */
     mqtt_task_q = xQueueCreate(MQTT_TASK_QUEUE_LENGTH, sizeof(mqtt_task_cmd_t));
 
+    /* Create the event group that exposes the connection state. */
+    mqtt_connection_events = xEventGroupCreate();
+    if (mqtt_connection_events == NULL)
+    {
+        printf("\nFailed to create the connection event group!\n");
+        goto exit_cleanup;
+    }
+
+    /* Create the stall timer of the link quality estimator. */
+    if (!link_quality_init())
+    {
+        printf("\nFailed to create the link stall timer!\n");
+        goto exit_cleanup;
+    }
+
     /* Initialize the Wi-Fi Connection Manager and jump to the cleanup block 
      * upon failure.
      */
@@ -198,22 +239,24 @@ void mqtt_client_task(void *pvParameters)
     status_flag |= WCM_INITIALIZED;
     printf("\nWi-Fi Connection Manager initialized.\n");
 
-    /* Initiate connection to the Wi-Fi AP and cleanup if the operation fails. */
-    if (CY_RSLT_SUCCESS != wifi_connect())
+    connection_seed_random();
+
+    /* Set-up the MQTT client and jump to the cleanup block upon failure. */
+    if (CY_RSLT_SUCCESS != mqtt_init())
     {
         goto exit_cleanup;
     }
 
-    /* Set-up the MQTT client and connect to the MQTT broker. Jump to the 
-     * cleanup block if any of the operations fail.
+    /* Connect to the Wi-Fi AP and the MQTT broker, retrying until both
+     * succeed.
      */
-    if ( (CY_RSLT_SUCCESS != mqtt_init()) || (CY_RSLT_SUCCESS != mqtt_connect()) )
+    connection_establish();
+
+    if (!publisher_create_queues())
     {
+        printf("Failed to create the publisher queues!\n");
         goto exit_cleanup;
     }
-
-
-    publisher_task_q = xQueueCreate(10, sizeof(publisher_data_t));
     subscriber_task_q = xQueueCreate(10, sizeof(subscriber_data_t));
 
 
@@ -228,92 +271,119 @@ void mqtt_client_task(void *pvParameters)
     /* Wait for the subscribe operation to complete. */
     vTaskDelay(pdMS_TO_TICKS(TASK_CREATION_DELAY_MS));
 
-    /* Create the publisher task and cleanup if the operation fails. */
-    if (pdPASS != xTaskCreate(publisher_task, "Publisher task", PUBLISHER_TASK_STACK_SIZE, 
-                              NULL, PUBLISHER_TASK_PRIORITY, &publisher_task_handle))
+    /* Create the publisher tasks, one per publish of the in-flight window,
+     * and cleanup if the operation fails.
+     */
+    for (uint32_t i = 0; i < PUBLISH_WINDOW_SIZE; i++)
     {
-        printf("Failed to create Publisher task!\n");
+        if (pdPASS != xTaskCreate(publisher_task, "Publisher task", PUBLISHER_TASK_STACK_SIZE,
+                                  NULL, PUBLISHER_TASK_PRIORITY, &publisher_task_handle[i]))
+        {
+            printf("Failed to create Publisher task!\n");
+            goto exit_cleanup;
+        }
+    }
+
+    /* Create the snapshot task and cleanup if the operation fails. */
+    if (pdPASS != xTaskCreate(snapshot_task, "Snapshot task", SNAPSHOT_TASK_STACK_SIZE,
+                              NULL, SNAPSHOT_TASK_PRIORITY, &snapshot_task_handle))
+    {
+        printf("Failed to create the Snapshot task!\n");
         goto exit_cleanup;
     }
 
-    print_heap_usage("mqtt_client_task: subscriber & publisher tasks created\n");
+    /* Create the outbox task and cleanup if the operation fails. */
+    if (pdPASS != xTaskCreate(outbox_task, "Outbox task", OUTBOX_TASK_STACK_SIZE,
+                              NULL, OUTBOX_TASK_PRIORITY, &outbox_task_handle))
+    {
+        printf("Failed to create the Outbox task!\n");
+        goto exit_cleanup;
+    }
+
+    print_heap_usage("mqtt_client_task: subscriber, publisher, snapshot & outbox tasks created\n");
 
     while (true)
     {
         /* Wait for results of MQTT operations from other tasks and callbacks. */
-        if (pdTRUE == xQueueReceive(mqtt_task_q, &mqtt_status, portMAX_DELAY))
+        if (pdTRUE != xQueueReceive(mqtt_task_q, &mqtt_status, outage_interval))
         {
-            /* In this code example, the disconnection from the MQTT Broker or 
-             * the Wi-Fi network is handled by the case 'HANDLE_DISCONNECTION'. 
-             * 
-             * The publish and subscribe failures (`HANDLE_MQTT_PUBLISH_FAILURE`
-             * and `HANDLE_MQTT_SUBSCRIBE_FAILURE`) does not initiate 
-             * reconnection in this example, but they can be handled as per the 
-             * application requirement in the following swich cases.
-             */
-            switch(mqtt_status)
+            connection_simulate_outage();
+            continue;
+        }
+
+        /* In this code example, the disconnection from the MQTT Broker or 
+         * the Wi-Fi network is handled by the case 'HANDLE_DISCONNECTION'. 
+         * 
+         * The publish and subscribe failures (`HANDLE_MQTT_PUBLISH_FAILURE`
+         * and `HANDLE_MQTT_SUBSCRIBE_FAILURE`) does not initiate 
+         * reconnection in this example, but they can be handled as per the 
+         * application requirement in the following swich cases.
+         */
+        switch(mqtt_status)
+        {
+            case HANDLE_MQTT_PUBLISH_FAILURE:
             {
-                case HANDLE_MQTT_PUBLISH_FAILURE:
-                {
-                    /* Handle Publish Failure here. */
-                    break;
-                }
+                /* Handle Publish Failure here. */
+                break;
+            }
+
+            case HANDLE_MQTT_SUBSCRIBE_FAILURE:
+            {
+                /* Handle Subscribe Failure here. */
+                break;
+            }
 
-                case HANDLE_MQTT_SUBSCRIBE_FAILURE:
+            case HANDLE_DISCONNECTION:
+            {
+                /* A notice about a connection that was already replaced. */
+                if (mqtt_is_connected())
                 {
-                    /* Handle Subscribe Failure here. */
                     break;
                 }
 
-                case HANDLE_DISCONNECTION:
+                /* Recovery time is reported from this point. */
+                TickType_t outage_tick = xTaskGetTickCount();
+
+                /* Although the connection with the MQTT Broker is lost, 
+                 * call the MQTT disconnect API for cleanup of threads and 
+                 * other resources before reconnection.
+                 */
+                cy_mqtt_disconnect(mqtt_connection);
+
+                connection_recover(outage_tick, true);
+                break;
+            }
+
+            case HANDLE_LINK_STALL:
+            {
+                if (!mqtt_is_connected())
                 {
-                    /* Deinit the publisher before initiating reconnections. */
-                    publisher_q_data.cmd = PUBLISHER_DEINIT;
-                    xQueueSend(publisher_task_q, &publisher_q_data, portMAX_DELAY);
-
-                    /* Although the connection with the MQTT Broker is lost, 
-                     * call the MQTT disconnect API for cleanup of threads and 
-                     * other resources before reconnection.
-                     */
-                    cy_mqtt_disconnect(mqtt_connection);
-
-                    /* Check if Wi-Fi connection is active. If not, update the 
-                     * status flag and initiate Wi-Fi reconnection.
-                     */
-                    if (cy_wcm_is_connected_to_ap() == 0)
-                    {
-                        status_flag &= ~(WIFI_CONNECTED);
-                        printf("\nInitiating Wi-Fi Reconnection...\n");
-                        if (CY_RSLT_SUCCESS != wifi_connect())
-                        {
-                            goto exit_cleanup;
-                        }
-                    }
-
-                    printf("\nInitiating MQTT Reconnection...\n");
-                    if (CY_RSLT_SUCCESS != mqtt_connect())
-                    {
-                        goto exit_cleanup;
-                    }
-
-                    /* Initiate MQTT subscribe post the reconnection. */
-                    subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
-                    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
-
-                    /* Initialize Publisher post the reconnection. */
-                    publisher_q_data.cmd = PUBLISHER_INIT;
-                    xQueueSend(publisher_task_q, &publisher_q_data, portMAX_DELAY);
                     break;
                 }
 
-                default:
-                    break;
+                TickType_t outage_tick = xTaskGetTickCount();
+
+                /* Several PUBACKs in a row are overdue by far: the link is
+                 * dead even though the keep-alive has not noticed yet.
+                 */
+                printf("\n%u PUBACKs in a row not received within %lu ms, dropping the MQTT connection.\n",
+                       (unsigned) LINK_STALL_COUNT, (unsigned long) link_quality_stall_ms());
+                cy_mqtt_disconnect(mqtt_connection);
+                status_flag &= ~(MQTT_CONNECTION_SUCCESS);
+                xEventGroupClearBits(mqtt_connection_events, CONNECTION_MQTT_UP_BIT);
+
+                connection_recover(outage_tick, true);
+                break;
             }
+
+            default:
+                break;
         }
     }
 
     /* Cleanup section: Delete subscriber and publisher tasks and perform
-     * cleanup for various operations based on the status_flag.
+     * cleanup for various operations based on the status_flag. Only reached
+     * when the start-up fails, connection losses never end here.
      */
     exit_cleanup:
     printf("\nTerminating Publisher and Subscriber tasks...\n");
@@ -321,9 +391,20 @@ void mqtt_client_task(void *pvParameters)
     {
         vTaskDelete(subscriber_task_handle);
     }
-    if (publisher_task_handle != NULL)
+    for (uint32_t i = 0; i < PUBLISH_WINDOW_SIZE; i++)
+    {
+        if (publisher_task_handle[i] != NULL)
+        {
+            vTaskDelete(publisher_task_handle[i]);
+        }
+    }
+    if (snapshot_task_handle != NULL)
     {
-        vTaskDelete(publisher_task_handle);
+        vTaskDelete(snapshot_task_handle);
+    }
+    if (outbox_task_handle != NULL)
+    {
+        vTaskDelete(outbox_task_handle);
     }
     cleanup();
     printf("\nCleanup Done\nTerminating the MQTT task...\n\n");
@@ -334,10 +415,9 @@ void mqtt_client_task(void *pvParameters)
  * Function Name: wifi_connect
  ******************************************************************************
  * Summary:
- *  Function that initiates connection to the Wi-Fi Access Point using the 
- *  specified SSID and PASSWORD. The connection is retried a maximum of 
- *  'MAX_WIFI_CONN_RETRIES' times with interval of 'WIFI_CONN_RETRY_INTERVAL_MS'
- *  milliseconds.
+ *  Function that makes one attempt to connect to the Wi-Fi Access Point using
+ *  the specified SSID and PASSWORD. Retries are left to
+ *  connection_establish().
  *
  * Parameters:
  *  void
@@ -349,54 +429,42 @@ void mqtt_client_task(void *pvParameters)
  ******************************************************************************/
 static cy_rslt_t wifi_connect(void)
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    cy_rslt_t result;
     cy_wcm_connect_params_t connect_param;
     cy_wcm_ip_address_t ip_address;
 
-    /* Check if Wi-Fi connection is already established. */
-    if (cy_wcm_is_connected_to_ap() == 0)
-    {
-        /* Configure the connection parameters for the Wi-Fi interface. */
-        memset(&connect_param, 0, sizeof(cy_wcm_connect_params_t));
-        memcpy(connect_param.ap_credentials.SSID, WIFI_SSID, sizeof(WIFI_SSID));
-        memcpy(connect_param.ap_credentials.password, WIFI_PASSWORD, sizeof(WIFI_PASSWORD));
-        connect_param.ap_credentials.security = WIFI_SECURITY;
+    /* Configure the connection parameters for the Wi-Fi interface. */
+    memset(&connect_param, 0, sizeof(cy_wcm_connect_params_t));
+    memcpy(connect_param.ap_credentials.SSID, WIFI_SSID, sizeof(WIFI_SSID));
+    memcpy(connect_param.ap_credentials.password, WIFI_PASSWORD, sizeof(WIFI_PASSWORD));
+    connect_param.ap_credentials.security = WIFI_SECURITY;
 
-        printf("\nWi-Fi Connecting to '%s'\n", connect_param.ap_credentials.SSID);
+    printf("\nWi-Fi Connecting to '%s'\n", connect_param.ap_credentials.SSID);
 
-        /* Connect to the Wi-Fi AP. */
-        for (uint32_t retry_count = 0; retry_count < MAX_WIFI_CONN_RETRIES; retry_count++)
-        {
-            result = cy_wcm_connect_ap(&connect_param, &ip_address);
-
-            if (result == CY_RSLT_SUCCESS)
-            {
-                printf("\nSuccessfully connected to Wi-Fi network '%s'.\n", connect_param.ap_credentials.SSID);
-
-                /* Set the appropriate bit in the status_flag to denote 
-                 * successful Wi-Fi connection, print the assigned IP address.
-                 */
-                status_flag |= WIFI_CONNECTED;
-                if (ip_address.version == CY_WCM_IP_VER_V4)
-                {
-                    printf("IPv4 Address Assigned: %s\n\n", ip4addr_ntoa((const ip4_addr_t *) &ip_address.ip.v4));
-                }
-                else if (ip_address.version == CY_WCM_IP_VER_V6)
-                {
-                    printf("IPv6 Address Assigned: %s\n\n", ip6addr_ntoa((const ip6_addr_t *) &ip_address.ip.v6));
-                }
-                return result;
-            }
+    /* Connect to the Wi-Fi AP. */
+    result = cy_wcm_connect_ap(&connect_param, &ip_address);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("Wi-Fi Connection failed. Error code:0x%0X.\n", (int)result);
+        return result;
+    }
 
-            printf("Wi-Fi Connection failed. Error code:0x%0X. Retrying in %d ms. Retries left: %d\n",
-                (int)result, WIFI_CONN_RETRY_INTERVAL_MS, (int)(MAX_WIFI_CONN_RETRIES - retry_count - 1));
-            vTaskDelay(pdMS_TO_TICKS(WIFI_CONN_RETRY_INTERVAL_MS));
-        }
+    printf("\nSuccessfully connected to Wi-Fi network '%s'.\n", connect_param.ap_credentials.SSID);
 
-        printf("\nExceeded maximum Wi-Fi connection attempts!\n");
-        printf("Wi-Fi connection failed after retrying for %d mins\n\n", 
-            (int)(WIFI_CONN_RETRY_INTERVAL_MS * MAX_WIFI_CONN_RETRIES) / 60000u);
+    /* Set the appropriate bit in the status_flag to denote successful Wi-Fi
+     * connection, print the assigned IP address.
+     */
+    status_flag |= WIFI_CONNECTED;
+    xEventGroupSetBits(mqtt_connection_events, CONNECTION_WIFI_UP_BIT);
+    if (ip_address.version == CY_WCM_IP_VER_V4)
+    {
+        printf("IPv4 Address Assigned: %s\n\n", ip4addr_ntoa((const ip4_addr_t *) &ip_address.ip.v4));
+    }
+    else if (ip_address.version == CY_WCM_IP_VER_V6)
+    {
+        printf("IPv6 Address Assigned: %s\n\n", ip6addr_ntoa((const ip6_addr_t *) &ip_address.ip.v6));
     }
+
     return result;
 }
 
@@ -425,7 +493,9 @@ static cy_rslt_t mqtt_init(void)
     result = cy_mqtt_init();
     CHECK_RESULT(result, LIBS_INITIALIZED, "\nMQTT library initialization failed!\n");
 
-    /* Allocate buffer for MQTT send and receive operations. */
+    /* Allocate the network buffer. Outgoing PUBLISH packets are sent from the
+     * publish slots, so it is sized for the incoming packets.
+     */
     mqtt_network_buffer = (uint8_t *) pvPortMalloc(sizeof(uint8_t) * MQTT_NETWORK_BUFFER_SIZE);
     if(mqtt_network_buffer == NULL)
     {
@@ -455,9 +525,8 @@ static cy_rslt_t mqtt_init(void)
  * Function Name: mqtt_connect
  ******************************************************************************
  * Summary:
- *  Function that initiates MQTT connect operation. The connection is retried
- *  a maximum of 'MAX_MQTT_CONN_RETRIES' times with interval of 
- *  'MQTT_CONN_RETRY_INTERVAL_MS' milliseconds.
+ *  Function that makes one MQTT connect attempt. Retries are left to
+ *  connection_establish().
  *
  * Parameters:
  *  void
@@ -473,9 +542,11 @@ static cy_rslt_t mqtt_connect(void)
 {
     /* Variable to indicate status of various operations. */
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    TickType_t connect_tick;
+    uint32_t connect_ms;
 
-    /* MQTT client identifier string. */
-    char mqtt_client_identifier[(MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1)] = MQTT_CLIENT_IDENTIFIER;
+    /* MQTT client identifier string, referenced by 'connection_info'. */
+    static char mqtt_client_identifier[(MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1)] = MQTT_CLIENT_IDENTIFIER;
 
     /* Configure the user credentials as a part of MQTT Connect packet */
     if (strlen(MQTT_USERNAME) > 0)
@@ -504,45 +575,305 @@ static cy_rslt_t mqtt_connect(void)
            broker_info.hostname_len,
            broker_info.hostname);
 
-    for (uint32_t retry_count = 0; retry_count < MAX_MQTT_CONN_RETRIES; retry_count++)
+    /* Establish the MQTT connection. */
+    connect_tick = xTaskGetTickCount();
+    result = cy_mqtt_connect(mqtt_connection, &connection_info);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("\nMQTT connection failed with error code 0x%0X.\n", (int)result);
+        return result;
+    }
+
+    /* Most of this is the TLS handshake, the rest the TCP connection and the
+     * CONNECT/CONNACK exchange.
+     */
+    connect_ms = (xTaskGetTickCount() - connect_tick) * portTICK_PERIOD_MS;
+    connection_stats.connects++;
+    connection_stats.last_connect_ms = connect_ms;
+    connection_stats.total_connect_ms += connect_ms;
+    if ((connection_stats.connects == 1) || (connect_ms < connection_stats.min_connect_ms))
+    {
+        connection_stats.min_connect_ms = connect_ms;
+    }
+    if (connect_ms > connection_stats.max_connect_ms)
     {
+        connection_stats.max_connect_ms = connect_ms;
+    }
+
+    printf("MQTT connection successful in %lu ms.\r\n", (unsigned long) connect_ms);
+
+    /* Set the appropriate bit in the status_flag to denote successful MQTT
+     * connection, and return the result to the calling function.
+     */
+    status_flag |= MQTT_CONNECTION_SUCCESS;
+    connection_up_tick = xTaskGetTickCount();
+    wire_stats_connection_reset();
+    xEventGroupSetBits(mqtt_connection_events, CONNECTION_MQTT_UP_BIT);
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: connection_establish
+ ******************************************************************************
+ * Summary:
+ *  Connection state machine. Connects to the Wi-Fi AP if the link is down,
+ *  then to the MQTT broker, and retries a failed step after a capped
+ *  exponential backoff with jitter, see 'RECONNECT_BACKOFF_BASE_MS'. The
+ *  backoff starts over once the Wi-Fi link is up. Returns only when the MQTT
+ *  connection is up; the application tasks keep running meanwhile, and
+ *  their publishes go to the outbox.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void connection_establish(void)
+{
+    cy_rslt_t result;
+    uint32_t attempt = 0;
+
+    while (!mqtt_is_connected())
+    {
+        TickType_t attempt_tick = xTaskGetTickCount();
+
         if (cy_wcm_is_connected_to_ap() == 0)
         {
-            printf("\nUnexpectedly disconnected from Wi-Fi network! \nInitiating Wi-Fi reconnection...\n");
             status_flag &= ~(WIFI_CONNECTED);
+            xEventGroupClearBits(mqtt_connection_events, CONNECTION_WIFI_UP_BIT);
 
-            /* Initiate Wi-Fi reconnection. */
             result = wifi_connect();
-            if (CY_RSLT_SUCCESS != result)
+            if (result == CY_RSLT_SUCCESS)
             {
-                return result;
+                attempt = 0;
             }
         }
+        else
+        {
+            result = mqtt_connect();
+        }
 
-        /* Establish the MQTT connection. */
-        result = cy_mqtt_connect(mqtt_connection, &connection_info);
+        connection_stats.radio_on_ms += (xTaskGetTickCount() - attempt_tick) * portTICK_PERIOD_MS;
 
-        if (result == CY_RSLT_SUCCESS)
+        if (result != CY_RSLT_SUCCESS)
         {
-            printf("MQTT connection successful.\r\n");
+            uint32_t delay_ms = connection_backoff_ms(attempt);
 
-            /* Set the appropriate bit in the status_flag to denote successful
-             * MQTT connection, and return the result to the calling function.
-             */
-            status_flag |= MQTT_CONNECTION_SUCCESS;
-            //mqttConnected = 1;
-            return result;
+            connection_stats.failed_attempts++;
+            attempt++;
+            printf("Retrying in %lu ms (attempt %lu)\n", (unsigned long) delay_ms,
+                   (unsigned long) attempt);
+            vTaskDelay(pdMS_TO_TICKS(delay_ms));
         }
+    }
+}
+
+/******************************************************************************
+ * Function Name: connection_recover
+ ******************************************************************************
+ * Summary:
+ *  Restores the connection after a loss, without tearing down the
+ *  application tasks: the publisher is paused, the connection re-established
+ *  with connection_establish(), then the subscriptions are restored, the
+ *  publisher resumed, the outbox replayed and the reconnection statistics
+ *  published. The keep-alive interval of the new connection is adapted,
+ *  see link_quality_next_keep_alive().
+ *
+ * Parameters:
+ *  TickType_t outage_tick : Tick at which the loss was noticed
+ *  bool link_lost : true if the connection was lost, false if it was
+ *                   dropped on purpose
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void connection_recover(TickType_t outage_tick, bool link_lost)
+{
+    subscriber_data_t subscriber_q_data;
+    uint32_t reconnect_ms;
+    uint32_t connected_ms = (outage_tick - connection_up_tick) * portTICK_PERIOD_MS;
 
-        printf("\nMQTT connection failed with error code 0x%0X. \nRetrying in %d ms. Retries left: %d\n", 
-               (int)result, MQTT_CONN_RETRY_INTERVAL_MS, (int)(MAX_MQTT_CONN_RETRIES - retry_count - 1));
-        vTaskDelay(pdMS_TO_TICKS(MQTT_CONN_RETRY_INTERVAL_MS));
+    /* Deinit the publisher before initiating reconnections. */
+    publisher_send_command(PUBLISHER_DEINIT);
+
+    connection_info.keep_alive_sec = link_quality_next_keep_alive(link_lost, connected_ms);
+    printf("\nConnection lasted %lu s, keep-alive of the next one %u s.\n",
+           (unsigned long) (connected_ms / 1000u), (unsigned) connection_info.keep_alive_sec);
+
+    printf("\nInitiating Reconnection...\n");
+    connection_establish();
+
+    reconnect_ms = (xTaskGetTickCount() - outage_tick) * portTICK_PERIOD_MS;
+    connection_stats.outages++;
+    connection_stats.last_reconnect_ms = reconnect_ms;
+    connection_stats.total_reconnect_ms += reconnect_ms;
+    if (reconnect_ms > connection_stats.max_reconnect_ms)
+    {
+        connection_stats.max_reconnect_ms = reconnect_ms;
     }
 
-    printf("\nExceeded maximum MQTT connection attempts\n");
-    printf("MQTT connection failed after retrying for %d mins\n\n", 
-           (int)(MQTT_CONN_RETRY_INTERVAL_MS * MAX_MQTT_CONN_RETRIES) / 60000u);
-    return result;
+    /* Restore every registered subscription post the reconnection. */
+    subscriber_q_data.cmd = RESUBSCRIBE_ALL_TOPICS;
+    subscriber_q_data.tick = outage_tick;
+    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+
+    /* Initialize Publisher post the reconnection. */
+    publisher_send_command(PUBLISHER_INIT);
+
+    /* Send what was stored during the outage. */
+    outbox_request_replay();
+
+    connection_publish_stats();
+}
+
+/******************************************************************************
+ * Function Name: connection_simulate_outage
+ ******************************************************************************
+ * Summary:
+ *  Drops the MQTT connection and the Wi-Fi link as an outage would, and
+ *  recovers from it, so that the reconnection time and the radio-on time can
+ *  be measured. Called every 'SIMULATED_OUTAGE_INTERVAL_MS' milliseconds.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void connection_simulate_outage(void)
+{
+    TickType_t outage_tick = xTaskGetTickCount();
+
+    printf("\nSimulating a connection outage...\n");
+
+    /* Disconnect cleanly first, so that the MQTT library does not report the
+     * loss of the link.
+     */
+    cy_mqtt_disconnect(mqtt_connection);
+    status_flag &= ~(MQTT_CONNECTION_SUCCESS);
+    xEventGroupClearBits(mqtt_connection_events, CONNECTION_MQTT_UP_BIT);
+
+    cy_wcm_disconnect_ap();
+
+    connection_recover(outage_tick, false);
+}
+
+/******************************************************************************
+ * Function Name: connection_seed_random
+ ******************************************************************************
+ * Summary:
+ *  Seeds the random generator of the backoff jitter with the MAC address,
+ *  so that devices started at the same time still draw different delays.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void connection_seed_random(void)
+{
+    cy_wcm_mac_t mac = { 0 };
+    uint32_t seed = Clock_GetTimeMs();
+
+    cy_wcm_get_mac_addr(CY_WCM_INTERFACE_TYPE_STA, &mac);
+    for (uint32_t i = 0; i < CY_WCM_MAC_ADDR_LEN; i++)
+    {
+        seed = (seed * 31u) + mac[i];
+    }
+
+    /* Xorshift never leaves the state 0. */
+    connection_random_state = (seed != 0) ? seed : 1u;
+}
+
+/******************************************************************************
+ * Function Name: connection_backoff_ms
+ ******************************************************************************
+ * Summary:
+ *  Returns the delay before a retry: a random value in [d/2, d], where d is
+ *  'RECONNECT_BACKOFF_BASE_MS' doubled for every failed attempt, capped at
+ *  'RECONNECT_BACKOFF_MAX_MS'.
+ *
+ * Parameters:
+ *  uint32_t attempt : Number of failed attempts before this one
+ *
+ * Return:
+ *  uint32_t : Delay in milliseconds
+ *
+ ******************************************************************************/
+static uint32_t connection_backoff_ms(uint32_t attempt)
+{
+    uint32_t ceiling = RECONNECT_BACKOFF_BASE_MS;
+
+    for (uint32_t i = 0; (i < attempt) && (ceiling < RECONNECT_BACKOFF_MAX_MS); i++)
+    {
+        ceiling *= 2u;
+    }
+    if (ceiling > RECONNECT_BACKOFF_MAX_MS)
+    {
+        ceiling = RECONNECT_BACKOFF_MAX_MS;
+    }
+
+    /* Xorshift32 */
+    connection_random_state ^= connection_random_state << 13;
+    connection_random_state ^= connection_random_state >> 17;
+    connection_random_state ^= connection_random_state << 5;
+
+    return (ceiling / 2u) + (connection_random_state % ((ceiling / 2u) + 1u));
+}
+
+/******************************************************************************
+ * Function Name: connection_publish_stats
+ ******************************************************************************
+ * Summary:
+ *  Publishes the reconnection statistics on
+ *  'MQTT_CONNECTION_DIAGNOSTICS_TOPIC' and the connection (handshake) times
+ *  on 'MQTT_HANDSHAKE_DIAGNOSTICS_TOPIC', as JSON objects.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void connection_publish_stats(void)
+{
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+
+    int written = snprintf(payload, sizeof(payload),
+                           "{\"outages\":%lu,\"reconnect_ms\":%lu,\"max_reconnect_ms\":%lu,"
+                           "\"avg_reconnect_ms\":%lu,\"failed_attempts\":%lu,\"radio_on_ms\":%lu}",
+                           (unsigned long) connection_stats.outages,
+                           (unsigned long) connection_stats.last_reconnect_ms,
+                           (unsigned long) connection_stats.max_reconnect_ms,
+                           (unsigned long) (connection_stats.total_reconnect_ms /
+                                            connection_stats.outages),
+                           (unsigned long) connection_stats.failed_attempts,
+                           (unsigned long) connection_stats.radio_on_ms);
+    if ((written > 0) && ((size_t) written < sizeof(payload)))
+    {
+        PublishMessage(payload, MQTT_CONNECTION_DIAGNOSTICS_TOPIC);
+    }
+
+    written = snprintf(payload, sizeof(payload),
+                       "{\"connects\":%lu,\"connect_ms\":%lu,\"min_connect_ms\":%lu,"
+                       "\"max_connect_ms\":%lu,\"avg_connect_ms\":%lu}",
+                       (unsigned long) connection_stats.connects,
+                       (unsigned long) connection_stats.last_connect_ms,
+                       (unsigned long) connection_stats.min_connect_ms,
+                       (unsigned long) connection_stats.max_connect_ms,
+                       (unsigned long) (connection_stats.total_connect_ms /
+                                        connection_stats.connects));
+    if ((written > 0) && ((size_t) written < sizeof(payload)))
+    {
+        PublishMessage(payload, MQTT_HANDSHAKE_DIAGNOSTICS_TOPIC);
+    }
 }
 
 /******************************************************************************
@@ -580,6 +911,7 @@ static void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, vo
         {
             /* Clear the status flag bit to indicate MQTT disconnection. */
             status_flag &= ~(MQTT_CONNECTION_SUCCESS);
+            xEventGroupClearBits(mqtt_connection_events, CONNECTION_MQTT_UP_BIT);
 
             /* MQTT connection with the MQTT broker is broken as the client
              * is unable to communicate with the broker. Set the appropriate
@@ -623,7 +955,9 @@ static void mqtt_event_callback(cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, vo
  ******************************************************************************
  * Summary:
  *  Function that generates unique client identifier for the MQTT client by
- *  appending a timestamp to a common prefix 'MQTT_CLIENT_IDENTIFIER'.
+ *  appending a timestamp to a common prefix 'MQTT_CLIENT_IDENTIFIER'. With
+ *  MQTT_PERSISTENT_SESSION the end of the MAC address is appended instead,
+ *  so that the broker finds the session again after a reconnection.
  *
  * Parameters:
  *  char *mqtt_client_identifier : Pointer to the string that stores the 
@@ -638,6 +972,25 @@ static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier)
 {
     cy_rslt_t status = CY_RSLT_SUCCESS;
 
+#if MQTT_PERSISTENT_SESSION
+    cy_wcm_mac_t mac = { 0 };
+
+    status = cy_wcm_get_mac_addr(CY_WCM_INTERFACE_TYPE_STA, &mac);
+    if (status != CY_RSLT_SUCCESS)
+    {
+        return status;
+    }
+
+    /* Check for errors from snprintf. */
+    if (0 > snprintf(mqtt_client_identifier,
+                     (MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1),
+                     MQTT_CLIENT_IDENTIFIER "%02x%02x%02x",
+                     mac[CY_WCM_MAC_ADDR_LEN - 3], mac[CY_WCM_MAC_ADDR_LEN - 2],
+                     mac[CY_WCM_MAC_ADDR_LEN - 1]))
+    {
+        status = ~CY_RSLT_SUCCESS;
+    }
+#else
     /* Check for errors from snprintf. */
     if (0 > snprintf(mqtt_client_identifier,
                      (MQTT_CLIENT_IDENTIFIER_MAX_LEN + 1),
@@ -646,11 +999,50 @@ static cy_rslt_t mqtt_get_unique_client_identifier(char *mqtt_client_identifier)
     {
         status = ~CY_RSLT_SUCCESS;
     }
+#endif /* MQTT_PERSISTENT_SESSION */
 
     return status;
 }
 #endif /* GENERATE_UNIQUE_CLIENT_ID */
 
+/******************************************************************************
+ * Function Name: mqtt_is_connected
+ ******************************************************************************
+ * Summary:
+ *  Tells whether the MQTT connection with the broker is up.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : true if connected, false otherwise
+ *
+ ******************************************************************************/
+bool mqtt_is_connected(void)
+{
+    return ((status_flag & MQTT_CONNECTION_SUCCESS) != 0);
+}
+
+/******************************************************************************
+ * Function Name: mqtt_get_connection_stats
+ ******************************************************************************
+ * Summary:
+ *  Copies the connection statistics since start-up.
+ *
+ * Parameters:
+ *  mqtt_connection_stats_t *stats : Receives the statistics
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_get_connection_stats(mqtt_connection_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = connection_stats;
+    taskEXIT_CRITICAL();
+}
+
 /******************************************************************************
  * Function Name: cleanup
  ******************************************************************************
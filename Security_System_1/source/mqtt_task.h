@@ -44,6 +44,7 @@
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "event_groups.h"
 #include "cy_mqtt_api.h"
 
 
@@ -54,6 +55,10 @@
 #define MQTT_CLIENT_TASK_PRIORITY       (2)
 #define MQTT_CLIENT_TASK_STACK_SIZE     (1024 * 2)
 
+/* Bits of 'mqtt_connection_events', set while the link is up. */
+#define CONNECTION_WIFI_UP_BIT          (1u << 0)
+#define CONNECTION_MQTT_UP_BIT          (1u << 1)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -62,18 +67,39 @@ typedef enum
 {
     HANDLE_MQTT_SUBSCRIBE_FAILURE,
     HANDLE_MQTT_PUBLISH_FAILURE,
-    HANDLE_DISCONNECTION
+    HANDLE_DISCONNECTION,
+    HANDLE_LINK_STALL           /* A publish waits too long for its PUBACK */
 } mqtt_task_cmd_t;
 
+/* Connection statistics since start-up. */
+typedef struct
+{
+    uint32_t outages;                   /* Connection losses */
+    uint32_t failed_attempts;           /* Failed Wi-Fi and MQTT connection attempts */
+    uint32_t last_reconnect_ms;         /* Time from loss to MQTT connection */
+    uint32_t max_reconnect_ms;
+    uint32_t total_reconnect_ms;
+    uint32_t radio_on_ms;               /* Time spent in connection attempts,
+                                         * the radio idles during the backoff */
+    uint32_t connects;                  /* Successful MQTT connections */
+    uint32_t last_connect_ms;           /* TCP, TLS handshake and CONNACK */
+    uint32_t min_connect_ms;
+    uint32_t max_connect_ms;
+    uint32_t total_connect_ms;
+} mqtt_connection_stats_t;
+
 /*******************************************************************************
  * Extern variables
  ******************************************************************************/
 extern cy_mqtt_t mqtt_connection;
 extern QueueHandle_t mqtt_task_q;
+extern EventGroupHandle_t mqtt_connection_events;
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
 void mqtt_client_task(void *pvParameters);
+bool mqtt_is_connected(void);
+void mqtt_get_connection_stats(mqtt_connection_stats_t *stats);
 
 #endif /* MQTT_TASK_H_ */
 
@@ -0,0 +1,870 @@
+/******************************************************************************
+* File Name:   outbox_task.c
+*
+* Description: This file contains the store-and-forward outbox. Messages
+*              that cannot be published while the broker is unreachable are
+*              appended to a log in the external QSPI NOR flash, and the
+*              outbox task replays them in order, throttled, once the MQTT
+*              connection is back. The log survives a reset.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "mqtt_task.h"
+#include "publisher_task.h"
+#include "outbox_task.h"
+
+#if OUTBOX_ENABLED
+#include "cy_serial_flash_qspi.h"
+#endif
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Marks a sector that belongs to the outbox ("OBX1"). */
+#define OUTBOX_SECTOR_MAGIC             (0x3158424Fu)
+
+/* States of a record. NOR flash bits can only be cleared between erases,
+ * so a record moves from ERASED to VALID to SENT by programming its state
+ * byte again. A record whose state is still ERASED was torn by a reset
+ * while it was written.
+ */
+#define OUTBOX_STATE_ERASED             (0xFFu)
+#define OUTBOX_STATE_VALID              (0xFEu)
+#define OUTBOX_STATE_SENT               (0x00u)
+
+/* Records are 4-byte aligned. */
+#define OUTBOX_ALIGN(len)               (((len) + 3u) & ~3u)
+
+/* Interval in milliseconds after which the replay of a message that could
+ * not be handed to the publisher is retried.
+ */
+#define OUTBOX_RETRY_MS                 (1000u)
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Header at the start of every outbox sector. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;          /* Increases by one for every opened sector */
+    uint32_t erase_count;       /* Erase cycles of the sector */
+    uint32_t reserved;
+} outbox_sector_header_t;
+
+/* Header of a record, followed by the topic and the payload. */
+typedef struct
+{
+    uint8_t state;
+    uint8_t topic_len;
+    uint16_t payload_len;
+} outbox_record_header_t;
+
+/* Position of a record in the log. */
+typedef struct
+{
+    uint32_t sector;
+    uint32_t offset;
+} outbox_pos_t;
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static bool outbox_init(void);
+static bool outbox_flash_read(uint32_t addr, void *buf, size_t len);
+static bool outbox_flash_write(uint32_t addr, const void *buf, size_t len);
+static bool outbox_flash_erase(uint32_t addr, size_t len);
+static void outbox_lock(void);
+static void outbox_unlock(void);
+static uint32_t outbox_addr(uint32_t sector, uint32_t offset);
+static bool outbox_read_sector_header(uint32_t sector, outbox_sector_header_t *header);
+static bool outbox_read_record(const outbox_pos_t *pos, outbox_record_header_t *header);
+static bool outbox_open_sector(uint32_t sector);
+static uint32_t outbox_count_valid(outbox_pos_t pos);
+static bool outbox_peek(outbox_pos_t *pos, char *topic, uint8_t *payload,
+                        size_t *payload_len);
+static void outbox_mark_sent(const outbox_pos_t *pos);
+static void outbox_replay(void);
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Outbox Task handle */
+TaskHandle_t outbox_task_handle;
+
+/* Serializes the flash accesses of the outbox. */
+static SemaphoreHandle_t outbox_mutex;
+
+/* Set once the log has been scanned, before that nothing is stored. */
+static volatile bool outbox_ready = false;
+
+/* Location of the log in the external flash. */
+static uint32_t outbox_base;
+static uint32_t outbox_sector_size;
+static uint32_t outbox_sector_count;
+
+/* Next record to write, and first record that may still be unsent. */
+static outbox_pos_t outbox_write;
+static outbox_pos_t outbox_read;
+
+/* Sequence number of the sector being written. */
+static uint32_t outbox_write_sequence;
+
+/* Counters, protected by 'outbox_mutex'. */
+static outbox_stats_t outbox_stats;
+
+/******************************************************************************
+ * Function Name: outbox_task
+ ******************************************************************************
+ * Summary:
+ *  Task that recovers the outbox log from the flash and replays the stored
+ *  messages whenever outbox_request_replay() is called, and once at start
+ *  for the messages left from before a reset.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void outbox_task(void *pvParameters)
+{
+    /* To avoid compiler warnings */
+    (void)pvParameters;
+
+    if (!outbox_init())
+    {
+        printf("  Outbox: Not available, unsent messages will be dropped\n");
+        outbox_task_handle = NULL;
+        vTaskDelete(NULL);
+    }
+
+    printf("  Outbox: %lu messages pending, sectors erased up to %lu times\n",
+           (unsigned long) outbox_stats.pending, (unsigned long) outbox_stats.max_erase_count);
+
+    while (true)
+    {
+        outbox_replay();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/******************************************************************************
+ * Function Name: outbox_store
+ ******************************************************************************
+ * Summary:
+ *  Appends a message to the outbox log. When the log is full, the sector
+ *  holding the oldest messages is discarded. Appending the first record of
+ *  a sector erases it, which blocks the caller for the sector erase time.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *
+ * Return:
+ *  bool : true if the message was stored, false otherwise
+ *
+ ******************************************************************************/
+bool outbox_store(const char *topic, size_t topic_len, const void *payload,
+                  size_t payload_len)
+{
+    uint8_t record[OUTBOX_ALIGN(sizeof(outbox_record_header_t) + TOPIC_MAX_LENGTH +
+                                PUBLISH_PAYLOAD_SIZE)];
+    outbox_record_header_t header;
+    size_t record_len = OUTBOX_ALIGN(sizeof(header) + topic_len + payload_len);
+    uint8_t state = OUTBOX_STATE_VALID;
+    bool stored = false;
+
+    if (!outbox_ready || (topic_len == 0) || (topic_len > TOPIC_MAX_LENGTH) ||
+        (payload_len > PUBLISH_PAYLOAD_SIZE))
+    {
+        return false;
+    }
+
+    /* The state byte is left erased until the whole record is written. */
+    header.state = OUTBOX_STATE_ERASED;
+    header.topic_len = (uint8_t) topic_len;
+    header.payload_len = (uint16_t) payload_len;
+    memset(record, 0xFF, record_len);
+    memcpy(record, &header, sizeof(header));
+    memcpy(&record[sizeof(header)], topic, topic_len);
+    memcpy(&record[sizeof(header) + topic_len], payload, payload_len);
+
+    outbox_lock();
+    if ((outbox_write.offset + record_len > outbox_sector_size) &&
+        !outbox_open_sector((outbox_write.sector + 1u) % outbox_sector_count))
+    {
+        outbox_unlock();
+        return false;
+    }
+
+    uint32_t addr = outbox_addr(outbox_write.sector, outbox_write.offset);
+    if (outbox_flash_write(addr, record, record_len) &&
+        outbox_flash_write(addr, &state, sizeof(state)))
+    {
+        stored = true;
+        outbox_stats.pending++;
+        outbox_stats.stored++;
+    }
+
+    /* A failed write leaves a torn record, which the reader skips. */
+    outbox_write.offset += record_len;
+    outbox_unlock();
+
+    return stored;
+}
+
+/******************************************************************************
+ * Function Name: outbox_request_replay
+ ******************************************************************************
+ * Summary:
+ *  Wakes the outbox task to replay the stored messages, e.g. after the MQTT
+ *  connection has been restored.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void outbox_request_replay(void)
+{
+    if (outbox_task_handle != NULL)
+    {
+        xTaskNotifyGive(outbox_task_handle);
+    }
+}
+
+/******************************************************************************
+ * Function Name: outbox_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the counters of the outbox.
+ *
+ * Parameters:
+ *  outbox_stats_t *stats : Receives the counters
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void outbox_get_stats(outbox_stats_t *stats)
+{
+    if (!outbox_ready)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    outbox_lock();
+    *stats = outbox_stats;
+    outbox_unlock();
+}
+
+/******************************************************************************
+ * Function Name: outbox_init
+ ******************************************************************************
+ * Summary:
+ *  Locates the outbox at the end of the external flash and recovers the log:
+ *  the newest sector continues to be written, and the replay starts at the
+ *  oldest record that was not sent. An unformatted outbox is started in its
+ *  first sector.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : true if the outbox is ready, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_init(void)
+{
+    outbox_sector_header_t header;
+    outbox_record_header_t record;
+    uint32_t newest = 0;
+    uint32_t oldest = 0;
+    uint32_t newest_sequence = 0;
+    uint32_t oldest_sequence = UINT32_MAX;
+    bool formatted = false;
+
+#if OUTBOX_ENABLED
+    size_t flash_size = cy_serial_flash_qspi_get_size();
+
+    if (flash_size < OUTBOX_REGION_SIZE)
+    {
+        return false;
+    }
+
+    outbox_base = (uint32_t) (flash_size - OUTBOX_REGION_SIZE);
+    outbox_sector_size = (uint32_t) cy_serial_flash_qspi_get_erase_size(outbox_base);
+#endif
+
+    if ((outbox_sector_size <= sizeof(outbox_sector_header_t)) ||
+        (OUTBOX_REGION_SIZE / outbox_sector_size < 2u))
+    {
+        return false;
+    }
+    outbox_sector_count = OUTBOX_REGION_SIZE / outbox_sector_size;
+
+    outbox_mutex = xSemaphoreCreateMutex();
+    if (outbox_mutex == NULL)
+    {
+        return false;
+    }
+
+    outbox_lock();
+    for (uint32_t sector = 0; sector < outbox_sector_count; sector++)
+    {
+        if (!outbox_read_sector_header(sector, &header))
+        {
+            continue;
+        }
+
+        formatted = true;
+        if (header.erase_count > outbox_stats.max_erase_count)
+        {
+            outbox_stats.max_erase_count = header.erase_count;
+        }
+        if (header.sequence >= newest_sequence)
+        {
+            newest = sector;
+            newest_sequence = header.sequence;
+        }
+        if (header.sequence < oldest_sequence)
+        {
+            oldest = sector;
+            oldest_sequence = header.sequence;
+        }
+    }
+
+    if (!formatted)
+    {
+        outbox_write_sequence = 0;
+        if (!outbox_open_sector(0))
+        {
+            outbox_unlock();
+            return false;
+        }
+        outbox_unlock();
+        outbox_ready = true;
+        return true;
+    }
+
+    /* Find the end of the newest sector. */
+    outbox_write_sequence = newest_sequence;
+    outbox_write.sector = newest;
+    outbox_write.offset = sizeof(outbox_sector_header_t);
+    while (outbox_read_record(&outbox_write, &record))
+    {
+        outbox_write.offset += OUTBOX_ALIGN(sizeof(record) + record.topic_len +
+                                            record.payload_len);
+    }
+    if (record.state != OUTBOX_STATE_ERASED)
+    {
+        /* Damaged record, leave the rest of the sector alone. */
+        outbox_write.offset = outbox_sector_size;
+    }
+
+    /* Sectors are opened in circular order, so the log runs from the oldest
+     * to the newest sector. The replay starts at the first sector holding an
+     * unsent record.
+     */
+    outbox_read = outbox_write;
+    for (uint32_t sector = oldest; ; sector = (sector + 1u) % outbox_sector_count)
+    {
+        outbox_pos_t pos = { .sector = sector, .offset = sizeof(outbox_sector_header_t) };
+        uint32_t valid = outbox_read_sector_header(sector, &header) ? outbox_count_valid(pos) : 0u;
+
+        if ((valid != 0) && (outbox_stats.pending == 0))
+        {
+            outbox_read = pos;
+        }
+        outbox_stats.pending += valid;
+
+        if (sector == newest)
+        {
+            break;
+        }
+    }
+    outbox_unlock();
+
+    outbox_ready = true;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: outbox_flash_read
+ ******************************************************************************
+ * Summary:
+ *  Reads from the external flash.
+ *
+ * Parameters:
+ *  uint32_t addr : Flash address
+ *  void *buf : Destination
+ *  size_t len : Number of bytes
+ *
+ * Return:
+ *  bool : true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_flash_read(uint32_t addr, void *buf, size_t len)
+{
+#if OUTBOX_ENABLED
+    return (cy_serial_flash_qspi_read(addr, len, (uint8_t *) buf) == CY_RSLT_SUCCESS);
+#else
+    (void) addr;
+    (void) buf;
+    (void) len;
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: outbox_flash_write
+ ******************************************************************************
+ * Summary:
+ *  Programs the external flash.
+ *
+ * Parameters:
+ *  uint32_t addr : Flash address
+ *  const void *buf : Source
+ *  size_t len : Number of bytes
+ *
+ * Return:
+ *  bool : true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_flash_write(uint32_t addr, const void *buf, size_t len)
+{
+#if OUTBOX_ENABLED
+    return (cy_serial_flash_qspi_write(addr, len, (const uint8_t *) buf) == CY_RSLT_SUCCESS);
+#else
+    (void) addr;
+    (void) buf;
+    (void) len;
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: outbox_flash_erase
+ ******************************************************************************
+ * Summary:
+ *  Erases sectors of the external flash.
+ *
+ * Parameters:
+ *  uint32_t addr : Sector-aligned flash address
+ *  size_t len : Number of bytes, a multiple of the sector size
+ *
+ * Return:
+ *  bool : true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_flash_erase(uint32_t addr, size_t len)
+{
+#if OUTBOX_ENABLED
+    return (cy_serial_flash_qspi_erase(addr, len) == CY_RSLT_SUCCESS);
+#else
+    (void) addr;
+    (void) len;
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: outbox_lock
+ ******************************************************************************
+ * Summary:
+ *  Takes the outbox mutex and leaves XIP mode, in which the flash cannot be
+ *  programmed, on the kits that use it (OUTBOX_FLASH_XIP). The Wi-Fi
+ *  firmware is only read through XIP while the Wi-Fi connection manager
+ *  initializes, before the outbox is in use.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void outbox_lock(void)
+{
+    xSemaphoreTake(outbox_mutex, portMAX_DELAY);
+#if OUTBOX_FLASH_XIP
+    cy_serial_flash_qspi_enable_xip(false);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: outbox_unlock
+ ******************************************************************************
+ * Summary:
+ *  Returns to XIP mode if the kit uses it, and releases the outbox mutex.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void outbox_unlock(void)
+{
+#if OUTBOX_FLASH_XIP
+    cy_serial_flash_qspi_enable_xip(true);
+#endif
+    xSemaphoreGive(outbox_mutex);
+}
+
+/******************************************************************************
+ * Function Name: outbox_addr
+ ******************************************************************************
+ * Summary:
+ *  Returns the flash address of an offset in an outbox sector.
+ *
+ * Parameters:
+ *  uint32_t sector : Outbox sector
+ *  uint32_t offset : Offset in the sector
+ *
+ * Return:
+ *  uint32_t : Flash address
+ *
+ ******************************************************************************/
+static uint32_t outbox_addr(uint32_t sector, uint32_t offset)
+{
+    return outbox_base + (sector * outbox_sector_size) + offset;
+}
+
+/******************************************************************************
+ * Function Name: outbox_read_sector_header
+ ******************************************************************************
+ * Summary:
+ *  Reads the header of an outbox sector.
+ *
+ * Parameters:
+ *  uint32_t sector : Outbox sector
+ *  outbox_sector_header_t *header : Receives the header
+ *
+ * Return:
+ *  bool : true if the sector belongs to the outbox, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_read_sector_header(uint32_t sector, outbox_sector_header_t *header)
+{
+    return outbox_flash_read(outbox_addr(sector, 0), header, sizeof(*header)) &&
+           (header->magic == OUTBOX_SECTOR_MAGIC);
+}
+
+/******************************************************************************
+ * Function Name: outbox_read_record
+ ******************************************************************************
+ * Summary:
+ *  Reads the header of the record at a position.
+ *
+ * Parameters:
+ *  const outbox_pos_t *pos : Position of the record
+ *  outbox_record_header_t *header : Receives the header. Its state is
+ *                                   ERASED at the end of the sector.
+ *
+ * Return:
+ *  bool : true if a record is at the position, false at the end of the
+ *         sector or if the header is damaged
+ *
+ ******************************************************************************/
+static bool outbox_read_record(const outbox_pos_t *pos, outbox_record_header_t *header)
+{
+    header->state = OUTBOX_STATE_ERASED;
+    if ((pos->offset + sizeof(*header) > outbox_sector_size) ||
+        !outbox_flash_read(outbox_addr(pos->sector, pos->offset), header, sizeof(*header)))
+    {
+        return false;
+    }
+
+    /* Unwritten space */
+    if ((header->topic_len == 0xFFu) && (header->payload_len == 0xFFFFu))
+    {
+        header->state = OUTBOX_STATE_ERASED;
+        return false;
+    }
+
+    if ((header->topic_len == 0) || (header->topic_len > TOPIC_MAX_LENGTH) ||
+        (header->payload_len > PUBLISH_PAYLOAD_SIZE) ||
+        (pos->offset + OUTBOX_ALIGN(sizeof(*header) + header->topic_len + header->payload_len) >
+         outbox_sector_size))
+    {
+        /* Not erased, so a reader stops here. */
+        header->state = OUTBOX_STATE_SENT;
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: outbox_open_sector
+ ******************************************************************************
+ * Summary:
+ *  Erases a sector and makes it the sector being written. If the sector
+ *  still holds unsent records, the log is full and they are discarded.
+ *
+ * Parameters:
+ *  uint32_t sector : Outbox sector following the one being written
+ *
+ * Return:
+ *  bool : true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool outbox_open_sector(uint32_t sector)
+{
+    outbox_sector_header_t header;
+    uint32_t erase_count = 0;
+
+    if ((outbox_read.sector == sector) && (outbox_stats.pending != 0))
+    {
+        uint32_t dropped = outbox_count_valid(outbox_read);
+
+        outbox_stats.dropped += dropped;
+        outbox_stats.pending -= dropped;
+        outbox_read.sector = (sector + 1u) % outbox_sector_count;
+        outbox_read.offset = sizeof(header);
+    }
+
+    if (outbox_read_sector_header(sector, &header))
+    {
+        erase_count = header.erase_count;
+    }
+
+    header.magic = OUTBOX_SECTOR_MAGIC;
+    header.sequence = ++outbox_write_sequence;
+    header.erase_count = erase_count + 1u;
+    header.reserved = UINT32_MAX;
+    if (!outbox_flash_erase(outbox_addr(sector, 0), outbox_sector_size) ||
+        !outbox_flash_write(outbox_addr(sector, 0), &header, sizeof(header)))
+    {
+        return false;
+    }
+
+    if (header.erase_count > outbox_stats.max_erase_count)
+    {
+        outbox_stats.max_erase_count = header.erase_count;
+    }
+
+    outbox_write.sector = sector;
+    outbox_write.offset = sizeof(header);
+
+    /* Nothing pending, keep the reader at the writer. */
+    if (outbox_stats.pending == 0)
+    {
+        outbox_read = outbox_write;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: outbox_count_valid
+ ******************************************************************************
+ * Summary:
+ *  Counts the unsent records from a position to the end of its sector.
+ *
+ * Parameters:
+ *  outbox_pos_t pos : Position of the first record
+ *
+ * Return:
+ *  uint32_t : Number of unsent records
+ *
+ ******************************************************************************/
+static uint32_t outbox_count_valid(outbox_pos_t pos)
+{
+    outbox_record_header_t header;
+    uint32_t valid = 0;
+
+    while (outbox_read_record(&pos, &header))
+    {
+        if (header.state == OUTBOX_STATE_VALID)
+        {
+            valid++;
+        }
+        pos.offset += OUTBOX_ALIGN(sizeof(header) + header.topic_len + header.payload_len);
+    }
+
+    return valid;
+}
+
+/******************************************************************************
+ * Function Name: outbox_peek
+ ******************************************************************************
+ * Summary:
+ *  Reads the oldest unsent record, skipping the records already sent.
+ *
+ * Parameters:
+ *  outbox_pos_t *pos : Receives the position of the record
+ *  char *topic : Receives the null-terminated topic, 'TOPIC_MAX_LENGTH' + 1
+ *                bytes
+ *  uint8_t *payload : Receives the payload, 'PUBLISH_PAYLOAD_SIZE' bytes
+ *  size_t *payload_len : Receives the length of the payload
+ *
+ * Return:
+ *  bool : true if a record was read, false if none is pending
+ *
+ ******************************************************************************/
+static bool outbox_peek(outbox_pos_t *pos, char *topic, uint8_t *payload,
+                        size_t *payload_len)
+{
+    outbox_record_header_t header;
+    bool found = false;
+
+    outbox_lock();
+    while (outbox_stats.pending != 0)
+    {
+        if (!outbox_read_record(&outbox_read, &header))
+        {
+            if (outbox_read.sector == outbox_write.sector)
+            {
+                break;
+            }
+
+            /* End of the sector, the log continues in the next one. */
+            outbox_read.sector = (outbox_read.sector + 1u) % outbox_sector_count;
+            outbox_read.offset = sizeof(outbox_sector_header_t);
+            continue;
+        }
+
+        if (header.state == OUTBOX_STATE_VALID)
+        {
+            uint32_t addr = outbox_addr(outbox_read.sector, outbox_read.offset) + sizeof(header);
+
+            found = outbox_flash_read(addr, topic, header.topic_len) &&
+                    outbox_flash_read(addr + header.topic_len, payload, header.payload_len);
+            topic[header.topic_len] = '\0';
+            *payload_len = header.payload_len;
+            *pos = outbox_read;
+            break;
+        }
+
+        outbox_read.offset += OUTBOX_ALIGN(sizeof(header) + header.topic_len + header.payload_len);
+    }
+    outbox_unlock();
+
+    return found;
+}
+
+/******************************************************************************
+ * Function Name: outbox_mark_sent
+ ******************************************************************************
+ * Summary:
+ *  Marks the record returned by outbox_peek() as sent, unless the record
+ *  has been discarded meanwhile.
+ *
+ * Parameters:
+ *  const outbox_pos_t *pos : Position of the record
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void outbox_mark_sent(const outbox_pos_t *pos)
+{
+    outbox_record_header_t header;
+    uint8_t state = OUTBOX_STATE_SENT;
+
+    outbox_lock();
+    if ((outbox_read.sector == pos->sector) && (outbox_read.offset == pos->offset) &&
+        outbox_read_record(pos, &header))
+    {
+        outbox_flash_write(outbox_addr(pos->sector, pos->offset), &state, sizeof(state));
+        outbox_read.offset += OUTBOX_ALIGN(sizeof(header) + header.topic_len + header.payload_len);
+        outbox_stats.pending--;
+        outbox_stats.replayed++;
+    }
+    outbox_unlock();
+}
+
+/******************************************************************************
+ * Function Name: outbox_replay
+ ******************************************************************************
+ * Summary:
+ *  Hands the stored messages to the publisher tasks, oldest first, one every
+ *  'OUTBOX_REPLAY_INTERVAL_MS', as long as the MQTT connection is up.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void outbox_replay(void)
+{
+    char topic[TOPIC_MAX_LENGTH + 1];
+    uint8_t payload[PUBLISH_PAYLOAD_SIZE];
+    size_t payload_len;
+    outbox_pos_t pos;
+    uint32_t replayed = 0;
+
+    while (mqtt_is_connected() && outbox_peek(&pos, topic, payload, &payload_len))
+    {
+        if (!publisher_replay(payload, payload_len, topic, true))
+        {
+            vTaskDelay(pdMS_TO_TICKS(OUTBOX_RETRY_MS));
+            continue;
+        }
+
+        outbox_mark_sent(&pos);
+        replayed++;
+        vTaskDelay(pdMS_TO_TICKS(OUTBOX_REPLAY_INTERVAL_MS));
+    }
+
+    if (replayed != 0)
+    {
+        printf("  Outbox: %lu messages replayed, %lu pending\n",
+               (unsigned long) replayed, (unsigned long) outbox_stats.pending);
+    }
+}
+
+/* [] END OF FILE */
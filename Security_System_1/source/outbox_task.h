@@ -0,0 +1,119 @@
+/******************************************************************************
+* File Name:   outbox_task.h
+*
+* Description: This file is the public interface of outbox_task.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef OUTBOX_TASK_H_
+#define OUTBOX_TASK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* The outbox lives in the external QSPI NOR flash, which main.c initializes
+ * on the kits that keep the Wi-Fi firmware there and read it in XIP mode,
+ * and on the CY8CPROTO-062-4343W, whose on-board NOR flash holds nothing
+ * else and stays in command mode. On the other kits the outbox is compiled
+ * out and outbox_store() always fails.
+ */
+#if defined(CY_DEVICE_PSOC6A512K)
+#define OUTBOX_ENABLED                     (1)
+#define OUTBOX_FLASH_XIP                   (1)
+#elif defined(TARGET_APP_CY8CPROTO_062_4343W)
+#define OUTBOX_ENABLED                     (1)
+#define OUTBOX_FLASH_XIP                   (0)
+#else
+#define OUTBOX_ENABLED                     (0)
+#define OUTBOX_FLASH_XIP                   (0)
+#endif
+
+/* Task parameters for Outbox Task. */
+#define OUTBOX_TASK_PRIORITY               (1)
+#define OUTBOX_TASK_STACK_SIZE             (1024 * 1)
+
+/* Size of the outbox, at the end of the external flash and away from the
+ * Wi-Fi firmware at its start. Must hold at least two erase sectors.
+ *
+ * Capacity: a record takes 4 header bytes plus the topic and payload,
+ * rounded up to 4 bytes, e.g. 12 bytes for "1" on "radar" and 32 bytes for
+ * a binary sample on "device1/piezo". One sector is kept free for the next
+ * append, so with 256 KB sectors the 1 MB outbox keeps about 65000 radar
+ * edges. When it is full the oldest sector is discarded.
+ */
+#define OUTBOX_REGION_SIZE                 (1024u * 1024u)
+
+/* Interval in milliseconds between two replayed messages, i.e. a replay
+ * throughput of at most 10 messages per second, which leaves the rest of
+ * the publish window to live traffic after a reconnection.
+ */
+#define OUTBOX_REPLAY_INTERVAL_MS          (100u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Counters of the outbox. */
+typedef struct
+{
+    uint32_t pending;           /* Records waiting to be replayed */
+    uint32_t stored;            /* Records written since boot */
+    uint32_t replayed;          /* Records replayed since boot */
+    uint32_t dropped;           /* Unsent records discarded when full */
+    uint32_t max_erase_count;   /* Most erase cycles of an outbox sector */
+} outbox_stats_t;
+
+extern TaskHandle_t outbox_task_handle;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void outbox_task(void *pvParameters);
+bool outbox_store(const char *topic, size_t topic_len, const void *payload,
+                  size_t payload_len);
+void outbox_request_replay(void);
+void outbox_get_stats(outbox_stats_t *stats);
+
+#endif /* OUTBOX_TASK_H_ */
+
+/* [] END OF FILE */
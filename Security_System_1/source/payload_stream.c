@@ -0,0 +1,234 @@
+/******************************************************************************
+* File Name:   payload_stream.c
+*
+* Description: This file sends payloads larger than a publish slot, such as
+*              waveform captures or configuration blobs, as a stream of
+*              chunks on one topic, and hands the chunks of a received stream
+*              to a handler as they arrive, without reassembly buffer.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "subscriber_task.h"
+#include "publisher_task.h"
+#include "payload_stream.h"
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* A stream topic and its handler. */
+typedef struct
+{
+    const char *topic;
+    size_t topic_len;
+    payload_stream_callback_t callback;
+} payload_stream_topic_t;
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+/* Stream topics, only added to before their subscription. */
+static payload_stream_topic_t payload_stream_topics[PAYLOAD_STREAM_MAX_TOPICS];
+static volatile uint32_t payload_stream_topic_count = 0;
+
+/* Identifier of the next stream sent. */
+static uint16_t payload_stream_next_id = 0;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static void payload_stream_receive(const char *topic, size_t topic_len,
+                                   const void *payload, size_t payload_len);
+
+/******************************************************************************
+ * Function Name: payload_stream_publish
+ ******************************************************************************
+ * Summary:
+ *  Publishes a payload of any length on the given topic as a stream of
+ *  chunks of 'PAYLOAD_STREAM_CHUNK_SIZE' bytes. The chunks go through the
+ *  publisher like outbox replays: neither rate limited nor coalesced. The
+ *  call blocks while the publisher has no free slot.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name
+ *  const void *data : Payload
+ *  size_t len : Length of the payload
+ *
+ * Return:
+ *  bool : true if every chunk was queued, false if a chunk could not be
+ *         queued within the retries, which ends the stream
+ *
+ ******************************************************************************/
+bool payload_stream_publish(const char *topic, const void *data, size_t len)
+{
+    uint8_t chunk[PUBLISH_PAYLOAD_SIZE];
+    size_t count = (len + PAYLOAD_STREAM_CHUNK_SIZE - 1u) / PAYLOAD_STREAM_CHUNK_SIZE;
+    uint16_t stream_id;
+
+    if ((len == 0) || (count > UINT16_MAX))
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    stream_id = payload_stream_next_id++;
+    taskEXIT_CRITICAL();
+
+    for (size_t index = 0; index < count; index++)
+    {
+        size_t offset = index * PAYLOAD_STREAM_CHUNK_SIZE;
+        size_t chunk_len = ((len - offset) < PAYLOAD_STREAM_CHUNK_SIZE) ?
+                           (len - offset) : PAYLOAD_STREAM_CHUNK_SIZE;
+        uint32_t retry_count = 0;
+
+        chunk[0] = (uint8_t) (stream_id >> 8);
+        chunk[1] = (uint8_t) stream_id;
+        chunk[2] = (uint8_t) (index >> 8);
+        chunk[3] = (uint8_t) index;
+        chunk[4] = (uint8_t) (count >> 8);
+        chunk[5] = (uint8_t) count;
+        memcpy(&chunk[PAYLOAD_STREAM_HEADER_SIZE], (const uint8_t *) data + offset, chunk_len);
+
+        /* A chunk is not kept in the outbox, a partial stream is of no use
+         * after the reconnection.
+         */
+        while (!publisher_replay(chunk, PAYLOAD_STREAM_HEADER_SIZE + chunk_len, topic, false))
+        {
+            if (++retry_count > PAYLOAD_STREAM_SEND_RETRIES)
+            {
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(PAYLOAD_STREAM_RETRY_MS));
+        }
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: payload_stream_subscribe
+ ******************************************************************************
+ * Summary:
+ *  Subscribes the calling task to a stream topic. The chunks received on it
+ *  are handed to the handler straight from the MQTT network buffer, so a
+ *  chunk may be as large as 'MQTT_RX_BUFFER_SIZE' allows. Wildcard filters
+ *  are not supported.
+ *
+ * Parameters:
+ *  char *topic : Null-terminated topic name, must stay valid
+ *  payload_stream_callback_t callback : Handler of the chunks
+ *
+ * Return:
+ *  cy_mqtt_qos_t : QoS granted by the broker, CY_MQTT_QOS_INVALID if the
+ *                  subscription failed or no stream topic is left
+ *
+ ******************************************************************************/
+cy_mqtt_qos_t payload_stream_subscribe(char *topic, payload_stream_callback_t callback)
+{
+    topic_config_t config = { TOPIC_STORAGE_CALLBACK, TOPIC_OVERFLOW_DROP_NEWEST, 1u, 0u,
+                              payload_stream_receive };
+    uint32_t slot;
+
+    taskENTER_CRITICAL();
+    slot = payload_stream_topic_count;
+    if (slot < PAYLOAD_STREAM_MAX_TOPICS)
+    {
+        payload_stream_topics[slot].topic = topic;
+        payload_stream_topics[slot].topic_len = strlen(topic);
+        payload_stream_topics[slot].callback = callback;
+        payload_stream_topic_count = slot + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    if (slot >= PAYLOAD_STREAM_MAX_TOPICS)
+    {
+        return CY_MQTT_QOS_INVALID;
+    }
+
+    return subscribe_request(topic, &config);
+}
+
+/******************************************************************************
+ * Function Name: payload_stream_receive
+ ******************************************************************************
+ * Summary:
+ *  Handler of the stream topics: decodes the chunk header and calls the
+ *  handler of the topic. Chunks shorter than the header are dropped.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (not null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *  const void *payload : Chunk, header included
+ *  size_t payload_len : Length of the chunk
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void payload_stream_receive(const char *topic, size_t topic_len,
+                                   const void *payload, size_t payload_len)
+{
+    const uint8_t *bytes = (const uint8_t *) payload;
+    payload_stream_chunk_t chunk;
+
+    if (payload_len < PAYLOAD_STREAM_HEADER_SIZE)
+    {
+        return;
+    }
+
+    chunk.stream_id = (uint16_t) ((bytes[0] << 8) | bytes[1]);
+    chunk.index = (uint16_t) ((bytes[2] << 8) | bytes[3]);
+    chunk.count = (uint16_t) ((bytes[4] << 8) | bytes[5]);
+    chunk.data = &bytes[PAYLOAD_STREAM_HEADER_SIZE];
+    chunk.len = payload_len - PAYLOAD_STREAM_HEADER_SIZE;
+
+    for (uint32_t i = 0; i < payload_stream_topic_count; i++)
+    {
+        if ((payload_stream_topics[i].topic_len == topic_len) &&
+            (memcmp(payload_stream_topics[i].topic, topic, topic_len) == 0))
+        {
+            payload_stream_topics[i].callback(topic, topic_len, &chunk);
+            return;
+        }
+    }
+}
+
+/* [] END OF FILE */
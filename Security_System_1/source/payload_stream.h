@@ -0,0 +1,107 @@
+/******************************************************************************
+* File Name:   payload_stream.h
+*
+* Description: This file is the public interface of payload_stream.c, which
+*              sends and receives payloads larger than the MQTT buffers as a
+*              stream of chunks.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef PAYLOAD_STREAM_H_
+#define PAYLOAD_STREAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "cy_mqtt_api.h"
+#include "publisher_task.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Every chunk starts with a header of three big-endian 16-bit fields: the
+ * stream identifier, the index of the chunk and the number of chunks.
+ */
+#define PAYLOAD_STREAM_HEADER_SIZE         (6u)
+
+/* Data bytes of a chunk sent by payload_stream_publish(). */
+#define PAYLOAD_STREAM_CHUNK_SIZE          (PUBLISH_PAYLOAD_SIZE - PAYLOAD_STREAM_HEADER_SIZE)
+
+/* Maximum number of stream topics payload_stream_subscribe() accepts. */
+#define PAYLOAD_STREAM_MAX_TOPICS          (2u)
+
+/* A chunk the publisher cannot take is tried again after this many
+ * milliseconds, at most PAYLOAD_STREAM_SEND_RETRIES times.
+ */
+#define PAYLOAD_STREAM_RETRY_MS            (100u)
+#define PAYLOAD_STREAM_SEND_RETRIES        (20u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* A received chunk. 'data' points into the MQTT network buffer and is only
+ * valid during the call of the handler.
+ */
+typedef struct
+{
+    uint16_t stream_id;
+    uint16_t index;                     /* 0 for the first chunk */
+    uint16_t count;                     /* Chunks in the stream */
+    const uint8_t *data;
+    size_t len;
+} payload_stream_chunk_t;
+
+/* Handler of the chunks of a stream topic. Runs in the context of the MQTT
+ * library and must not block. The publisher sends the chunks of a topic in
+ * the order they were queued, and the broker keeps that order, but a chunk
+ * may be missing if the sender ran out of publish slots, or repeated by a
+ * QoS 1 redelivery or an outbox replay. Check 'stream_id' and 'index'
+ * instead of assuming that chunks are contiguous.
+ */
+typedef void (*payload_stream_callback_t)(const char *topic, size_t topic_len,
+                                          const payload_stream_chunk_t *chunk);
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool payload_stream_publish(const char *topic, const void *data, size_t len);
+cy_mqtt_qos_t payload_stream_subscribe(char *topic, payload_stream_callback_t callback);
+
+#endif /* PAYLOAD_STREAM_H_ */
+
+/* [] END OF FILE */
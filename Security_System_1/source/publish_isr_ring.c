@@ -0,0 +1,205 @@
+/******************************************************************************
+* File Name:   publish_isr_ring.c
+*
+* Description: This file contains the ring that carries messages from
+*              interrupt handlers to the publisher tasks. Messages are pushed
+*              and popped without locks, so several interrupt handlers and
+*              publisher tasks can use the ring at the same time.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "publish_isr_ring.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (PUBLISH_ISR_RING_SIZE & (PUBLISH_ISR_RING_SIZE - 1u)) != 0u
+    #error "PUBLISH_ISR_RING_SIZE must be a power of two."
+#endif
+
+/* Marks the points where an interrupt between two steps of a push or pop
+ * races with the other users of the ring. Empty on the target; the host
+ * stress test yields there to force those interleavings.
+ */
+#ifndef PUBLISH_ISR_PREEMPT
+#define PUBLISH_ISR_PREEMPT()
+#endif
+
+/* First position of the ring lap that a position belongs to. */
+#define PUBLISH_ISR_LAP(pos)            ((pos) & ~(PUBLISH_ISR_RING_SIZE - 1u))
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* The entry at position 'pos' is free when its sequence equals
+ * PUBLISH_ISR_LAP(pos), and holds a message when it equals
+ * PUBLISH_ISR_LAP(pos) + 1. Popping it frees it for the next lap. Producers
+ * and consumers claim positions with a compare-and-swap on 'tail' and
+ * 'head', so nested interrupts and several publisher tasks can use the ring
+ * without locks. A zeroed ring is empty.
+ */
+static publish_isr_entry_t publish_isr_ring[PUBLISH_ISR_RING_SIZE];
+static atomic_uint publish_isr_head = 0;
+static atomic_uint publish_isr_tail = 0;
+
+/******************************************************************************
+ * Function Name: publish_isr_push
+ ******************************************************************************
+ * Summary:
+ *  Copies a message into the entry at the tail of the ring. Never blocks,
+ *  so it can be called from interrupt handlers of any priority.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name with static storage
+ *                      duration, only the pointer is stored
+ *  const char *data : Payload
+ *  size_t payload_len : Length of the payload, at most
+ *                       'PUBLISH_ISR_PAYLOAD_SIZE' bytes
+ *
+ * Return:
+ *  bool : true if the message was put in the ring, false if it is full
+ *
+ ******************************************************************************/
+bool publish_isr_push(const char *topic, const char *data, size_t payload_len)
+{
+    publish_isr_entry_t *entry;
+    unsigned int pos = atomic_load(&publish_isr_tail);
+    unsigned int sequence;
+
+    if (payload_len > PUBLISH_ISR_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+
+    /* Claim the entry at the tail, unless the ring is full. */
+    for (;;)
+    {
+        entry = &publish_isr_ring[pos & (PUBLISH_ISR_RING_SIZE - 1u)];
+        sequence = atomic_load_explicit(&entry->sequence, memory_order_acquire);
+        int diff = (int) (sequence - PUBLISH_ISR_LAP(pos));
+
+        PUBLISH_ISR_PREEMPT();
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak(&publish_isr_tail, &pos, pos + 1u))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* The entry still holds a message of the previous lap. */
+            return false;
+        }
+        else
+        {
+            /* Another producer claimed the entry first. */
+            pos = atomic_load(&publish_isr_tail);
+        }
+    }
+
+    entry->topic = topic;
+    entry->payload_len = (uint8_t) payload_len;
+    memcpy(entry->payload, data, payload_len);
+    PUBLISH_ISR_PREEMPT();
+    atomic_store_explicit(&entry->sequence, PUBLISH_ISR_LAP(pos) + 1u, memory_order_release);
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: publish_isr_pop
+ ******************************************************************************
+ * Summary:
+ *  Takes the oldest message out of the ring.
+ *
+ * Parameters:
+ *  publish_isr_entry_t *entry : Receives the message
+ *
+ * Return:
+ *  bool : true if a message was taken, false if the ring is empty
+ *
+ ******************************************************************************/
+bool publish_isr_pop(publish_isr_entry_t *entry)
+{
+    publish_isr_entry_t *ring_entry;
+    unsigned int pos = atomic_load(&publish_isr_head);
+    unsigned int sequence;
+
+    for (;;)
+    {
+        ring_entry = &publish_isr_ring[pos & (PUBLISH_ISR_RING_SIZE - 1u)];
+        sequence = atomic_load_explicit(&ring_entry->sequence, memory_order_acquire);
+        int diff = (int) (sequence - (PUBLISH_ISR_LAP(pos) + 1u));
+
+        PUBLISH_ISR_PREEMPT();
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak(&publish_isr_head, &pos, pos + 1u))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Empty, or the producer of the entry is still copying. */
+            return false;
+        }
+        else
+        {
+            /* Another publisher task took the entry first. */
+            pos = atomic_load(&publish_isr_head);
+        }
+    }
+
+    entry->topic = ring_entry->topic;
+    entry->payload_len = ring_entry->payload_len;
+    memcpy(entry->payload, ring_entry->payload, ring_entry->payload_len);
+    PUBLISH_ISR_PREEMPT();
+
+    /* Free the entry for the next lap. */
+    atomic_store_explicit(&ring_entry->sequence, PUBLISH_ISR_LAP(pos) + PUBLISH_ISR_RING_SIZE,
+                          memory_order_release);
+
+    return true;
+}
+
+/* [] END OF FILE */
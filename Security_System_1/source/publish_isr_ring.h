@@ -0,0 +1,83 @@
+/******************************************************************************
+* File Name:   publish_isr_ring.h
+*
+* Description: This file is the public interface of publish_isr_ring.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef PUBLISH_ISR_RING_H_
+#define PUBLISH_ISR_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of entries of the ring that carries messages from interrupt
+ * handlers to the publisher tasks, a power of two.
+ */
+#define PUBLISH_ISR_RING_SIZE                 (8u)
+
+/* Longest payload PublishMessageFromISR() accepts. */
+#define PUBLISH_ISR_PAYLOAD_SIZE              (16u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Entry of the ISR ring. 'sequence' tells which lap of the ring the entry
+ * belongs to and whether it holds a message, see publish_isr_ring.c.
+ */
+typedef struct
+{
+    atomic_uint sequence;
+    const char *topic;                  /* Null-terminated, static storage */
+    uint8_t payload_len;
+    char payload[PUBLISH_ISR_PAYLOAD_SIZE];
+} publish_isr_entry_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool publish_isr_push(const char *topic, const char *data, size_t payload_len);
+bool publish_isr_pop(publish_isr_entry_t *entry);
+
+#endif /* PUBLISH_ISR_RING_H_ */
+
+/* [] END OF FILE */
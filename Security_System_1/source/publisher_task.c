@@ -45,12 +45,24 @@
 
 #include "cyhal.h"
 #include "cybsp.h"
+#include "string.h"
 #include "FreeRTOS.h"
+#include "semphr.h"
 
 /* Task header files */
 #include "publisher_task.h"
+#include "publish_isr_ring.h"
 #include "mqtt_task.h"
 #include "subscriber_task.h"
+#include "outbox_task.h"
+#include "trace_log.h"
+#include "link_quality.h"
+#include "wire_stats.h"
+
+/* Log module of this file, see log_task.h. */
+#define LOG_MODULE                      "Publisher"
+#define LOG_MODULE_LEVEL                LOG_LEVEL_PUBLISHER
+#include "log_task.h"
 
 /* Configuration file for MQTT client */
 #include "mqtt_client_config.h"
@@ -65,45 +77,101 @@
 /* Interrupt priority for User Button Input. */
 #define USER_BTN_INTR_PRIORITY          (3)
 
-/* The maximum number of times each PUBLISH in this example will be retried. */
-#define PUBLISH_RETRY_LIMIT             (10)
-
-/* A PUBLISH message is retried if no response is received within this 
- * time (in milliseconds).
+/* A pending rate limited payload that found no free slot is tried again
+ * after this time (in milliseconds).
  */
 #define PUBLISH_RETRY_MS                (1000)
 
-/* Queue length of a message queue that is used to communicate with the 
- * publisher task.
+/* Publishes that can wait for a PUBACK at the same time: one per publisher
+ * task, and the session probe of the subscriber task, which publishes
+ * directly while the outbox replay keeps the publisher tasks busy.
+ */
+#if MQTT_PERSISTENT_SESSION
+#define PUBLISH_OUTGOING_MAX            (PUBLISH_WINDOW_SIZE + 1u)
+#else
+#define PUBLISH_OUTGOING_MAX            (PUBLISH_WINDOW_SIZE)
+#endif
+
+#if defined(CY_MQTT_MAX_OUTGOING_PUBLISHES) && (CY_MQTT_MAX_OUTGOING_PUBLISHES < PUBLISH_OUTGOING_MAX)
+    #warning "CY_MQTT_MAX_OUTGOING_PUBLISHES is smaller than PUBLISH_WINDOW_SIZE plus the session probe."
+#endif
+
+#if PUBLISH_ALARM_RESERVED_SLOTS >= PUBLISH_SLOT_COUNT
+    #error "PUBLISH_ALARM_RESERVED_SLOTS leaves no slot for telemetry."
+#endif
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Outcome of handing a message to the publisher tasks. The failures sort
+ * last.
  */
-#define PUBLISHER_TASK_QUEUE_LENGTH     (10u)
+typedef enum
+{
+    PUBLISH_QUEUED,             /* Copied into a new slot and queued */
+    PUBLISH_COALESCED,          /* Replaced the payload of a queued slot */
+    PUBLISH_RATE_LIMITED,       /* Held back by the rate limiter of the topic */
+    PUBLISH_STORED,             /* Stored in the outbox while disconnected */
+    PUBLISH_NO_SLOT,            /* Dropped, every slot is in use */
+    PUBLISH_QUEUE_FULL          /* Dropped, the lane queue is full */
+} publish_status_t;
 
 /******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 static void publisher_init(void);
 static void publisher_deinit(void);
+static bool publisher_post(publish_lane_t lane, const publisher_data_t *data,
+                           TickType_t wait);
+static bool publisher_receive(publisher_data_t *data);
+static bool publish_is_diagnostic(const char *topic, size_t topic_len);
+static bool publish_slot_is_older(const publish_slot_t *other, const publish_slot_t *slot);
+static bool publish_slot_claim(publish_slot_t *slot);
+static publish_slot_t *publish_slot_release(publish_slot_t *slot);
+static cy_rslt_t publish_slot_send(publish_slot_t *slot);
+static void publish_rate_limit_flush(TimerHandle_t timer);
+static void publish_isr_drain(void);
 static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event);
 void print_heap_usage(char *msg);
 
 /******************************************************************************
 * Global Variables
 *******************************************************************************/
-/* FreeRTOS task handle for this task. */
-TaskHandle_t publisher_task_handle;
+/* FreeRTOS task handles of the publisher tasks. */
+TaskHandle_t publisher_task_handle[PUBLISH_WINDOW_SIZE];
 
-/* Handle of the queue holding the commands for the publisher task */
-QueueHandle_t publisher_task_q;
+/* Queues of the publisher lanes, and a counting semaphore given once for
+ * every item put on either of them. FreeRTOS queue sets are not enabled
+ * (configUSE_QUEUE_SETS), so the semaphore is what the publisher tasks block
+ * on.
+ */
+static QueueHandle_t publish_lane_q[PUBLISH_LANE_COUNT];
+static SemaphoreHandle_t publisher_work;
 
-/* Structure to store publish message information. */
-cy_mqtt_publish_info_t publish_info =
-{
-    .qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
-    .topic = MQTT_PUB_TOPIC,
-    .topic_len = (sizeof(MQTT_PUB_TOPIC) - 1),
-    .retain = false,
-    .dup = false
-};
+/* Queueing delay per lane, updated inside a critical section. */
+static publish_lane_stats_t publish_lane_stats[PUBLISH_LANE_COUNT];
+
+/* Publish slots. A slot changes state only inside a critical section. */
+static publish_slot_t publish_slots[PUBLISH_SLOT_COUNT];
+
+/* Sequence number of the next queued slot, orders the slots of a topic. */
+static uint32_t publish_sequence = 0;
+
+/* Longest payload sent so far, updated inside a critical section. */
+static size_t publish_tx_peak = 0;
+
+/* Rate limiters of the rate limited topics. */
+static publish_rate_limit_t publish_rate_limits[PUBLISH_RATE_LIMIT_MAX_TOPICS];
+static volatile uint32_t publish_rate_limit_count = 0;
+
+/* Set while a doorbell is on the alarm lane queue. */
+static atomic_bool publish_isr_doorbell = false;
+
+/* Messages PublishMessageFromISR() could not take, and the count last
+ * printed by a publisher task.
+ */
+static atomic_uint publish_isr_dropped = 0;
+static uint32_t publish_isr_reported = 0;
 
 /* Structure that stores the callback data for the GPIO interrupt event. */
 cyhal_gpio_callback_data_t cb_data =
@@ -116,10 +184,12 @@ cyhal_gpio_callback_data_t cb_data =
  * Function Name: publisher_task
  ******************************************************************************
  * Summary:
- *  Task that sets up the user button GPIO for the publisher and publishes 
- *  MQTT messages to the broker. The user button init and deinit operations,
- *  and the MQTT publish operation is performed based on commands sent by other
- *  tasks and callbacks over a message queue.
+ *  Task that publishes MQTT messages to the broker based on commands sent by
+ *  other tasks and callbacks over the lane queues. 'PUBLISH_WINDOW_SIZE'
+ *  instances of the task share the queues, so that several QoS 1 publishes
+ *  can wait for their PUBACK at the same time while the messages of a topic
+ *  still leave in the order they were queued. Alarms are taken before any telemetry, so
+ *  an alarm waits at most for a publisher task to finish its publish.
  *
  * Parameters:
  *  void *pvParameters : Task parameter defined during task creation (unused)
@@ -131,7 +201,6 @@ cyhal_gpio_callback_data_t cb_data =
 void publisher_task(void *pvParameters)
 {
     /* Status variable */
-
     cy_rslt_t result;
 
     publisher_data_t publisher_q_data;
@@ -145,41 +214,405 @@ void publisher_task(void *pvParameters)
     /* Initialize and set-up the user button GPIO. */
     //publisher_init();
 
-    /* Create a message queue to communicate with other tasks and callbacks. */
-    //publisher_task_q = xQueueCreate(PUBLISHER_TASK_QUEUE_LENGTH, sizeof(publisher_data_t));
-
     while (true)
     {
         /* Wait for commands from other tasks and callbacks. */
-        if (pdTRUE == xQueueReceive(publisher_task_q, &publisher_q_data, portMAX_DELAY))
+        if (publisher_receive(&publisher_q_data))
         {
+            if (publisher_q_data.cmd == PUBLISH_ISR_MSGS)
+            {
+                publish_isr_drain();
+                continue;
+            }
 
-                    /* Publish the data received over the message queue. */
-                    publish_info.payload = publisher_q_data.data;
-                    publish_info.payload_len = strlen(publish_info.payload);
-                    publish_info.topic = publisher_q_data.topic;
-                    publish_info.topic_len = strlen(publish_info.topic);
+            if (publisher_q_data.cmd != PUBLISH_MQTT_MSG)
+            {
+                continue;
+            }
 
-                    printf("\nPublisher: Publishing '%s' on the topic '%s'\n",
-                           (char *) publish_info.payload, publish_info.topic);
+            publish_slot_t *slot = publisher_q_data.slot;
 
-                    result = cy_mqtt_publish(mqtt_connection, &publish_info);
+            /* Keep the order of the messages of a topic: a slot queued behind
+             * an older message for the topic is parked, and published by the
+             * task that releases the older message. The slot keeps coalescing
+             * newer payloads meanwhile.
+             */
+            if (!publish_slot_claim(slot))
+            {
+                continue;
+            }
 
-                    if (result != CY_RSLT_SUCCESS)
-                    {
-                        printf("  Publisher: MQTT Publish failed with error 0x%0X.\n\n", (int)result);
+            while (slot != NULL)
+            {
+                /* Time spent queued, including the wait for the older message. */
+                TickType_t delay = xTaskGetTickCount() - slot->queued_tick;
+                publish_lane_stats_t *stats = &publish_lane_stats[slot->lane];
+
+                taskENTER_CRITICAL();
+                stats->count++;
+                stats->total_ticks += delay;
+                if (delay > stats->max_ticks)
+                {
+                    stats->max_ticks = delay;
+                }
+                taskEXIT_CRITICAL();
+
+                /* A trace dump that traced its own publish would leave the
+                 * ring non-empty for ever.
+                 */
+                if (!slot->diagnostic)
+                {
+                    TRACE(TRACE_PUBLISH_START, slot->payload_len, delay * portTICK_PERIOD_MS,
+                          (int) slot->topic_len, slot->topic);
+                }
+                TickType_t send_tick = xTaskGetTickCount();
 
-                        /* Communicate the publish failure with the the MQTT 
-                         * client task.
-                         */
-                        mqtt_task_cmd = HANDLE_MQTT_PUBLISH_FAILURE;
-                        xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+                result = publish_slot_send(slot);
+
+                if (!slot->diagnostic)
+                {
+                    TRACE(TRACE_PUBLISH_DONE, (uint32_t) result,
+                          (xTaskGetTickCount() - send_tick) * portTICK_PERIOD_MS);
+                }
+
+                if (result != CY_RSLT_SUCCESS)
+                {
+                    LOG_ERR("MQTT Publish failed with error 0x%0X", (int)result);
+
+                    /* Keep the message for the replay after the reconnection. */
+                    if (slot->outbox &&
+                        outbox_store(slot->topic, slot->topic_len, slot->payload, slot->payload_len))
+                    {
+                        LOG_INF("Message on '%s' kept in the outbox", slot->topic);
                     }
 
-                    print_heap_usage("publisher_task: After publishing an MQTT message");
+                    /* Communicate the publish failure with the the MQTT 
+                     * client task.
+                     */
+                    mqtt_task_cmd = HANDLE_MQTT_PUBLISH_FAILURE;
+                    xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+                }
+
+                slot = publish_slot_release(slot);
+            }
+
+            print_heap_usage("publisher_task: After publishing an MQTT message");
+
+            /* Picks up messages whose doorbell did not fit the queue. */
+            publish_isr_drain();
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_create_queues
+ ******************************************************************************
+ * Summary:
+ *  Creates the lane queues and the work semaphore of the publisher tasks.
+ *  Must be called before the publisher tasks are created.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : true if everything was created, false otherwise
+ *
+ ******************************************************************************/
+bool publisher_create_queues(void)
+{
+    publish_lane_q[PUBLISH_LANE_ALARM] = xQueueCreate(PUBLISH_ALARM_QUEUE_LENGTH,
+                                                      sizeof(publisher_data_t));
+    publish_lane_q[PUBLISH_LANE_TELEMETRY] = xQueueCreate(PUBLISH_TELEMETRY_QUEUE_LENGTH,
+                                                          sizeof(publisher_data_t));
+
+    /* Never given more often than the queues have items. */
+    publisher_work = xSemaphoreCreateCounting(PUBLISH_ALARM_QUEUE_LENGTH +
+                                              PUBLISH_TELEMETRY_QUEUE_LENGTH, 0);
+
+    return ((publish_lane_q[PUBLISH_LANE_ALARM] != NULL) &&
+            (publish_lane_q[PUBLISH_LANE_TELEMETRY] != NULL) &&
+            (publisher_work != NULL));
+}
+
+/******************************************************************************
+ * Function Name: publisher_send_command
+ ******************************************************************************
+ * Summary:
+ *  Sends a command without a message, e.g. 'PUBLISHER_INIT', to the publisher
+ *  tasks on the alarm lane. Blocks until the queue has space.
+ *
+ * Parameters:
+ *  publisher_cmd_t cmd : Command
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publisher_send_command(publisher_cmd_t cmd)
+{
+    publisher_data_t publisher_q_data = { .cmd = cmd, .slot = NULL };
+
+    publisher_post(PUBLISH_LANE_ALARM, &publisher_q_data, portMAX_DELAY);
+}
+
+/******************************************************************************
+ * Function Name: publisher_post
+ ******************************************************************************
+ * Summary:
+ *  Puts an item on a lane queue and wakes a publisher task for it.
+ *
+ * Parameters:
+ *  publish_lane_t lane : Lane
+ *  const publisher_data_t *data : Item
+ *  TickType_t wait : Ticks to wait for space on the lane queue
+ *
+ * Return:
+ *  bool : true if the item was queued, false if the queue stayed full
+ *
+ ******************************************************************************/
+static bool publisher_post(publish_lane_t lane, const publisher_data_t *data,
+                           TickType_t wait)
+{
+    if (xQueueSend(publish_lane_q[lane], data, wait) != pdTRUE)
+    {
+        return false;
+    }
+
+    xSemaphoreGive(publisher_work);
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: publisher_receive
+ ******************************************************************************
+ * Summary:
+ *  Waits for an item on the lane queues and takes it, from the alarm lane if
+ *  it has one. Every give of the work semaphore follows a send, so a task
+ *  that took the semaphore finds an item on one of the queues.
+ *
+ * Parameters:
+ *  publisher_data_t *data : Receives the item
+ *
+ * Return:
+ *  bool : true if an item was taken
+ *
+ ******************************************************************************/
+static bool publisher_receive(publisher_data_t *data)
+{
+    if (xSemaphoreTake(publisher_work, portMAX_DELAY) != pdTRUE)
+    {
+        return false;
+    }
+
+    for (uint32_t lane = 0; lane < PUBLISH_LANE_COUNT; lane++)
+    {
+        if (xQueueReceive(publish_lane_q[lane], data, 0) == pdTRUE)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: publish_is_diagnostic
+ ******************************************************************************
+ * Summary:
+ *  Tells whether a topic is one of the diagnostics topics, which start with
+ *  'MQTT_DIAGNOSTICS_TOPIC_PREFIX'.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *
+ * Return:
+ *  bool : true if the topic is a diagnostics topic
+ *
+ ******************************************************************************/
+static bool publish_is_diagnostic(const char *topic, size_t topic_len)
+{
+    size_t prefix_len = sizeof(MQTT_DIAGNOSTICS_TOPIC_PREFIX) - 1u;
+
+    return ((topic_len >= prefix_len) &&
+            (memcmp(topic, MQTT_DIAGNOSTICS_TOPIC_PREFIX, prefix_len) == 0));
+}
+
+/******************************************************************************
+ * Function Name: publish_slot_is_older
+ ******************************************************************************
+ * Summary:
+ *  Tells whether a slot is another slot for the same topic that was queued
+ *  before a given slot. Must be called inside a critical section.
+ *
+ * Parameters:
+ *  const publish_slot_t *other : Slot to check
+ *  const publish_slot_t *slot : Reference slot
+ *
+ * Return:
+ *  bool : true if 'other' holds an older message for the topic of 'slot'
+ *
+ ******************************************************************************/
+static bool publish_slot_is_older(const publish_slot_t *other, const publish_slot_t *slot)
+{
+    return ((other != slot) && (other->state != PUBLISH_SLOT_FREE) &&
+            ((int32_t) (other->sequence - slot->sequence) < 0) &&
+            (other->topic_len == slot->topic_len) &&
+            (memcmp(other->topic, slot->topic, slot->topic_len) == 0));
+}
+
+/******************************************************************************
+ * Function Name: publish_slot_claim
+ ******************************************************************************
+ * Summary:
+ *  Marks a queued slot as being published, unless an older message for the
+ *  same topic is queued or being published. The slot is parked instead, and
+ *  publish_slot_release() hands it to the task that releases the message
+ *  before it.
+ *
+ * Parameters:
+ *  publish_slot_t *slot : Queued slot taken from a lane queue
+ *
+ * Return:
+ *  bool : true if the slot was claimed, false if it was parked
+ *
+ ******************************************************************************/
+static bool publish_slot_claim(publish_slot_t *slot)
+{
+    bool claimed = true;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < PUBLISH_SLOT_COUNT; i++)
+    {
+        if (publish_slot_is_older(&publish_slots[i], slot))
+        {
+            claimed = false;
+            break;
+        }
+    }
+
+    /* From now on PublishMessage() no longer coalesces into the slot. */
+    if (claimed)
+    {
+        slot->state = PUBLISH_SLOT_SENDING;
+    }
+    else
+    {
+        slot->parked = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return claimed;
+}
+
+/******************************************************************************
+ * Function Name: publish_slot_release
+ ******************************************************************************
+ * Summary:
+ *  Frees a published slot and claims the next message for its topic if that
+ *  message is parked. A next message that is still on a lane queue is
+ *  claimed by the task that takes it, since nothing older is left then.
+ *
+ * Parameters:
+ *  publish_slot_t *slot : Slot that was published
+ *
+ * Return:
+ *  publish_slot_t * : Claimed slot to publish next, NULL if there is none
+ *
+ ******************************************************************************/
+static publish_slot_t *publish_slot_release(publish_slot_t *slot)
+{
+    publish_slot_t *next = NULL;
 
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < PUBLISH_SLOT_COUNT; i++)
+    {
+        /* The oldest of the newer messages for the topic. */
+        if ((publish_slots[i].state == PUBLISH_SLOT_QUEUED) &&
+            publish_slot_is_older(slot, &publish_slots[i]) &&
+            ((next == NULL) || publish_slot_is_older(&publish_slots[i], next)))
+        {
+            next = &publish_slots[i];
         }
     }
+
+    slot->state = PUBLISH_SLOT_FREE;
+
+    if ((next != NULL) && next->parked)
+    {
+        next->parked = false;
+        next->state = PUBLISH_SLOT_SENDING;
+    }
+    else
+    {
+        next = NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    return next;
+}
+
+/******************************************************************************
+ * Function Name: publish_slot_send
+ ******************************************************************************
+ * Summary:
+ *  Publishes the message of a claimed slot and waits for its PUBACK. The MQTT
+ *  library resends an unacknowledged PUBLISH itself, so a failure is final
+ *  and the caller keeps the message in the outbox. A QoS 1 publish is timed
+ *  by the link quality estimator.
+ *
+ * Parameters:
+ *  publish_slot_t *slot : Claimed slot
+ *
+ * Return:
+ *  cy_rslt_t : Result of the publish
+ *
+ ******************************************************************************/
+static cy_rslt_t publish_slot_send(publish_slot_t *slot)
+{
+    cy_rslt_t result;
+
+    /* Each publisher task has its own publish information. */
+    cy_mqtt_publish_info_t publish_info =
+    {
+        .qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS,
+        .topic = slot->topic,
+        .topic_len = slot->topic_len,
+        .payload = slot->payload,
+        .payload_len = slot->payload_len,
+        .retain = false,
+        .dup = false
+    };
+
+    /* Payloads may be binary, only their length is logged. */
+    LOG_INF("Publishing %u bytes on the topic '%s'",
+            (unsigned int) publish_info.payload_len, publish_info.topic);
+
+    taskENTER_CRITICAL();
+    if (slot->payload_len > publish_tx_peak)
+    {
+        publish_tx_peak = slot->payload_len;
+    }
+    taskEXIT_CRITICAL();
+
+    /* Diagnostics are not sampled, or an idle device would keep reporting
+     * the samples taken by its own reports.
+     */
+    int link_handle = ((publish_info.qos == CY_MQTT_QOS0) || slot->diagnostic) ?
+                      -1 : link_quality_publish_begin();
+    result = cy_mqtt_publish(mqtt_connection, &publish_info);
+    link_quality_publish_end(link_handle, (result == CY_RSLT_SUCCESS));
+
+    /* A failed publish is kept in the outbox and counted when it is
+     * replayed, so only the publishes that went through are counted here.
+     */
+    if ((result == CY_RSLT_SUCCESS) && !slot->diagnostic)
+    {
+        wire_stats_publish(publish_info.topic, publish_info.topic_len, publish_info.payload_len,
+                           (publish_info.qos == CY_MQTT_QOS0));
+    }
+
+    return result;
 }
 
 /******************************************************************************
@@ -238,44 +671,860 @@ static void publisher_deinit(void)
 
 
 /******************************************************************************
- * Function Name: isr_button_press
+ * Function Name: publish_enqueue
  ******************************************************************************
  * Summary:
- *  GPIO interrupt service routine. This function detects button
- *  presses and sends the publish command along with the data to be published 
- *  to the publisher task over a message queue. Based on the current device 
- *  state, the publish data is set so that the device state gets toggled.
+ *  Copies a message into a publish slot and hands the slot to the publisher
+ *  tasks on a lane. If coalescing is requested and a message for the same
+ *  topic is still waiting on the lane, its payload is replaced instead.
+ *  Telemetry never takes the last 'PUBLISH_ALARM_RESERVED_SLOTS' free slots.
  *
  * Parameters:
- *  void *callback_arg : pointer to variable passed to the ISR (unused)
- *  cyhal_gpio_event_t event : GPIO event type (unused)
+ *  publish_lane_t lane : Lane of the message
+ *  const char *data : Payload, at most 'PUBLISH_PAYLOAD_SIZE' bytes
+ *  size_t payload_len : Length of the payload
+ *  const char *topic : Topic name, at most 'TOPIC_MAX_LENGTH' bytes
+ *  size_t topic_len : Length of the topic name
+ *  TickType_t wait : Ticks to wait for space on the lane queue
+ *  bool coalesce : Replace the payload of a queued message for the topic
+ *  bool outbox : Store the message in the outbox if its publish fails, not
+ *                applied to diagnostics topics
  *
  * Return:
- *  void
+ *  publish_status_t : Outcome of the request
  *
  ******************************************************************************/
-void PublishMessage(char* data, char* topic)
+static publish_status_t publish_enqueue(publish_lane_t lane,
+                                        const char *data, size_t payload_len,
+                                        const char *topic, size_t topic_len,
+                                        TickType_t wait, bool coalesce, bool outbox)
 {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     publisher_data_t publisher_q_data;
+    publish_slot_t *slot = NULL;
+    publish_slot_t *free_slot = NULL;
+    uint32_t free_count = 0;
 
-    /* To avoid compiler warnings */
-    //(void) callback_arg;
-    //(void) event;
+    /* Replace the payload of a queued message for the same topic, or copy the
+     * message into a free slot.
+     */
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < PUBLISH_SLOT_COUNT; i++)
+    {
+        if (coalesce && (publish_slots[i].state == PUBLISH_SLOT_QUEUED) &&
+            (publish_slots[i].lane == lane) &&
+            (publish_slots[i].topic_len == topic_len) &&
+            (memcmp(publish_slots[i].topic, topic, topic_len) == 0))
+        {
+            slot = &publish_slots[i];
+            break;
+        }
+
+        if (publish_slots[i].state == PUBLISH_SLOT_FREE)
+        {
+            free_count++;
+            if (free_slot == NULL)
+            {
+                free_slot = &publish_slots[i];
+            }
+        }
+    }
 
-    /* Assign the publish command to be sent to the publisher task. */
-    publisher_q_data.topic = topic;
+    if ((slot == NULL) && (lane == PUBLISH_LANE_TELEMETRY) &&
+        (free_count <= PUBLISH_ALARM_RESERVED_SLOTS))
+    {
+        free_slot = NULL;
+    }
+
+    if (slot != NULL)
+    {
+        memcpy(slot->payload, data, payload_len);
+        slot->payload[payload_len] = '\0';
+        slot->payload_len = (uint16_t) payload_len;
+    }
+    else if (free_slot != NULL)
+    {
+        memcpy(free_slot->topic, topic, topic_len);
+        free_slot->topic[topic_len] = '\0';
+        free_slot->topic_len = (uint16_t) topic_len;
+        memcpy(free_slot->payload, data, payload_len);
+        free_slot->payload[payload_len] = '\0';
+        free_slot->payload_len = (uint16_t) payload_len;
+        free_slot->lane = lane;
+        free_slot->queued_tick = xTaskGetTickCount();
+        free_slot->sequence = publish_sequence++;
+        free_slot->parked = false;
+        free_slot->diagnostic = publish_is_diagnostic(topic, topic_len);
+        free_slot->outbox = outbox && !free_slot->diagnostic;
+        free_slot->state = PUBLISH_SLOT_QUEUED;
+    }
+    taskEXIT_CRITICAL();
 
-    /* Assign the publish message payload so that the device state toggles. */
+    /* Coalesced into a message that is already on the queue. */
+    if (slot != NULL)
+    {
+        return PUBLISH_COALESCED;
+    }
 
-    publisher_q_data.data = data;
+    if (free_slot == NULL)
+    {
+        return PUBLISH_NO_SLOT;
+    }
 
+    /* Send the command and the slot to publisher task over the lane queue */
     publisher_q_data.cmd = PUBLISH_MQTT_MSG;
+    publisher_q_data.slot = free_slot;
+    if (!publisher_post(lane, &publisher_q_data, wait))
+    {
+        taskENTER_CRITICAL();
+        free_slot->state = PUBLISH_SLOT_FREE;
+        taskEXIT_CRITICAL();
+        return PUBLISH_QUEUE_FULL;
+    }
+
+    return PUBLISH_QUEUED;
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_find
+ ******************************************************************************
+ * Summary:
+ *  Looks up the rate limiter of a topic. Limiters are only ever appended and
+ *  counted once filled in, so the lookup does not take any lock.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *
+ * Return:
+ *  publish_rate_limit_t * : Rate limiter, NULL if the topic is not limited
+ *
+ ******************************************************************************/
+static publish_rate_limit_t *publish_rate_limit_find(const char *topic, size_t topic_len)
+{
+    for (uint32_t i = 0; i < publish_rate_limit_count; i++)
+    {
+        if ((publish_rate_limits[i].topic_len == topic_len) &&
+            (memcmp(publish_rate_limits[i].topic, topic, topic_len) == 0))
+        {
+            return &publish_rate_limits[i];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_refill
+ ******************************************************************************
+ * Summary:
+ *  Adds the tokens earned since the last refill to a bucket, and returns the
+ *  number of ticks until a whole token is available. Must be called inside a
+ *  critical section.
+ *
+ * Parameters:
+ *  publish_rate_limit_t *limit : Rate limiter
+ *
+ * Return:
+ *  TickType_t : Ticks until a token is available, 0 if one is available now
+ *
+ ******************************************************************************/
+static TickType_t publish_rate_limit_refill(publish_rate_limit_t *limit)
+{
+    TickType_t now = xTaskGetTickCount();
+    uint32_t elapsed = (uint32_t) (now - limit->refill_tick);
+    uint32_t missing = limit->capacity - limit->tokens;
+
+    /* Compare before multiplying, a long idle time would overflow. */
+    limit->tokens = (elapsed >= (missing + limit->rate - 1u) / limit->rate) ?
+                    limit->capacity : (limit->tokens + elapsed * limit->rate);
+    limit->refill_tick = now;
+
+    if (limit->tokens >= configTICK_RATE_HZ)
+    {
+        return 0;
+    }
+
+    return (configTICK_RATE_HZ - limit->tokens + limit->rate - 1u) / limit->rate;
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_admit
+ ******************************************************************************
+ * Summary:
+ *  Takes a token for a publish on a rate limited topic. Without a token the
+ *  payload is kept as the pending payload of the topic, replacing any older
+ *  one, and the flush timer is started.
+ *
+ * Parameters:
+ *  publish_rate_limit_t *limit : Rate limiter of the topic
+ *  publish_lane_t lane : Lane of the publish
+ *  const char *data : Payload, at most 'PUBLISH_PAYLOAD_SIZE' bytes
+ *  size_t payload_len : Length of the payload
+ *
+ * Return:
+ *  bool : true if the publish may go ahead, false if it was suppressed
+ *
+ ******************************************************************************/
+static bool publish_rate_limit_admit(publish_rate_limit_t *limit, publish_lane_t lane,
+                                     const char *data, size_t payload_len)
+{
+    TickType_t delay;
+
+    taskENTER_CRITICAL();
+    delay = publish_rate_limit_refill(limit);
+    if (delay == 0)
+    {
+        /* A newer payload supersedes the pending one. */
+        limit->tokens -= configTICK_RATE_HZ;
+        limit->pending = false;
+    }
+    else
+    {
+        memcpy(limit->pending_payload, data, payload_len);
+        limit->pending_payload[payload_len] = '\0';
+        limit->pending_len = (uint16_t) payload_len;
+        limit->pending_lane = lane;
+        limit->pending = true;
+        limit->suppressed++;
+    }
+    taskEXIT_CRITICAL();
+
+    if ((delay != 0) && (xTimerIsTimerActive(limit->flush_timer) == pdFALSE))
+    {
+        /* Changing the period also starts the timer. */
+        xTimerChangePeriod(limit->flush_timer, delay, 0);
+    }
+
+    return (delay == 0);
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_flush
+ ******************************************************************************
+ * Summary:
+ *  Flush timer callback of a rate limited topic. Publishes the pending
+ *  payload once a token is available, so that the last state of the topic
+ *  is sent even when it was suppressed. Runs in the timer service task, so
+ *  it never blocks.
+ *
+ * Parameters:
+ *  TimerHandle_t timer : Flush timer, its ID is the rate limiter
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_rate_limit_flush(TimerHandle_t timer)
+{
+    /* Only the timer service task runs this callback, so the copy of the
+     * pending payload need not be on its stack.
+     */
+    static char payload[PUBLISH_PAYLOAD_SIZE + 1];
+
+    publish_rate_limit_t *limit = (publish_rate_limit_t *) pvTimerGetTimerID(timer);
+    publish_lane_t lane = PUBLISH_LANE_TELEMETRY;
+    uint16_t payload_len = 0;
+    TickType_t delay = 0;
+    bool flush = false;
+
+    /* Take the pending payload, its length and lane together, so that a
+     * suppressed publish storing a newer payload cannot be sent half-written.
+     */
+    taskENTER_CRITICAL();
+    if (limit->pending)
+    {
+        delay = publish_rate_limit_refill(limit);
+        if (delay == 0)
+        {
+            limit->tokens -= configTICK_RATE_HZ;
+            limit->pending = false;
+            lane = limit->pending_lane;
+            payload_len = limit->pending_len;
+            memcpy(payload, limit->pending_payload, payload_len);
+            flush = true;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (flush && (publish_enqueue(lane, payload, payload_len, limit->topic,
+                                  limit->topic_len, 0, true, true) >= PUBLISH_NO_SLOT))
+    {
+        /* Give the token back and try again later. */
+        taskENTER_CRITICAL();
+        limit->tokens += configTICK_RATE_HZ;
+        limit->pending = true;
+        taskEXIT_CRITICAL();
+        delay = pdMS_TO_TICKS(PUBLISH_RETRY_MS);
+    }
+
+    if (delay != 0)
+    {
+        xTimerChangePeriod(timer, delay, 0);
+    }
+}
+
+/******************************************************************************
+ * Function Name: publisher_set_rate_limit
+ ******************************************************************************
+ * Summary:
+ *  Limits the publish rate of a topic with a token bucket. Publishes beyond
+ *  the rate and burst are suppressed and counted, and the latest suppressed
+ *  payload is sent as soon as the rate allows.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name
+ *  uint16_t rate : Sustained rate in messages per second, at least 1
+ *  uint8_t burst : Number of messages that can be sent back to back, at
+ *                  least 1
+ *
+ * Return:
+ *  bool : true if the limit was set, false if the topic is invalid, already
+ *         limited or the limiter table is full
+ *
+ ******************************************************************************/
+bool publisher_set_rate_limit(const char *topic, uint16_t rate, uint8_t burst)
+{
+    size_t topic_len = strlen(topic);
+    publish_rate_limit_t *limit;
+    bool added = false;
+
+    if ((topic_len > TOPIC_MAX_LENGTH) || (rate == 0) || (burst == 0) ||
+        (publish_rate_limit_find(topic, topic_len) != NULL))
+    {
+        return false;
+    }
+
+    TimerHandle_t flush_timer = xTimerCreate("Publish flush", 1, pdFALSE, NULL,
+                                             publish_rate_limit_flush);
+    if (flush_timer == NULL)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    if (publish_rate_limit_count < PUBLISH_RATE_LIMIT_MAX_TOPICS)
+    {
+        /* Fill the limiter before it is counted, so that PublishMessage()
+         * never sees a partially written one.
+         */
+        limit = &publish_rate_limits[publish_rate_limit_count];
+        memcpy(limit->topic, topic, topic_len + 1);
+        limit->topic_len = (uint16_t) topic_len;
+        limit->rate = rate;
+        limit->capacity = (uint32_t) burst * configTICK_RATE_HZ;
+        limit->tokens = limit->capacity;
+        limit->refill_tick = xTaskGetTickCount();
+        limit->suppressed = 0;
+        limit->reported = 0;
+        limit->pending = false;
+        limit->pending_lane = PUBLISH_LANE_TELEMETRY;
+        limit->pending_len = 0;
+        limit->flush_timer = flush_timer;
+        vTimerSetTimerID(flush_timer, limit);
+        publish_rate_limit_count++;
+        added = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!added)
+    {
+        xTimerDelete(flush_timer, 0);
+    }
+
+    return added;
+}
+
+/******************************************************************************
+ * Function Name: publish_rate_limit_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the suppressed publish counts of the rate limited topics whose
+ *  count changed since the previous report on
+ *  'MQTT_RATE_LIMIT_DIAGNOSTICS_TOPIC', as a JSON object keyed by topic name.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publish_rate_limit_diagnostics(void)
+{
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+
+    for (uint32_t i = 0; i < publish_rate_limit_count; i++)
+    {
+        publish_rate_limit_t *limit = &publish_rate_limits[i];
+        uint32_t suppressed = limit->suppressed;
+
+        if (suppressed == limit->reported)
+        {
+            continue;
+        }
+
+        int written = snprintf(&payload[len], sizeof(payload) - len,
+                               "%c\"%s\":{\"suppressed\":%lu}",
+                               (len == 0) ? '{' : ',', limit->topic,
+                               (unsigned long) suppressed);
+        /* Keep room for the closing brace */
+        if ((written < 0) || (len + written + 2 > sizeof(payload)))
+        {
+            break;
+        }
+
+        len += written;
+        limit->reported = suppressed;
+    }
+
+    if (len == 0)
+    {
+        return;
+    }
+
+    payload[len++] = '}';
+    payload[len] = '\0';
+    PublishMessage(payload, MQTT_RATE_LIMIT_DIAGNOSTICS_TOPIC);
+}
+
+/******************************************************************************
+ * Function Name: publish_lane_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the number of messages taken from each lane since the previous
+ *  report, with their average and maximum queueing delay in milliseconds, on
+ *  'MQTT_LANE_DIAGNOSTICS_TOPIC'. The delay runs from the time a message is
+ *  queued until a publisher task starts to publish it. Nothing is published
+ *  if no message was taken.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void publish_lane_diagnostics(void)
+{
+    static const char *const lane_names[PUBLISH_LANE_COUNT] = { "alarm", "telemetry" };
+    publish_lane_stats_t stats[PUBLISH_LANE_COUNT];
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+    size_t len = 0;
+
+    /* Take the window and start a new one. */
+    taskENTER_CRITICAL();
+    memcpy(stats, publish_lane_stats, sizeof(stats));
+    memset(publish_lane_stats, 0, sizeof(publish_lane_stats));
+    taskEXIT_CRITICAL();
+
+    if ((stats[PUBLISH_LANE_ALARM].count == 0) && (stats[PUBLISH_LANE_TELEMETRY].count == 0))
+    {
+        return;
+    }
+
+    for (uint32_t lane = 0; lane < PUBLISH_LANE_COUNT; lane++)
+    {
+        uint32_t avg_ticks = (stats[lane].count == 0) ? 0 :
+                             (stats[lane].total_ticks / stats[lane].count);
+
+        int written = snprintf(&payload[len], sizeof(payload) - len,
+                               "%c\"%s\":{\"count\":%lu,\"avg_ms\":%lu,\"max_ms\":%lu}",
+                               (len == 0) ? '{' : ',', lane_names[lane],
+                               (unsigned long) stats[lane].count,
+                               (unsigned long) (avg_ticks * portTICK_PERIOD_MS),
+                               (unsigned long) (stats[lane].max_ticks * portTICK_PERIOD_MS));
+        /* Keep room for the closing brace */
+        if ((written < 0) || (len + written + 2 > sizeof(payload)))
+        {
+            return;
+        }
+
+        len += written;
+    }
+
+    payload[len++] = '}';
+    payload[len] = '\0';
+    PublishMessage(payload, MQTT_LANE_DIAGNOSTICS_TOPIC);
+}
+
+/******************************************************************************
+ * Function Name: publisher_tx_peak
+ ******************************************************************************
+ * Summary:
+ *  Returns the longest payload published so far, to be compared with the
+ *  TX size 'PUBLISH_PAYLOAD_SIZE'.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  size_t : Payload length in bytes
+ *
+ ******************************************************************************/
+size_t publisher_tx_peak(void)
+{
+    size_t peak;
+
+    taskENTER_CRITICAL();
+    peak = publish_tx_peak;
+    taskEXIT_CRITICAL();
+
+    return peak;
+}
+
+/******************************************************************************
+ * Function Name: publish_submit
+ ******************************************************************************
+ * Summary:
+ *  Applies the rate limiter of the topic, if any, and hands the message to
+ *  the publisher tasks with publish_enqueue(). While the MQTT connection is
+ *  down the message is stored in the outbox instead, unless it is on a
+ *  diagnostics topic. Does not print.
+ *
+ * Parameters:
+ *  publish_lane_t lane : Lane of the message
+ *  const char *data : Payload, at most 'PUBLISH_PAYLOAD_SIZE' bytes
+ *  size_t payload_len : Length of the payload
+ *  const char *topic : Topic name, at most 'TOPIC_MAX_LENGTH' bytes
+ *  size_t topic_len : Length of the topic name
+ *  TickType_t wait : Ticks to wait for space on the lane queue
+ *
+ * Return:
+ *  publish_status_t : Outcome of the request
+ *
+ ******************************************************************************/
+static publish_status_t publish_submit(publish_lane_t lane,
+                                       const char *data, size_t payload_len,
+                                       const char *topic, size_t topic_len,
+                                       TickType_t wait)
+{
+    publish_rate_limit_t *limit = publish_rate_limit_find(topic, topic_len);
+    bool diagnostic = publish_is_diagnostic(topic, topic_len);
+    publish_status_t status;
+
+    if ((limit != NULL) && !publish_rate_limit_admit(limit, lane, data, payload_len))
+    {
+        status = PUBLISH_RATE_LIMITED;
+    }
+    /* Kept for the replay after the reconnection. Diagnostics describe the
+     * moment they were taken and are not worth the flash.
+     */
+    else if (!diagnostic && !mqtt_is_connected() &&
+             outbox_store(topic, topic_len, data, payload_len))
+    {
+        status = PUBLISH_STORED;
+    }
+    else
+    {
+        status = publish_enqueue(lane, data, payload_len, topic, topic_len, wait, true, true);
+    }
+
+    if (!diagnostic)
+    {
+        TRACE(TRACE_PUBLISH_SUBMIT, (uint32_t) payload_len, lane, status, (int) topic_len, topic);
+    }
+
+    return status;
+}
+
+/******************************************************************************
+ * Function Name: publish_payload
+ ******************************************************************************
+ * Summary:
+ *  Validates a message and hands it to publish_submit() on a lane, logging
+ *  why it was dropped if it was.
+ *
+ * Parameters:
+ *  publish_lane_t lane : Lane of the message
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload, at most 'PUBLISH_PAYLOAD_SIZE'
+ *  const char *topic : Null-terminated topic name
+ *
+ * Return:
+ *  bool : true if the message was queued, coalesced, stored or held back by
+ *         the rate limiter, false if it was dropped
+ *
+ ******************************************************************************/
+static bool publish_payload(publish_lane_t lane, const void *payload,
+                            size_t payload_len, const char *topic)
+{
+    const char *data = (const char *) payload;
+    size_t topic_len = strlen(topic);
+
+    if (topic_len > TOPIC_MAX_LENGTH)
+    {
+        LOG_WRN("Topic too long: %s", topic);
+        return false;
+    }
+
+    if (payload_len > PUBLISH_PAYLOAD_SIZE)
+    {
+        LOG_WRN("Payload of %u bytes too long for '%s'",
+                (unsigned int) payload_len, topic);
+        return false;
+    }
+
+    switch (publish_submit(lane, data, payload_len, topic, topic_len, pdMS_TO_TICKS(500)))
+    {
+        case PUBLISH_NO_SLOT:
+            LOG_WRN("No free publish slot, message on '%s' dropped", topic);
+            return false;
+
+        case PUBLISH_QUEUE_FULL:
+            LOG_WRN("Queue full, message on '%s' dropped", topic);
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+/******************************************************************************
+ * Function Name: PublishPayload
+ ******************************************************************************
+ * Summary:
+ *  Copies a message into a publish slot and hands the slot to the publisher
+ *  tasks on the telemetry lane. If a message for the same topic is still
+ *  waiting on the lane, its payload is replaced instead, so a burst of
+ *  updates costs a single MQTT PUBLISH carrying the latest value. Topics with
+ *  a rate limit only go ahead when their token bucket allows it. While the
+ *  MQTT connection is down, messages are stored in the outbox and replayed
+ *  after the reconnection. The payload may hold binary data. The caller's
+ *  buffers can be reused as soon as the function returns.
+ *
+ * Parameters:
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload, at most 'PUBLISH_PAYLOAD_SIZE'
+ *  const char *topic : Null-terminated topic name
+ *
+ * Return:
+ *  bool : true if the message was queued, coalesced, stored or held back by
+ *         the rate limiter, false if it was dropped
+ *
+ ******************************************************************************/
+bool PublishPayload(const void *payload, size_t payload_len, const char *topic)
+{
+    return publish_payload(PUBLISH_LANE_TELEMETRY, payload, payload_len, topic);
+}
+
+/******************************************************************************
+ * Function Name: PublishAlarm
+ ******************************************************************************
+ * Summary:
+ *  Publishes a message as PublishPayload() does, but on the alarm lane: the
+ *  publisher tasks take it before any queued telemetry, and it may use the
+ *  slots reserved for alarms.
+ *
+ * Parameters:
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload, at most 'PUBLISH_PAYLOAD_SIZE'
+ *  const char *topic : Null-terminated topic name
+ *
+ * Return:
+ *  bool : true if the message was queued, coalesced, stored or held back by
+ *         the rate limiter, false if it was dropped
+ *
+ ******************************************************************************/
+bool PublishAlarm(const void *payload, size_t payload_len, const char *topic)
+{
+    return publish_payload(PUBLISH_LANE_ALARM, payload, payload_len, topic);
+}
+
+/******************************************************************************
+ * Function Name: publisher_replay
+ ******************************************************************************
+ * Summary:
+ *  Hands a message replayed from the outbox, or a chunk of a stream (see
+ *  payload_stream.h), to the publisher tasks. Unlike PublishPayload(), the
+ *  message is neither rate limited nor coalesced with a queued message of
+ *  its topic, so every message is sent.
+ *
+ * Parameters:
+ *  const void *payload : Payload
+ *  size_t payload_len : Length of the payload, at most 'PUBLISH_PAYLOAD_SIZE'
+ *  const char *topic : Null-terminated topic name
+ *  bool outbox : Store the message in the outbox if its publish fails. Set
+ *                for an outbox replay, which drops its own copy once the
+ *                message is queued.
+ *
+ * Return:
+ *  bool : true if the message was queued, false if no slot or queue space
+ *         was available
+ *
+ ******************************************************************************/
+bool publisher_replay(const void *payload, size_t payload_len, const char *topic,
+                      bool outbox)
+{
+    size_t topic_len = strlen(topic);
+
+    if ((topic_len > TOPIC_MAX_LENGTH) || (payload_len > PUBLISH_PAYLOAD_SIZE))
+    {
+        return false;
+    }
+
+    return (publish_enqueue(PUBLISH_LANE_TELEMETRY, (const char *) payload, payload_len,
+                            topic, topic_len, pdMS_TO_TICKS(500), false, outbox) ==
+            PUBLISH_QUEUED);
+}
+
+/******************************************************************************
+ * Function Name: PublishMessage
+ ******************************************************************************
+ * Summary:
+ *  Publishes a text message, see PublishPayload(). Payloads longer than
+ *  'PUBLISH_PAYLOAD_SIZE' are truncated.
+ *
+ * Parameters:
+ *  const char *data : Null-terminated payload
+ *  const char *topic : Null-terminated topic name
+ *
+ * Return:
+ *  bool : true if the message was queued, coalesced or held back by the
+ *         rate limiter, false if it was dropped
+ *
+ ******************************************************************************/
+bool PublishMessage(const char* data, const char* topic)
+{
+    size_t payload_len = strlen(data);
+
+    if (payload_len > PUBLISH_PAYLOAD_SIZE)
+    {
+        LOG_WRN("Payload truncated to %u bytes", PUBLISH_PAYLOAD_SIZE);
+        payload_len = PUBLISH_PAYLOAD_SIZE;
+    }
+
+    return PublishPayload(data, payload_len, topic);
+}
+
+/******************************************************************************
+ * Function Name: PublishMessageFromISR
+ ******************************************************************************
+ * Summary:
+ *  Publishes a short text message from an interrupt handler. The message is
+ *  copied into the ISR ring without locks and a doorbell wakes a publisher
+ *  task, which hands it on as PublishAlarm() would. Never blocks and never
+ *  prints; messages that do not fit are counted and reported by the
+ *  publisher task.
+ *
+ * Parameters:
+ *  const char *data : Null-terminated payload, at most
+ *                     'PUBLISH_ISR_PAYLOAD_SIZE' bytes
+ *  const char *topic : Null-terminated topic name with static storage
+ *                      duration, e.g. a string literal. Only the pointer is
+ *                      stored.
+ *  BaseType_t *higher_priority_task_woken : Set to pdTRUE if a context
+ *                      switch should be requested before the interrupt
+ *                      handler exits, as with the FreeRTOS FromISR API
+ *
+ * Return:
+ *  bool : true if the message was put in the ring, false if it was dropped
+ *
+ ******************************************************************************/
+bool PublishMessageFromISR(const char *data, const char *topic,
+                           BaseType_t *higher_priority_task_woken)
+{
+    if ((publisher_work == NULL) || !publish_isr_push(topic, data, strlen(data)))
+    {
+        atomic_fetch_add(&publish_isr_dropped, 1u);
+        return false;
+    }
+
+    /* Ring the doorbell unless one is already waiting on the queue. */
+    if (!atomic_exchange(&publish_isr_doorbell, true))
+    {
+        publisher_data_t publisher_q_data = { .cmd = PUBLISH_ISR_MSGS, .slot = NULL };
+
+        if (xQueueSendFromISR(publish_lane_q[PUBLISH_LANE_ALARM], &publisher_q_data,
+                              higher_priority_task_woken) == pdTRUE)
+        {
+            xSemaphoreGiveFromISR(publisher_work, higher_priority_task_woken);
+        }
+        else
+        {
+            /* The message is drained after the next publish instead. */
+            atomic_store(&publish_isr_doorbell, false);
+        }
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: publish_isr_drain
+ ******************************************************************************
+ * Summary:
+ *  Hands every message of the ISR ring to the alarm lane, and reports
+ *  messages dropped since the last call.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_isr_drain(void)
+{
+    publish_isr_entry_t entry;
+    uint32_t dropped;
+
+    /* Cleared first, so that a message pushed from now on rings again. */
+    atomic_store(&publish_isr_doorbell, false);
+
+    while (publish_isr_pop(&entry))
+    {
+        size_t topic_len = strlen(entry.topic);
+
+        if ((topic_len > TOPIC_MAX_LENGTH) ||
+            (publish_submit(PUBLISH_LANE_ALARM, entry.payload, entry.payload_len,
+                            entry.topic, topic_len, 0) >= PUBLISH_NO_SLOT))
+        {
+            atomic_fetch_add(&publish_isr_dropped, 1u);
+        }
+    }
+
+    dropped = atomic_load(&publish_isr_dropped);
+    if (dropped != publish_isr_reported)
+    {
+        LOG_WRN("%lu messages from interrupt handlers dropped",
+                (unsigned long) (dropped - publish_isr_reported));
+        TRACE(TRACE_PUBLISH_ISR_DROP, dropped - publish_isr_reported);
+        publish_isr_reported = dropped;
+    }
+}
+
+/******************************************************************************
+ * Function Name: isr_button_press
+ ******************************************************************************
+ * Summary:
+ *  GPIO interrupt handler of the user button, see publisher_init(). Toggles
+ *  the device state by publishing 'MQTT_DEVICE_ON_MESSAGE' or
+ *  'MQTT_DEVICE_OFF_MESSAGE' on 'MQTT_PUB_TOPIC'. Not registered while the
+ *  call to publisher_init() in publisher_task() is disabled.
+ *
+ * Parameters:
+ *  void *callback_arg : Unused
+ *  cyhal_gpio_event_t event : Unused
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void isr_button_press(void *callback_arg, cyhal_gpio_event_t event)
+{
+    static bool device_on = false;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    /* To avoid compiler warnings */
+    (void) callback_arg;
+    (void) event;
+
+    device_on = !device_on;
+    PublishMessageFromISR(device_on ? MQTT_DEVICE_ON_MESSAGE : MQTT_DEVICE_OFF_MESSAGE,
+                          MQTT_PUB_TOPIC, &higher_priority_task_woken);
 
-    /* Send the command and data to publisher task over the queue */
-    //xQueueSendFromISR(publisher_task_q, &publisher_q_data, &xHigherPriorityTaskWoken);
-    xQueueSend(publisher_task_q, &publisher_q_data, pdMS_TO_TICKS(500));
-    //portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
 }
 
 /* [] END OF FILE */
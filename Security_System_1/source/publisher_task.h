@@ -45,6 +45,10 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "timers.h"
+
+#include "topic_registry.h"
+#include "publish_isr_ring.h"
 
 /*******************************************************************************
 * Macros
@@ -53,6 +57,42 @@
 #define PUBLISHER_TASK_PRIORITY               (2)
 #define PUBLISHER_TASK_STACK_SIZE             (1024 * 1)
 
+/* Number of publisher tasks, i.e. of QoS 1 publishes that can wait for their
+ * PUBACK at the same time. cy_mqtt_publish() blocks until the PUBACK arrives,
+ * so each outstanding publish needs a task of its own. The MQTT library must
+ * track as many outgoing publishes (CY_MQTT_MAX_OUTGOING_PUBLISHES), plus
+ * one for the session probe of the subscriber task.
+ */
+#ifndef PUBLISH_WINDOW_SIZE
+#define PUBLISH_WINDOW_SIZE                   (3u)
+#endif
+
+/* Number of publish slots, shared by the lanes. */
+#define PUBLISH_SLOT_COUNT                    (10u)
+
+/* Publish slots only the alarm lane may take, so that a telemetry backlog
+ * never leaves an alarm without a slot.
+ */
+#define PUBLISH_ALARM_RESERVED_SLOTS          (2u)
+
+/* Queue lengths of the publisher lanes. The telemetry queue holds every slot
+ * telemetry may take; the alarm queue also carries the publisher commands
+ * and the ISR doorbell.
+ */
+#define PUBLISH_ALARM_QUEUE_LENGTH            (4u)
+#define PUBLISH_TELEMETRY_QUEUE_LENGTH        (PUBLISH_SLOT_COUNT - PUBLISH_ALARM_RESERVED_SLOTS)
+
+/* Longest payload held by a publish slot, i.e. the TX buffer size of a
+ * message. Longer payloads are truncated, or sent with
+ * payload_stream_publish(). The RX size is set by 'MQTT_RX_BUFFER_SIZE'.
+ */
+#ifndef PUBLISH_PAYLOAD_SIZE
+#define PUBLISH_PAYLOAD_SIZE                  (128u)
+#endif
+
+/* Maximum number of rate limited topics. */
+#define PUBLISH_RATE_LIMIT_MAX_TOPICS         (4u)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -61,27 +101,109 @@ typedef enum
 {
     PUBLISHER_INIT,
     PUBLISHER_DEINIT,
-    PUBLISH_MQTT_MSG
+    PUBLISH_MQTT_MSG,
+    PUBLISH_ISR_MSGS            /* Doorbell, the ISR ring has messages */
 } publisher_cmd_t;
 
-/* Struct to be passed via the publisher task queue */
+/* Publisher lanes. A publisher task only takes a message from the telemetry
+ * lane when the alarm lane is empty.
+ */
+typedef enum
+{
+    PUBLISH_LANE_ALARM,
+    PUBLISH_LANE_TELEMETRY,
+    PUBLISH_LANE_COUNT
+} publish_lane_t;
+
+/* State of a publish slot. */
+typedef enum
+{
+    PUBLISH_SLOT_FREE,          /* Available to PublishMessage() */
+    PUBLISH_SLOT_QUEUED,        /* On a lane queue or parked, newer payloads
+                                 * for the same topic and lane replace its
+                                 * payload */
+    PUBLISH_SLOT_SENDING        /* Being published, not modified any more */
+} publish_slot_state_t;
+
+/* Copy of an outgoing message, owned by the publisher until it is sent. */
+typedef struct
+{
+    publish_slot_state_t state;
+    publish_lane_t lane;
+    TickType_t queued_tick;             /* Tick the slot was queued at */
+    uint32_t sequence;                  /* Queueing order of the slots */
+    bool parked;                        /* Taken off its lane queue, waits for
+                                         * an older message for the topic */
+    bool diagnostic;                    /* On a diagnostics topic, kept out of
+                                         * the trace and link and wire stats */
+    bool outbox;                        /* Stored in the outbox if its publish
+                                         * fails */
+    uint16_t topic_len;
+    uint16_t payload_len;
+    char topic[TOPIC_MAX_LENGTH + 1];
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+} publish_slot_t;
+
+/* Token bucket limiting the publish rate of a topic. Tokens are counted in
+ * 1/configTICK_RATE_HZ units, so that a rate in messages per second is also
+ * the refill per tick. A publish that finds the bucket empty is suppressed;
+ * the latest suppressed payload is sent by the flush timer as soon as a token
+ * is available, so the final state of the topic always goes out.
+ */
+typedef struct
+{
+    uint16_t topic_len;
+    uint16_t rate;                      /* Messages per second */
+    uint32_t capacity;                  /* Burst, in token units */
+    uint32_t tokens;                    /* Available tokens, in token units */
+    TickType_t refill_tick;             /* Tick of the last refill */
+    uint32_t suppressed;                /* Publishes held back by the limiter */
+    uint32_t reported;                  /* 'suppressed' at the last report */
+    bool pending;                       /* 'pending_payload' awaits the flush */
+    publish_lane_t pending_lane;        /* Lane of 'pending_payload' */
+    uint16_t pending_len;               /* Length of 'pending_payload' */
+    TimerHandle_t flush_timer;          /* Trailing-edge flush */
+    char topic[TOPIC_MAX_LENGTH + 1];
+    char pending_payload[PUBLISH_PAYLOAD_SIZE + 1];
+} publish_rate_limit_t;
+
+/* Queueing delay of the messages taken from a lane since the last report. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t total_ticks;
+    TickType_t max_ticks;
+} publish_lane_stats_t;
+
+/* Struct to be passed via the publisher lane queues */
 typedef struct{
 	publisher_cmd_t cmd;
-	char *topic;
-    char *data;
+	publish_slot_t *slot;       /* Message to publish (PUBLISH_MQTT_MSG) */
 } publisher_data_t;
 
 /*******************************************************************************
 * Extern Variables
 ********************************************************************************/
-extern TaskHandle_t publisher_task_handle;
-extern QueueHandle_t publisher_task_q;
+extern TaskHandle_t publisher_task_handle[PUBLISH_WINDOW_SIZE];
 
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
 void publisher_task(void *pvParameters);
+bool publisher_create_queues(void);
+void publisher_send_command(publisher_cmd_t cmd);
 void SendMessage(char* data, char* topic);
+bool PublishMessage(const char* data, const char* topic);
+bool PublishPayload(const void *payload, size_t payload_len, const char *topic);
+bool PublishAlarm(const void *payload, size_t payload_len, const char *topic);
+bool publisher_replay(const void *payload, size_t payload_len, const char *topic,
+                      bool outbox);
+bool PublishMessageFromISR(const char *data, const char *topic,
+                           BaseType_t *higher_priority_task_woken);
+bool publisher_set_rate_limit(const char *topic, uint16_t rate, uint8_t burst);
+void publish_rate_limit_diagnostics(void);
+void publish_lane_diagnostics(void);
+size_t publisher_tx_peak(void);
 
 #endif /* PUBLISHER_TASK_H_ */
 
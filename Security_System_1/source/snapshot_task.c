@@ -0,0 +1,219 @@
+/******************************************************************************
+* File Name:   snapshot_task.c
+*
+* Description: This file contains the task that aggregates the latest
+*              samples of the member sensors into one periodic snapshot
+*              message on 'MQTT_SNAPSHOT_TOPIC', instead of one MQTT PUBLISH
+*              per sensor reading.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "mqtt_client_config.h"
+#include "publisher_task.h"
+#include "snapshot_task.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (SNAPSHOT_MAX_MEMBERS > UINT8_MAX)
+    #error "SNAPSHOT_MAX_MEMBERS must not exceed 255."
+#endif
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Snapshot Task handle */
+TaskHandle_t snapshot_task_handle;
+
+/* Members of the snapshot. A member is filled in before it is counted and
+ * never removed; its sample is accessed inside a critical section.
+ */
+static snapshot_member_t snapshot_members[SNAPSHOT_MAX_MEMBERS];
+static volatile uint32_t snapshot_member_count = 0;
+
+/******************************************************************************
+ * Function Name: snapshot_task
+ ******************************************************************************
+ * Summary:
+ *  Task that publishes the latest sample of every member sensor as one
+ *  message every 'SNAPSHOT_PERIOD_MS'. A period in which no member reported
+ *  a new sample publishes nothing.
+ *
+ * Parameters:
+ *  void *pvParameters : Task parameter defined during task creation (unused)
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void snapshot_task(void *pvParameters)
+{
+    const char *names[SNAPSHOT_MAX_MEMBERS];
+    telemetry_sample_t samples[SNAPSHOT_MAX_MEMBERS];
+    uint8_t payload[PUBLISH_PAYLOAD_SIZE];
+    TickType_t wake_tick = xTaskGetTickCount();
+
+    /* To avoid compiler warnings */
+    (void)pvParameters;
+
+    while (true)
+    {
+        uint32_t count = 0;
+        bool updated = false;
+        size_t payload_len;
+
+        vTaskDelayUntil(&wake_tick, pdMS_TO_TICKS(SNAPSHOT_PERIOD_MS));
+
+        taskENTER_CRITICAL();
+        for (uint32_t i = 0; i < snapshot_member_count; i++)
+        {
+            if (snapshot_members[i].valid)
+            {
+                names[count] = snapshot_members[i].name;
+                samples[count] = snapshot_members[i].sample;
+                count++;
+            }
+            updated |= snapshot_members[i].updated;
+            snapshot_members[i].updated = false;
+        }
+        taskEXIT_CRITICAL();
+
+        if (!updated)
+        {
+            continue;
+        }
+
+        payload_len = telemetry_encode_snapshot(names, samples, count, payload, sizeof(payload));
+        if (payload_len == 0)
+        {
+            printf("  Snapshot: %lu samples do not fit a publish slot\n", (unsigned long) count);
+            continue;
+        }
+
+        PublishPayload(payload, payload_len, MQTT_SNAPSHOT_TOPIC);
+    }
+}
+
+/******************************************************************************
+ * Function Name: snapshot_register
+ ******************************************************************************
+ * Summary:
+ *  Makes a sensor a member of the snapshot.
+ *
+ * Parameters:
+ *  const char *name : Null-terminated key of the sensor in the snapshot
+ *
+ * Return:
+ *  snapshot_member_t * : The member, NULL if the name is too long or the
+ *                        snapshot is full
+ *
+ ******************************************************************************/
+snapshot_member_t *snapshot_register(const char *name)
+{
+    size_t name_len = strlen(name);
+    snapshot_member_t *member = NULL;
+
+    if (name_len > TOPIC_MAX_LENGTH)
+    {
+        return NULL;
+    }
+
+    taskENTER_CRITICAL();
+    if (snapshot_member_count < SNAPSHOT_MAX_MEMBERS)
+    {
+        member = &snapshot_members[snapshot_member_count];
+        memcpy(member->name, name, name_len + 1);
+        member->valid = false;
+        member->updated = false;
+        snapshot_member_count++;
+    }
+    taskEXIT_CRITICAL();
+
+    return member;
+}
+
+/******************************************************************************
+ * Function Name: snapshot_report
+ ******************************************************************************
+ * Summary:
+ *  Records the latest sample of a member sensor for the next snapshot. An
+ *  urgent sample is also published right away on the topic of the sensor,
+ *  on the alarm lane. A sensor that is not a member (NULL) has all its
+ *  samples published right away.
+ *
+ * Parameters:
+ *  snapshot_member_t *member : Member returned by snapshot_register(), or
+ *                              NULL
+ *  const char *topic : Null-terminated topic of the sensor
+ *  const telemetry_sample_t *sample : Sample
+ *  bool urgent : Publish the sample without waiting for the snapshot
+ *
+ * Return:
+ *  bool : false if a sample to be published right away was dropped, true
+ *         otherwise
+ *
+ ******************************************************************************/
+bool snapshot_report(snapshot_member_t *member, const char *topic,
+                     const telemetry_sample_t *sample, bool urgent)
+{
+    if (member == NULL)
+    {
+        return telemetry_publish(sample, topic,
+                                 urgent ? PUBLISH_LANE_ALARM : PUBLISH_LANE_TELEMETRY);
+    }
+
+    taskENTER_CRITICAL();
+    member->sample = *sample;
+    member->valid = true;
+    member->updated = true;
+    taskEXIT_CRITICAL();
+
+    if (urgent)
+    {
+        return telemetry_publish(sample, topic, PUBLISH_LANE_ALARM);
+    }
+
+    return true;
+}
+
+/* [] END OF FILE */
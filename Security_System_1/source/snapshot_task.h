@@ -0,0 +1,89 @@
+/******************************************************************************
+* File Name:   snapshot_task.h
+*
+* Description: This file is the public interface of snapshot_task.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SNAPSHOT_TASK_H_
+#define SNAPSHOT_TASK_H_
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "topic_registry.h"
+#include "telemetry_codec.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Task parameters for Snapshot Task. Below the publisher tasks, a snapshot
+ * is never urgent.
+ */
+#define SNAPSHOT_TASK_PRIORITY             (1)
+#define SNAPSHOT_TASK_STACK_SIZE           (1024 * 1)
+
+/* Number of sensors that can be members of the snapshot. */
+#define SNAPSHOT_MAX_MEMBERS               (4u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Sensor whose latest sample is part of the snapshot. */
+typedef struct
+{
+    bool updated;                       /* 'sample' changed since the last snapshot */
+    bool valid;                         /* 'sample' has been reported */
+    telemetry_sample_t sample;
+    char name[TOPIC_MAX_LENGTH + 1];    /* Key of the sensor in the snapshot */
+} snapshot_member_t;
+
+extern TaskHandle_t snapshot_task_handle;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void snapshot_task(void *pvParameters);
+snapshot_member_t *snapshot_register(const char *name);
+bool snapshot_report(snapshot_member_t *member, const char *topic,
+                     const telemetry_sample_t *sample, bool urgent);
+
+#endif /* SNAPSHOT_TASK_H_ */
+
+/* [] END OF FILE */
@@ -50,6 +50,17 @@
 /* Task header files */
 #include "subscriber_task.h"
 #include "mqtt_task.h"
+#include "topic_registry.h"
+#include "topic_filter.h"
+#include "publisher_task.h"
+#include "trace_log.h"
+#include "link_quality.h"
+#include "wire_stats.h"
+
+/* Log module of this file, see log_task.h. */
+#define LOG_MODULE                              "Subscriber"
+#define LOG_MODULE_LEVEL                        LOG_LEVEL_SUBSCRIBER
+#include "log_task.h"
 
 /* Configuration file for MQTT client */
 #include "mqtt_client_config.h"
@@ -67,14 +78,68 @@
 /* Time interval in milliseconds between MQTT subscribe retries. */
 #define MQTT_SUBSCRIBE_RETRY_INTERVAL_MS        (1000)
 
-/* The number of MQTT topics to be subscribed to. */
+/* The number of MQTT topics to be unsubscribed from. */
 #define SUBSCRIPTION_COUNT                      (1)
 
+/* Subscription requests arriving less than this many milliseconds apart are
+ * sent to the broker in one SUBSCRIBE packet.
+ */
+#define SUBSCRIBE_BATCH_WINDOW_MS               (100)
+
+/* Maximum number of subscription requests in one batch. */
+#define SUBSCRIBE_BATCH_MAX_TOPICS              (8u)
+
+/* Encoded size of a SUBSCRIBE packet without its topic filters (fixed header,
+ * remaining length and packet identifier), and the size each topic filter adds
+ * on top of its name (length prefix and requested QoS).
+ */
+#define SUBSCRIBE_PACKET_OVERHEAD               (5u)
+#define SUBSCRIBE_FILTER_OVERHEAD               (3u)
+
+/* Size of the diagnostics payload buffer published on MQTT_DIAGNOSTICS_TOPIC,
+ * including the null terminator. The payload has to fit in a publish slot.
+ */
+#define TOPIC_DIAGNOSTICS_PAYLOAD_SIZE          (PUBLISH_PAYLOAD_SIZE + 1u)
+
+/* Maximum number of topic queues an inbound message is delivered to: the
+ * queue of the exact topic plus the queues of the matching topic filters.
+ */
+#define SUBSCRIPTION_MAX_MATCHES                (8u)
+
 /* Queue length of a message queue that is used to communicate with the 
  * subscriber task.
  */
 #define SUBSCRIBER_TASK_QUEUE_LENGTH            (1u)
 
+/* Bytes of a mailbox item: the payload length followed by the payload. */
+#define TOPIC_MAILBOX_ITEM_SIZE(config)         (offsetof(topic_mailbox_item_t, payload) + \
+                                                 (config)->max_payload)
+
+/* Bytes of a message buffer holding 'depth' payloads of the maximum size. */
+#define TOPIC_MESSAGE_BUFFER_SIZE(config)       ((config)->depth * \
+                                                 (sizeof(configMESSAGE_BUFFER_LENGTH_TYPE) + \
+                                                  (config)->max_payload))
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Item of a mailbox. Only the first TOPIC_MAILBOX_ITEM_SIZE() bytes are
+ * stored, so a mailbox reserves no more than the payload size of its topic.
+ */
+typedef struct
+{
+    uint16_t payload_len;
+    char payload[MESSAGE_POOL_PAYLOAD_SIZE];
+} topic_mailbox_item_t;
+
+/* Subscription request waiting for the next batched SUBSCRIBE. */
+typedef struct
+{
+    topic_registry_entry_t *entry;  /* Topic to subscribe to */
+    TaskHandle_t task;              /* Requesting task */
+    uint8_t filter;                 /* Index of the topic filter in the SUBSCRIBE */
+} subscribe_request_t;
+
 /******************************************************************************
 * Global Variables
 *******************************************************************************/
@@ -97,11 +162,36 @@ cy_mqtt_subscribe_info_t subscribe_info =
     .topic_len = (sizeof(MQTT_SUB_TOPIC) - 1)
 };
 
+/* Subscription requests collected for the next batched SUBSCRIBE. */
+static subscribe_request_t subscribe_batch[SUBSCRIBE_BATCH_MAX_TOPICS];
+static uint8_t subscribe_batch_count = 0;
+
+/* Largest PUBLISH packet received so far, written by the MQTT callback only. */
+static uint32_t rx_peak_bytes = 0;
+
+#if MQTT_PERSISTENT_SESSION
+/* Topic of the session probe, '<client identifier>/session'. */
+static char session_probe_topic[TOPIC_MAX_LENGTH + 1];
+static uint16_t session_probe_topic_len = 0;
+#endif /* MQTT_PERSISTENT_SESSION */
+
 /******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-void subscribe_to_topic(char* topic);
+static void subscribe_batch_add(char* topic, TaskHandle_t task, const topic_config_t *config);
+static void subscribe_batch_flush(void);
+static cy_rslt_t subscribe_filters(cy_mqtt_subscribe_info_t *filters, size_t filter_count);
+static bool is_topic_covered(topic_registry_entry_t *entry);
+static void resubscribe_topics(bool covered);
+static void resubscribe_all_topics(TickType_t disconnect_tick);
+#if MQTT_PERSISTENT_SESSION
+static void session_probe_subscribe(void);
+static bool session_probe(void);
+#endif /* MQTT_PERSISTENT_SESSION */
+static void subscribe_notify(TaskHandle_t task, cy_mqtt_qos_t allocated_qos);
 static void unsubscribe_from_topic(void);
+static void publish_topic_diagnostics(void);
+static void publish_buffer_diagnostics(void);
 void print_heap_usage(char *msg);
 
 /******************************************************************************
@@ -125,6 +215,10 @@ void subscriber_task(void *pvParameters)
 {
     subscriber_data_t subscriber_q_data;
 
+    /* Tick count of the previous diagnostics report. */
+    const TickType_t diagnostics_interval = pdMS_TO_TICKS(TOPIC_DIAGNOSTICS_INTERVAL_MS);
+    TickType_t diagnostics_tick = xTaskGetTickCount();
+
     (void) pvParameters;
 
    // cyhal_gpio_init(CYBSP_USER_LED, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_PULLUP,
@@ -136,280 +230,1674 @@ void subscriber_task(void *pvParameters)
 
 
     //vTaskDelay(1000);
+#if MQTT_PERSISTENT_SESSION
+    session_probe_subscribe();
+#endif /* MQTT_PERSISTENT_SESSION */
     mqttConnected = 1;
 
 
 
     while (true)
     {
-        if (pdTRUE == xQueueReceive(subscriber_task_q, &subscriber_q_data, portMAX_DELAY))
+        /* Wait for more subscription requests while a batch is open, else
+         * until the next diagnostics report is due.
+         */
+        TickType_t wait = pdMS_TO_TICKS(SUBSCRIBE_BATCH_WINDOW_MS);
+        if (subscribe_batch_count == 0)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - diagnostics_tick;
+            wait = (elapsed < diagnostics_interval) ? (diagnostics_interval - elapsed) : 0;
+        }
+
+        if (pdTRUE != xQueueReceive(subscriber_task_q, &subscriber_q_data, wait))
         {
-        	subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
-            switch(subscriber_q_data.cmd)
+            if (subscribe_batch_count > 0)
             {
-                case SUBSCRIBE_TO_TOPIC:
-                {
-                    subscribe_to_topic(subscriber_q_data.topic);
-                    break;
-                }
+                /* The batching window closed without a new request. */
+                subscribe_batch_flush();
+                print_topic_budget();
+            }
+            else
+            {
+                publish_topic_diagnostics();
+                publish_buffer_diagnostics();
+                publish_rate_limit_diagnostics();
+                publish_lane_diagnostics();
+                link_quality_diagnostics();
+                wire_stats_diagnostics();
+                trace_log_dump();
+                diagnostics_tick = xTaskGetTickCount();
+            }
+            continue;
+        }
 
-                case UNSUBSCRIBE_FROM_TOPIC:
+        switch(subscriber_q_data.cmd)
+        {
+            case SUBSCRIBE_TO_TOPIC:
+            {
+                subscribe_batch_add(subscriber_q_data.topic, subscriber_q_data.task,
+                                    &subscriber_q_data.config);
+                if (subscribe_batch_count == SUBSCRIBE_BATCH_MAX_TOPICS)
                 {
-                    unsubscribe_from_topic();
-                    break;
+                    subscribe_batch_flush();
                 }
+                break;
+            }
 
-                case UPDATE_DEVICE_STATE:
-                {
-                    //cyhal_gpio_write(CYBSP_USER_LED, subscriber_q_data.data);
+            case RESUBSCRIBE_ALL_TOPICS:
+            {
+                resubscribe_all_topics(subscriber_q_data.tick);
+                break;
+            }
+
+            case UNSUBSCRIBE_FROM_TOPIC:
+            {
+                subscribe_batch_flush();
+                unsubscribe_from_topic();
+                break;
+            }
 
-                    //current_device_state = subscriber_q_data.data;
+            case UPDATE_DEVICE_STATE:
+            {
+                //cyhal_gpio_write(CYBSP_USER_LED, subscriber_q_data.data);
 
-                    //print_heap_usage("subscriber_task: After updating LED state");
-                    break;
-                }
+                //current_device_state = subscriber_q_data.data;
+
+                //print_heap_usage("subscriber_task: After updating LED state");
+                break;
             }
         }
     }
 }
 
-size_t topic_count = 0;
-#define topic_capacity  50
+/******************************************************************************
+ * Function Name: topic_storage_size
+ ******************************************************************************
+ * Summary:
+ *  Function that returns the number of RAM bytes reserved by the storage of
+ *  one consuming task of a topic with the given settings. The message pool
+ *  blocks referenced by a queue are not included, they are reserved once for
+ *  all topics.
+ *
+ * Parameters:
+ *  const topic_config_t *config : Storage settings of the topic
+ *
+ * Return:
+ *  size_t : Reserved bytes
+ *
+ ******************************************************************************/
+static size_t topic_storage_size(const topic_config_t *config)
+{
+    switch (config->kind)
+    {
+        case TOPIC_STORAGE_MESSAGE_BUFFER:
+            return sizeof(StaticMessageBuffer_t) + TOPIC_MESSAGE_BUFFER_SIZE(config) + 1u;
+
+        case TOPIC_STORAGE_MAILBOX:
+            return sizeof(StaticQueue_t) + TOPIC_MAILBOX_ITEM_SIZE(config);
 
-topic_queue_entry_t topic_queues[topic_capacity];
+        case TOPIC_STORAGE_NOTIFY:
+        case TOPIC_STORAGE_CALLBACK:
+            return 0;
+
+        case TOPIC_STORAGE_QUEUE:
+        default:
+            return sizeof(StaticQueue_t) + (config->depth * sizeof(subscriber_msg_t *));
+    }
+}
 
 /******************************************************************************
- * Function Name: subscribe_to_topic
+ * Function Name: create_topic_storage
  ******************************************************************************
  * Summary:
- *  Function that subscribes to the MQTT topic specified by the macro 
- *  'MQTT_SUB_TOPIC'. This operation is retried a maximum of 
- *  'MAX_SUBSCRIBE_RETRIES' times with interval of 
- *  'MQTT_SUBSCRIBE_RETRY_INTERVAL_MS' milliseconds.
+ *  Function that creates the storage of one consuming task of a topic.
  *
  * Parameters:
- *  void
+ *  const topic_config_t *config : Storage settings of the topic
+ *  topic_subscriber_t *subscriber : Subscriber receiving the storage handle
  *
  * Return:
- *  void
+ *  bool : true if the storage was created, else false
  *
  ******************************************************************************/
-QueueHandle_t get_queue_for_topic(const char *topic) {
-    // Search for the topic in the list
-    for (size_t i = 0; i < topic_capacity; i++) {
-        if (strcmp(topic_queues[i].topic, topic) == 0) {
-            return topic_queues[i].queue;  // Topic found, return the queue
-        }
+static bool create_topic_storage(const topic_config_t *config,
+                                 topic_subscriber_t *subscriber)
+{
+    switch (config->kind)
+    {
+        case TOPIC_STORAGE_MESSAGE_BUFFER:
+            subscriber->message_buffer = xMessageBufferCreate(TOPIC_MESSAGE_BUFFER_SIZE(config));
+            return (subscriber->message_buffer != NULL);
+
+        case TOPIC_STORAGE_MAILBOX:
+            subscriber->queue = xQueueCreate(1, TOPIC_MAILBOX_ITEM_SIZE(config));
+            return (subscriber->queue != NULL);
+
+        case TOPIC_STORAGE_NOTIFY:
+        case TOPIC_STORAGE_CALLBACK:
+            /* Values go to the notification array of the task itself, and
+             * callback topics go straight to their handler
+             */
+            subscriber->queue = NULL;
+            return true;
+
+        case TOPIC_STORAGE_QUEUE:
+        default:
+            subscriber->queue = xQueueCreate(config->depth, sizeof(subscriber_msg_t *));
+            return (subscriber->queue != NULL);
     }
+}
 
-    printf("Error: Topic not found: %s\n", topic);
-    return NULL;  // Topic not found
+/******************************************************************************
+ * Function Name: delete_topic_storage
+ ******************************************************************************
+ * Summary:
+ *  Function that deletes a storage created by create_topic_storage() that
+ *  was never attached to the topic registry.
+ *
+ * Parameters:
+ *  const topic_config_t *config : Storage settings of the topic
+ *  topic_subscriber_t *subscriber : Subscriber holding the storage handle
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void delete_topic_storage(const topic_config_t *config,
+                                 topic_subscriber_t *subscriber)
+{
+    if (config->kind == TOPIC_STORAGE_MESSAGE_BUFFER)
+    {
+        vMessageBufferDelete(subscriber->message_buffer);
+    }
+    else if ((config->kind != TOPIC_STORAGE_NOTIFY) && (config->kind != TOPIC_STORAGE_CALLBACK))
+    {
+        vQueueDelete(subscriber->queue);
+    }
 }
 
-QueueHandle_t add_queue_for_topic(const char *topic) {
-    // Ensure there is space for new topics
-    if ( topic_count >= topic_capacity) {
-        printf("Error: Topic list full\n");
-        return NULL;
+/******************************************************************************
+ * Function Name: topic_receive
+ ******************************************************************************
+ * Summary:
+ *  Function that waits for the next message of the given topic delivered to
+ *  the calling task and copies its payload into the given buffer. The copy
+ *  is truncated to the buffer size and always null-terminated.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name
+ *  char *buffer : Buffer receiving the payload
+ *  size_t buffer_size : Size of the buffer, including the null terminator
+ *  TickType_t wait : Ticks to wait for a message
+ *
+ * Return:
+ *  size_t : Number of payload bytes copied, 0 on timeout or if the task is
+ *           not subscribed to the topic
+ *
+ ******************************************************************************/
+size_t topic_receive(const char *topic, char *buffer, size_t buffer_size, TickType_t wait)
+{
+    topic_registry_entry_t *entry = topic_registry_find(topic, strlen(topic));
+    const topic_subscriber_t *subscriber = NULL;
+    topic_mailbox_item_t item;
+    subscriber_msg_t *msg;
+    size_t payload_len = 0;
+
+    if (buffer_size == 0)
+    {
+        return 0;
     }
 
-    // Create a new queue for the topic
-    QueueHandle_t new_queue = xQueueCreate(10, sizeof(char[128]));
-    if (new_queue == NULL) {
-        printf("Error: Failed to create queue for topic: %s\n", topic);
-        return NULL;
+    if (entry != NULL)
+    {
+        subscriber = topic_registry_get_subscriber(entry, xTaskGetCurrentTaskHandle());
     }
 
-    // Add the topic and its queue to the array
-    topic_queues[topic_count].topic = strdup(topic);  // Store the topic name
-    topic_queues[topic_count].queue = new_queue;       // Store the queue
-    topic_count++;
+    if (subscriber == NULL)
+    {
+        printf("Error: Topic not found: %s\n", topic);
+        /* The subscription may still be pending in the subscriber task */
+        vTaskDelay(pdMS_TO_TICKS(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS));
+        buffer[0] = '\0';
+        return 0;
+    }
 
-    printf("Added topic: %s to topic list\n", topic);
-    return new_queue;
-}
+    switch (entry->config.kind)
+    {
+        case TOPIC_STORAGE_NOTIFY:
+            printf("Error: Topic %s delivers values, use topic_receive_value()\n", topic);
+            break;
 
-void subscribe_to_topic(char* topic)
-{
-    /* Status variable */
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+        case TOPIC_STORAGE_CALLBACK:
+            printf("Error: Topic %s delivers to its handler\n", topic);
+            break;
 
-    /* Command to the MQTT client task */
-    mqtt_task_cmd_t mqtt_task_cmd;
+        case TOPIC_STORAGE_MESSAGE_BUFFER:
+            payload_len = xMessageBufferReceive(subscriber->message_buffer, item.payload,
+                                                entry->config.max_payload, wait);
+            break;
 
+        case TOPIC_STORAGE_MAILBOX:
+            if (xQueueReceive(subscriber->queue, &item, wait) == pdTRUE)
+            {
+                payload_len = item.payload_len;
+            }
+            break;
 
-	subscribe_info.topic = topic;
-	subscribe_info.topic_len =  strlen(topic);
+        case TOPIC_STORAGE_QUEUE:
+        default:
+            if (xQueueReceive(subscriber->queue, &msg, wait) == pdTRUE)
+            {
+                payload_len = (msg->payload_len < entry->config.max_payload) ?
+                              msg->payload_len : entry->config.max_payload;
+                payload_len = (payload_len < buffer_size) ? payload_len : (buffer_size - 1);
+                memcpy(buffer, msg->payload, payload_len);
+                subscriber_msg_release(msg);
+                buffer[payload_len] = '\0';
+                return payload_len;
+            }
+            break;
+    }
 
+    payload_len = (payload_len < buffer_size) ? payload_len : (buffer_size - 1);
+    memcpy(buffer, item.payload, payload_len);
+    buffer[payload_len] = '\0';
 
-// Create a null-terminated version of the topic
-	char *null_terminated_topic = malloc(strlen(topic) + 1); // +1 for null terminator
-	if (null_terminated_topic == NULL) {
-		printf("Error: Failed to allocate memory for null-terminated topic\n");
-		return;
-	}
-	memcpy(null_terminated_topic, topic, strlen(topic)); // Copy topic data
-	null_terminated_topic[strlen(topic)] = '\0'; // Add null terminator
+    return payload_len;
+}
 
-	add_queue_for_topic(null_terminated_topic);
+/******************************************************************************
+ * Function Name: topic_receive_value
+ ******************************************************************************
+ * Summary:
+ *  Function that waits for the next value of the given topic, which must
+ *  have been registered by the calling task with TOPIC_STORAGE_NOTIFY
+ *  storage. The value is decoded by the MQTT callback and delivered as a
+ *  task notification value, so no payload is copied.
+ *
+ * Parameters:
+ *  const char *topic : Null-terminated topic name
+ *  uint32_t *value : Receives the value
+ *  TickType_t wait : Ticks to wait for a value
+ *
+ * Return:
+ *  bool : true if a value was received, false on timeout or if the task is
+ *         not subscribed to the topic
+ *
+ ******************************************************************************/
+bool topic_receive_value(const char *topic, uint32_t *value, TickType_t wait)
+{
+    topic_registry_entry_t *entry = topic_registry_find(topic, strlen(topic));
 
+    if ((entry == NULL) || (entry->config.kind != TOPIC_STORAGE_NOTIFY) ||
+        (topic_registry_get_subscriber(entry, xTaskGetCurrentTaskHandle()) == NULL))
+    {
+        printf("Error: Topic not found: %s\n", topic);
+        /* The subscription may still be pending in the subscriber task */
+        vTaskDelay(pdMS_TO_TICKS(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS));
+        return false;
+    }
 
-	free(null_terminated_topic);   // Free topic if send fails
+    return (xTaskNotifyWaitIndexed(TOPIC_NOTIFY_INDEX, 0, UINT32_MAX, value, wait) == pdTRUE);
+}
 
-    /* Subscribe with the configured parameters. */
-    for (uint32_t retry_count = 0; retry_count < MAX_SUBSCRIBE_RETRIES; retry_count++)
+/******************************************************************************
+ * Function Name: is_notify_bound
+ ******************************************************************************
+ * Summary:
+ *  Function that checks if a task already consumes a topic with
+ *  TOPIC_STORAGE_NOTIFY storage. A task has a single notification value for
+ *  such topics, so it cannot consume two of them.
+ *
+ * Parameters:
+ *  TaskHandle_t task : Consuming task
+ *
+ * Return:
+ *  bool : true if the task is bound to a TOPIC_STORAGE_NOTIFY topic
+ *
+ ******************************************************************************/
+static bool is_notify_bound(TaskHandle_t task)
+{
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
     {
-        result = cy_mqtt_subscribe(mqtt_connection, &subscribe_info, SUBSCRIPTION_COUNT);
-        if (result == CY_RSLT_SUCCESS)
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if ((entry != NULL) && (entry->config.kind == TOPIC_STORAGE_NOTIFY) &&
+            (topic_registry_get_subscriber(entry, task) != NULL))
         {
-            printf("\nMQTT client subscribed to the topic '%.*s' successfully.\n", 
-                    subscribe_info.topic_len, subscribe_info.topic);
-            break;
+            return true;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS));
     }
 
-    if (result != CY_RSLT_SUCCESS)
-    {
-        printf("\nMQTT Subscribe failed with error 0x%0X after %d retries...\n\n", 
-               (int)result, MAX_SUBSCRIBE_RETRIES);
-
-        /* Notify the MQTT client task about the subscription failure */
-        mqtt_task_cmd = HANDLE_MQTT_SUBSCRIBE_FAILURE;
-        xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
-    }
+    return false;
 }
 
-
-
 /******************************************************************************
- * Function Name: mqtt_subscription_callback
+ * Function Name: add_storage_for_topic
  ******************************************************************************
  * Summary:
- *  Callback to handle incoming MQTT messages. This callback prints the 
- *  contents of the incoming message and informs the subscriber task, via a 
- *  message queue, to turn on / turn off the device based on the received 
- *  message.
+ *  Function that adds the given topic to the topic registry and attaches a
+ *  storage for the consuming task to it. Topic filters with '+' or '#'
+ *  wildcards are also added to the topic filter trie, and dropped from the
+ *  registry again if the trie cannot hold them. The storage settings
+ *  are only applied when the topic is first registered. If the task is
+ *  already attached to the topic, its existing storage is kept.
  *
  * Parameters:
- *  cy_mqtt_publish_info_t *received_msg_info : Information structure of the 
- *                                              received MQTT message
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *  TaskHandle_t task : Task that consumes the topic
+ *  const topic_config_t *config : Requested storage settings of the topic
  *
  * Return:
- *  void
+ *  topic_registry_entry_t * : Registry entry of the topic, NULL on failure
  *
  ******************************************************************************/
-void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
+static topic_registry_entry_t *add_storage_for_topic(const char *topic, size_t topic_len,
+                                                     TaskHandle_t task,
+                                                     const topic_config_t *config)
 {
+    topic_registry_entry_t *entry = topic_registry_find(topic, topic_len);
+    topic_subscriber_t subscriber = { .task = task };
 
+    if (entry == NULL)
+    {
+        /* Ensure there is space for new topics */
+        if (topic_registry_count() >= TOPIC_REGISTRY_MAX_TOPICS)
+        {
+            printf("Error: Topic list full\n");
+            return NULL;
+        }
 
-    // Extract the topic and message from the received MQTT message
-    const char *received_msg = received_msg_info->payload;
-    int received_msg_len = received_msg_info->payload_len;
-    const char *received_topic = received_msg_info->topic;
-    int received_topic_len = received_msg_info->topic_len;
+        /* Keep the settings within what the storage and the message pool support */
+        topic_config_t settings = *config;
+        if (settings.depth == 0)
+        {
+            settings.depth = 1;
+        }
+        if (settings.kind == TOPIC_STORAGE_CALLBACK)
+        {
+            /* Handlers see the payload in the network buffer, nothing is copied */
+            if (settings.callback == NULL)
+            {
+                printf("Error: Callback topic without a handler: %.*s\n", (int) topic_len, topic);
+                return NULL;
+            }
+            settings.max_payload = MQTT_RX_BUFFER_SIZE;
+        }
+        else if ((settings.max_payload == 0) ||
+                 (settings.max_payload > MESSAGE_POOL_PAYLOAD_SIZE))
+        {
+            settings.max_payload = MESSAGE_POOL_PAYLOAD_SIZE;
+        }
+        if ((settings.kind == TOPIC_STORAGE_MESSAGE_BUFFER) &&
+            (settings.overflow == TOPIC_OVERFLOW_DROP_OLDEST))
+        {
+            printf("Message buffer cannot drop its oldest message, dropping newest instead\n");
+            settings.overflow = TOPIC_OVERFLOW_DROP_NEWEST;
+        }
 
-    /* Data to be sent to the subscriber task queue. */
-    subscriber_data_t subscriber_q_data;
+        entry = topic_registry_add(topic, topic_len, &settings);
+        if (entry == NULL)
+        {
+            return NULL;
+        }
 
-    // Create a null-terminated version of the topic
-    char *null_terminated_topic = malloc(received_topic_len + 1); // +1 for null terminator
-    if (null_terminated_topic == NULL) {
-        printf("Error: Failed to allocate memory for null-terminated topic\n");
-        return;
-    }
-    memcpy(null_terminated_topic, received_topic, received_topic_len); // Copy topic data
-    null_terminated_topic[received_topic_len] = '\0'; // Add null terminator
+        /* Wildcard filters are matched through the trie, not by exact lookup.
+         * A filter the trie cannot hold would never deliver, so it is not
+         * kept in the registry either.
+         */
+        if (topic_filter_is_wildcard(topic, topic_len) && !topic_filter_add(entry))
+        {
+            printf("Error: Failed to add topic filter: %.*s\n", (int) topic_len, topic);
+            topic_registry_remove(entry);
+            return NULL;
+        }
 
-    // Create a null-terminated version of the payload
-    char *null_terminated_payload = malloc(received_msg_len + 1); // +1 for null terminator
-    if (null_terminated_payload == NULL) {
-        printf("Error: Failed to allocate memory for null-terminated payload\n");
-        free(null_terminated_topic); // Clean up previously allocated memory
-        return;
+        printf("Added topic: %.*s to topic list\n", (int) topic_len, topic);
+    }
+    else if (memcmp(&entry->config, config, sizeof(topic_config_t)) != 0)
+    {
+        printf("Topic %.*s already registered, keeping its storage settings\n",
+               (int) topic_len, topic);
     }
-    memcpy(null_terminated_payload, received_msg, received_msg_len); // Copy payload data
-    null_terminated_payload[received_msg_len] = '\0'; // Add null terminator
-    memcpy(null_terminated_payload, received_msg, received_msg_len); // Copy payload data
-    null_terminated_payload[received_msg_len] = '\0'; // Add null terminator
 
-    printf("  \nSubsciber: Incoming MQTT message received:\n"
-           "    Publish topic name: %.*s\n"
-           "    Publish QoS: %d\n"
-           "    Publish payload: %.*s\n",
-           received_msg_info->topic_len, received_msg_info->topic,
-           (int) received_msg_info->qos,
-           (int) received_msg_info->payload_len, (const char *)received_msg_info->payload);
+    if (topic_registry_get_subscriber(entry, task) != NULL)
+    {
+        return entry;
+    }
 
+    if ((entry->config.kind == TOPIC_STORAGE_NOTIFY) && is_notify_bound(task))
+    {
+        printf("Error: Task already consumes a value topic, cannot add: %.*s\n",
+               (int) topic_len, topic);
+        return NULL;
+    }
 
-    // Get the queue for the topic
-	QueueHandle_t queue1 = get_queue_for_topic(null_terminated_topic);
-	if (queue1 == NULL) {
-		add_queue_for_topic(null_terminated_topic);
-		queue1 = get_queue_for_topic(null_terminated_topic);
-	} else {
-	}
-	xQueueSend(queue1, null_terminated_payload, 0);
+    /* Create the storage of the consuming task */
+    if (!create_topic_storage(&entry->config, &subscriber))
+    {
+        printf("Error: Failed to create storage for topic: %.*s\n", (int) topic_len, topic);
+        return NULL;
+    }
 
+    if (topic_registry_attach(entry, &subscriber) == NULL)
+    {
+        printf("Error: Too many subscribers for topic: %.*s\n", (int) topic_len, topic);
+        delete_topic_storage(&entry->config, &subscriber);
+        return NULL;
+    }
 
-    free(null_terminated_payload); // Free payload if send fails
-    free(null_terminated_topic);   // Free topic if send fails
+    return entry;
+}
 
-    /* Assign the command to be sent to the subscriber task. */
-    //subscriber_q_data.cmd = UPDATE_DEVICE_STATE;
+/******************************************************************************
+ * Function Name: is_topic_subscribed
+ ******************************************************************************
+ * Summary:
+ *  Function that checks if the broker already delivers the messages of the
+ *  given topic, either through a subscription to the topic itself or through
+ *  a subscription to a topic filter that matches it.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  cy_mqtt_qos_t *granted_qos : Receives the QoS granted to the subscription
+ *                               that delivers the topic, the highest one if
+ *                               several filters match it
+ *
+ * Return:
+ *  bool : true if the topic is already subscribed, else false
+ *
+ ******************************************************************************/
+static bool is_topic_subscribed(topic_registry_entry_t *entry, cy_mqtt_qos_t *granted_qos)
+{
+    topic_registry_entry_t *matches[SUBSCRIPTION_MAX_MATCHES];
+    size_t match_count;
+    bool subscribed = false;
 
-    /* Assign the device state depending on the received MQTT message. */
+    if (entry->subscribed)
+    {
+        *granted_qos = (cy_mqtt_qos_t) entry->granted_qos;
+        return true;
+    }
 
-	/*if ((strlen(MQTT_DEVICE_ON_MESSAGE) == received_msg_len) &&
-        (strncmp(MQTT_DEVICE_ON_MESSAGE, received_msg, received_msg_len) == 0))
+    if (topic_filter_is_wildcard(entry->topic, entry->topic_len))
     {
-        subscriber_q_data.data = DEVICE_ON_STATE;
+        return false;
     }
-    else if ((strlen(MQTT_DEVICE_OFF_MESSAGE) == received_msg_len) &&
-             (strncmp(MQTT_DEVICE_OFF_MESSAGE, received_msg, received_msg_len) == 0))
+
+    match_count = topic_filter_match(entry->topic, entry->topic_len,
+                                     matches, SUBSCRIPTION_MAX_MATCHES);
+    for (size_t i = 0; i < match_count; i++)
     {
-        subscriber_q_data.data = DEVICE_OFF_STATE;
+        if (matches[i]->subscribed &&
+            (!subscribed || (matches[i]->granted_qos > (uint8_t) *granted_qos)))
+        {
+            *granted_qos = (cy_mqtt_qos_t) matches[i]->granted_qos;
+            subscribed = true;
+        }
     }
-    else
+
+    return subscribed;
+}
+
+/******************************************************************************
+ * Function Name: subscribe_batch_add
+ ******************************************************************************
+ * Summary:
+ *  Function that attaches the requesting task to the given topic and queues
+ *  the topic for the next batched SUBSCRIBE. The requester is answered right
+ *  away if the topic cannot be registered or if the broker already delivers
+ *  it because of an earlier subscription.
+ *
+ * Parameters:
+ *  char *topic : Null-terminated topic name
+ *  TaskHandle_t task : Task that consumes the topic
+ *  const topic_config_t *config : Storage settings of the topic
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void subscribe_batch_add(char* topic, TaskHandle_t task, const topic_config_t *config)
+{
+    topic_registry_entry_t *entry = add_storage_for_topic(topic, strlen(topic), task, config);
+    if (entry == NULL)
     {
-        printf("  Subscriber: Received MQTT message not in valid format!\n");
-        printf("%s idk \n", received_msg);
+        subscribe_notify(task, CY_MQTT_QOS_INVALID);
         return;
-    }*/
-
-    //printf("%s idk \n", received_msg);
+    }
 
-    //print_heap_usage("MQTT subscription callback");
+    cy_mqtt_qos_t granted_qos = CY_MQTT_QOS_INVALID;
+    if (is_topic_subscribed(entry, &granted_qos))
+    {
+        printf("\nMQTT client already subscribed to the topic '%s'.\n", topic);
+        subscribe_notify(task, granted_qos);
+        return;
+    }
 
-    /* Send the command and data to subscriber task queue */
-    //xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+    subscribe_batch[subscribe_batch_count].entry = entry;
+    subscribe_batch[subscribe_batch_count].task = task;
+    subscribe_batch_count++;
 }
 
 /******************************************************************************
- * Function Name: unsubscribe_from_topic
+ * Function Name: subscribe_batch_flush
  ******************************************************************************
  * Summary:
- *  Function that unsubscribes from the topic specified by the macro 
- *  'MQTT_SUB_TOPIC'.
+ *  Function that subscribes to all the topics queued by subscribe_batch_add()
+ *  with a single SUBSCRIBE packet, one topic filter per distinct topic, and
+ *  hands the QoS granted to each filter back to the tasks that requested it.
  *
  * Parameters:
- *  void 
+ *  void
  *
  * Return:
- *  void 
+ *  void
  *
  ******************************************************************************/
-static void unsubscribe_from_topic(void)
+static void subscribe_batch_flush(void)
 {
-    cy_rslt_t result = cy_mqtt_unsubscribe(mqtt_connection, 
-                                           (cy_mqtt_unsubscribe_info_t *) &subscribe_info, 
-                                           SUBSCRIPTION_COUNT);
+    /* Status variable */
+    cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    if (result != CY_RSLT_SUCCESS)
+    /* One topic filter per distinct topic of the batch */
+    cy_mqtt_subscribe_info_t filters[SUBSCRIBE_BATCH_MAX_TOPICS];
+    uint8_t filter_count = 0;
+
+    if (subscribe_batch_count == 0)
     {
-        printf("MQTT Unsubscribe operation failed with error 0x%0X!\n", (int)result);
+        return;
     }
+
+    for (uint8_t i = 0; i < subscribe_batch_count; i++)
+    {
+        topic_registry_entry_t *entry = subscribe_batch[i].entry;
+        uint8_t filter = 0;
+
+        while ((filter < filter_count) && (filters[filter].topic != entry->topic))
+        {
+            filter++;
+        }
+
+        if (filter == filter_count)
+        {
+            filters[filter].qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS;
+            filters[filter].topic = entry->topic;
+            filters[filter].topic_len = entry->topic_len;
+            filters[filter].allocated_qos = CY_MQTT_QOS_INVALID;
+            filter_count++;
+        }
+        subscribe_batch[i].filter = filter;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+
+    result = subscribe_filters(filters, filter_count);
+    if (result == CY_RSLT_SUCCESS)
+    {
+        printf("\nMQTT client subscribed to %u topic filters (%lu ms).\n",
+               filter_count, (unsigned long) pdTICKS_TO_MS(xTaskGetTickCount() - start));
+    }
+
+    for (uint8_t i = 0; i < subscribe_batch_count; i++)
+    {
+        cy_mqtt_qos_t allocated_qos = filters[subscribe_batch[i].filter].allocated_qos;
+
+        if (allocated_qos != CY_MQTT_QOS_INVALID)
+        {
+            subscribe_batch[i].entry->granted_qos = (uint8_t) allocated_qos;
+            subscribe_batch[i].entry->subscribed = true;
+        }
+        subscribe_notify(subscribe_batch[i].task, allocated_qos);
+    }
+
+    subscribe_batch_count = 0;
+}
+
+/******************************************************************************
+ * Function Name: subscribe_filters
+ ******************************************************************************
+ * Summary:
+ *  Function that subscribes to the given topic filters with as few SUBSCRIBE
+ *  packets as the MQTT network buffer allows, normally a single one. Each
+ *  packet is retried a maximum of 'MAX_SUBSCRIBE_RETRIES' times with
+ *  interval of 'MQTT_SUBSCRIBE_RETRY_INTERVAL_MS' milliseconds. The MQTT
+ *  client task is notified if a packet still fails.
+ *
+ * Parameters:
+ *  cy_mqtt_subscribe_info_t *filters : Topic filters; 'allocated_qos' must be
+ *                                      CY_MQTT_QOS_INVALID on entry and holds
+ *                                      the per-filter SUBACK result on return
+ *  size_t filter_count : Number of topic filters
+ *
+ * Return:
+ *  cy_rslt_t : CY_RSLT_SUCCESS if every SUBSCRIBE was acknowledged, else the
+ *              error code of the failed SUBSCRIBE
+ *
+ ******************************************************************************/
+static cy_rslt_t subscribe_filters(cy_mqtt_subscribe_info_t *filters, size_t filter_count)
+{
+    /* Status variable */
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    /* Command to the MQTT client task */
+    mqtt_task_cmd_t mqtt_task_cmd;
+
+    size_t first = 0;
+
+    while ((first < filter_count) && (result == CY_RSLT_SUCCESS))
+    {
+        /* Fill the SUBSCRIBE up to what the network buffer can encode. */
+        size_t packet_size = SUBSCRIBE_PACKET_OVERHEAD;
+        size_t count = 0;
+        while ((first + count < filter_count) &&
+               ((count == 0) || (packet_size + SUBSCRIBE_FILTER_OVERHEAD +
+                                 filters[first + count].topic_len <= MQTT_NETWORK_BUFFER_SIZE)))
+        {
+            packet_size += SUBSCRIBE_FILTER_OVERHEAD + filters[first + count].topic_len;
+            count++;
+        }
+
+        /* Subscribe with the configured parameters. */
+        for (uint32_t retry_count = 0; retry_count < MAX_SUBSCRIBE_RETRIES; retry_count++)
+        {
+            result = cy_mqtt_subscribe(mqtt_connection, &filters[first], count);
+            if (result == CY_RSLT_SUCCESS)
+            {
+                break;
+            }
+
+            vTaskDelay(pdMS_TO_TICKS(MQTT_SUBSCRIBE_RETRY_INTERVAL_MS));
+        }
+
+        if (result != CY_RSLT_SUCCESS)
+        {
+            /* Report the unacknowledged filters as rejected */
+            for (size_t filter = first; filter < filter_count; filter++)
+            {
+                filters[filter].allocated_qos = CY_MQTT_QOS_INVALID;
+            }
+            break;
+        }
+
+        first += count;
+    }
+
+    for (size_t filter = 0; filter < filter_count; filter++)
+    {
+        printf("  '%.*s': %s\n", filters[filter].topic_len, filters[filter].topic,
+               (filters[filter].allocated_qos == CY_MQTT_QOS_INVALID) ? "rejected" : "granted");
+    }
+
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("\nMQTT Subscribe failed with error 0x%0X after %d retries...\n\n",
+               (int)result, MAX_SUBSCRIBE_RETRIES);
+
+        /* Notify the MQTT client task about the subscription failure */
+        mqtt_task_cmd = HANDLE_MQTT_SUBSCRIBE_FAILURE;
+        xQueueSend(mqtt_task_q, &mqtt_task_cmd, portMAX_DELAY);
+    }
+
+    return result;
+}
+
+/******************************************************************************
+ * Function Name: is_topic_covered
+ ******************************************************************************
+ * Summary:
+ *  Function that checks if a wildcard topic filter of the registry, consumed
+ *  by at least one task, matches the given topic. Such a topic is delivered
+ *  through the filter and is not subscribed on its own.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *
+ * Return:
+ *  bool : true if a consumed wildcard filter matches the topic, else false
+ *
+ ******************************************************************************/
+static bool is_topic_covered(topic_registry_entry_t *entry)
+{
+    topic_registry_entry_t *matches[SUBSCRIPTION_MAX_MATCHES];
+    size_t match_count;
+
+    if (topic_filter_is_wildcard(entry->topic, entry->topic_len))
+    {
+        return false;
+    }
+
+    match_count = topic_filter_match(entry->topic, entry->topic_len,
+                                     matches, SUBSCRIPTION_MAX_MATCHES);
+    for (size_t i = 0; i < match_count; i++)
+    {
+        if (matches[i]->subscriber_count > 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: resubscribe_topics
+ ******************************************************************************
+ * Summary:
+ *  Function that subscribes again, in as few SUBSCRIBE packets as possible,
+ *  to every topic of the registry that has a consuming task and is not yet
+ *  delivered by the broker. The 'subscribed' flag of each topic is set from
+ *  the SUBACK.
+ *
+ * Parameters:
+ *  bool covered : false to subscribe the topics that no consumed wildcard
+ *                 filter matches, true to subscribe the matched ones
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void resubscribe_topics(bool covered)
+{
+    /* Kept off the stack, the registry may hold many more topics than a
+     * startup batch.
+     */
+    static cy_mqtt_subscribe_info_t filters[TOPIC_REGISTRY_MAX_TOPICS];
+    static topic_registry_entry_t *entries[TOPIC_REGISTRY_MAX_TOPICS];
+    cy_mqtt_qos_t granted_qos = CY_MQTT_QOS_INVALID;
+    size_t filter_count = 0;
+
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
+    {
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if ((entry == NULL) || (entry->subscriber_count == 0) ||
+            (is_topic_covered(entry) != covered) || is_topic_subscribed(entry, &granted_qos))
+        {
+            continue;
+        }
+
+        entries[filter_count] = entry;
+        filters[filter_count].qos = (cy_mqtt_qos_t) MQTT_MESSAGES_QOS;
+        filters[filter_count].topic = entry->topic;
+        filters[filter_count].topic_len = entry->topic_len;
+        filters[filter_count].allocated_qos = CY_MQTT_QOS_INVALID;
+        filter_count++;
+    }
+
+    if (filter_count == 0)
+    {
+        return;
+    }
+
+    subscribe_filters(filters, filter_count);
+
+    for (size_t filter = 0; filter < filter_count; filter++)
+    {
+        if (filters[filter].allocated_qos != CY_MQTT_QOS_INVALID)
+        {
+            entries[filter]->granted_qos = (uint8_t) filters[filter].allocated_qos;
+            entries[filter]->subscribed = true;
+        }
+    }
+}
+
+/******************************************************************************
+ * Function Name: resubscribe_all_topics
+ ******************************************************************************
+ * Summary:
+ *  Function that restores the subscriptions of the topic registry after a
+ *  reconnection to the MQTT broker. Every topic with a consuming task is
+ *  subscribed again in one batch, including the topics whose earlier
+ *  SUBSCRIBE failed, and the time taken since the disconnection is reported.
+ *  A topic matched by a wildcard filter of the registry is only subscribed
+ *  on its own if the broker rejects every such filter. With
+ *  MQTT_PERSISTENT_SESSION, the subscriptions are only sent again if the
+ *  session probe shows that the broker did not keep the session.
+ *
+ * Parameters:
+ *  TickType_t disconnect_tick : Tick count when the disconnection was handled
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void resubscribe_all_topics(TickType_t disconnect_tick)
+{
+    cy_mqtt_qos_t granted_qos = CY_MQTT_QOS_INVALID;
+    size_t topic_count = 0;
+    size_t restored = 0;
+
+#if MQTT_PERSISTENT_SESSION
+    if (session_probe())
+    {
+        printf("\nMQTT broker kept the session, subscriptions still in place %lu ms after the disconnection.\n",
+               (unsigned long) pdTICKS_TO_MS(xTaskGetTickCount() - disconnect_tick));
+        return;
+    }
+
+    printf("\nMQTT broker lost the session, subscribing again.\n");
+    session_probe_subscribe();
+#endif /* MQTT_PERSISTENT_SESSION */
+
+    /* Without a session on the broker, no topic is delivered any more. */
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
+    {
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if (entry != NULL)
+        {
+            entry->subscribed = false;
+        }
+    }
+
+    resubscribe_topics(false);
+    resubscribe_topics(true);
+
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
+    {
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if ((entry == NULL) || (entry->subscriber_count == 0))
+        {
+            continue;
+        }
+
+        topic_count++;
+        if (is_topic_subscribed(entry, &granted_qos))
+        {
+            restored++;
+        }
+    }
+
+    if (topic_count == 0)
+    {
+        return;
+    }
+
+    printf("\nMQTT client restored %u of %u topics, %lu ms after the disconnection.\n",
+           (unsigned) restored, (unsigned) topic_count,
+           (unsigned long) pdTICKS_TO_MS(xTaskGetTickCount() - disconnect_tick));
+}
+
+#if MQTT_PERSISTENT_SESSION
+/******************************************************************************
+ * Function Name: session_probe_subscribe
+ ******************************************************************************
+ * Summary:
+ *  Function that subscribes to the session probe topic of this client,
+ *  '<client identifier>/session'. The topic is not part of the topic
+ *  registry, mqtt_subscription_callback() handles it.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void session_probe_subscribe(void)
+{
+    cy_mqtt_subscribe_info_t filter;
+    int written = snprintf(session_probe_topic, sizeof(session_probe_topic), "%.*s/session",
+                           (int) connection_info.client_id_len, connection_info.client_id);
+
+    if ((written <= 0) || ((size_t) written >= sizeof(session_probe_topic)))
+    {
+        session_probe_topic_len = 0;
+        return;
+    }
+    session_probe_topic_len = (uint16_t) written;
+
+    filter.qos = CY_MQTT_QOS1;
+    filter.topic = session_probe_topic;
+    filter.topic_len = session_probe_topic_len;
+    filter.allocated_qos = CY_MQTT_QOS_INVALID;
+    subscribe_filters(&filter, 1);
+}
+
+/******************************************************************************
+ * Function Name: session_probe
+ ******************************************************************************
+ * Summary:
+ *  Function that tells whether the broker kept the session of this client
+ *  across the last disconnection. The MQTT library does not report the
+ *  session present flag of the CONNACK, so a QoS 1 probe is published to the
+ *  session probe topic: it only comes back if the broker still holds the
+ *  subscription made before the disconnection.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  bool : true if the probe came back within MQTT_SESSION_PROBE_TIMEOUT_MS
+ *
+ ******************************************************************************/
+static bool session_probe(void)
+{
+    cy_mqtt_publish_info_t probe_info =
+    {
+        .qos = CY_MQTT_QOS1,
+        .topic = session_probe_topic,
+        .topic_len = session_probe_topic_len,
+        .payload = "probe",
+        .payload_len = sizeof("probe") - 1,
+        .retain = false,
+        .dup = false
+    };
+
+    if (session_probe_topic_len == 0)
+    {
+        return false;
+    }
+
+    /* Forget a probe that came back late from an earlier check. */
+    ulTaskNotifyTakeIndexed(SESSION_PROBE_NOTIFY_INDEX, pdTRUE, 0);
+
+    if (cy_mqtt_publish(mqtt_connection, &probe_info) != CY_RSLT_SUCCESS)
+    {
+        return false;
+    }
+
+    return (ulTaskNotifyTakeIndexed(SESSION_PROBE_NOTIFY_INDEX, pdTRUE,
+                                    pdMS_TO_TICKS(MQTT_SESSION_PROBE_TIMEOUT_MS)) > 0);
+}
+#endif /* MQTT_PERSISTENT_SESSION */
+
+/******************************************************************************
+ * Function Name: subscribe_notify
+ ******************************************************************************
+ * Summary:
+ *  Function that answers a task waiting in subscribe_request().
+ *
+ * Parameters:
+ *  TaskHandle_t task : Requesting task
+ *  cy_mqtt_qos_t allocated_qos : QoS granted by the broker, or
+ *                                CY_MQTT_QOS_INVALID if the topic is not
+ *                                subscribed
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void subscribe_notify(TaskHandle_t task, cy_mqtt_qos_t allocated_qos)
+{
+    xTaskNotifyIndexed(task, SUBSCRIBE_NOTIFY_INDEX, (uint32_t) allocated_qos,
+                       eSetValueWithOverwrite);
+}
+
+/******************************************************************************
+ * Function Name: subscribe_request
+ ******************************************************************************
+ * Summary:
+ *  Function that asks the subscriber task to subscribe the calling task to
+ *  the given topic, and waits for the result. Requests that arrive close
+ *  together are sent to the broker in one SUBSCRIBE packet.
+ *
+ * Parameters:
+ *  char *topic : Null-terminated topic name, must stay valid until the call
+ *                returns
+ *  const topic_config_t *config : Storage settings of the topic
+ *
+ * Return:
+ *  cy_mqtt_qos_t : QoS granted by the broker, CY_MQTT_QOS_INVALID if the
+ *                  subscription failed or was rejected
+ *
+ ******************************************************************************/
+cy_mqtt_qos_t subscribe_request(char *topic, const topic_config_t *config)
+{
+    subscriber_data_t subscriber_q_data;
+    uint32_t allocated_qos = CY_MQTT_QOS_INVALID;
+
+    subscriber_q_data.cmd = SUBSCRIBE_TO_TOPIC;
+    subscriber_q_data.topic = topic;
+    subscriber_q_data.task = xTaskGetCurrentTaskHandle();
+    subscriber_q_data.config = *config;
+
+    xTaskNotifyStateClearIndexed(NULL, SUBSCRIBE_NOTIFY_INDEX);
+    xQueueSend(subscriber_task_q, &subscriber_q_data, portMAX_DELAY);
+    xTaskNotifyWaitIndexed(SUBSCRIBE_NOTIFY_INDEX, 0, UINT32_MAX, &allocated_qos, portMAX_DELAY);
+
+    return (cy_mqtt_qos_t) allocated_qos;
+}
+
+/******************************************************************************
+ * Function Name: copy_message_to_pool
+ ******************************************************************************
+ * Summary:
+ *  Function that copies an inbound message into a block of the message pool.
+ *  The block is returned with one reference held by the caller.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  int topic_len : Length of the topic name, at most TOPIC_MAX_LENGTH
+ *  const char *payload : Payload
+ *  int payload_len : Length of the payload, at most MESSAGE_POOL_PAYLOAD_SIZE
+ *
+ * Return:
+ *  subscriber_msg_t * : Message, NULL if the message pool is exhausted
+ *
+ ******************************************************************************/
+static subscriber_msg_t *copy_message_to_pool(const char *topic, int topic_len,
+                                              const char *payload, int payload_len)
+{
+    subscriber_msg_t *msg = message_pool_alloc();
+    if (msg == NULL)
+    {
+        message_pool_stats_t stats;
+        message_pool_get_stats(&stats);
+        LOG_ERR("Message pool exhausted, message dropped (%lu times)",
+                (unsigned long) stats.exhausted);
+        return NULL;
+    }
+
+    msg->topic_len = (uint16_t) topic_len;
+    msg->payload_len = (uint16_t) payload_len;
+    memcpy(msg->topic, topic, topic_len);
+    msg->topic[topic_len] = '\0';
+    memcpy(msg->payload, payload, payload_len);
+    msg->payload[payload_len] = '\0';
+
+    return msg;
+}
+
+/******************************************************************************
+ * Function Name: deliver_to_queue
+ ******************************************************************************
+ * Summary:
+ *  Function that hands a reference to a pooled message to the queue of a
+ *  subscriber, applying the overflow policy of the topic when the queue is
+ *  full. Only called from the MQTT callback, which is the single writer of
+ *  the topic counters.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  const topic_subscriber_t *subscriber : Subscriber to deliver to
+ *  subscriber_msg_t *msg : Message, a reference is taken for the queue
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void deliver_to_queue(topic_registry_entry_t *entry,
+                             const topic_subscriber_t *subscriber,
+                             subscriber_msg_t *msg)
+{
+    subscriber_msg_t *pending;
+
+    if (entry->config.overflow == TOPIC_OVERFLOW_OVERWRITE_LATEST)
+    {
+        /* Only the latest message is kept */
+        while (xQueueReceive(subscriber->queue, &pending, 0) == pdTRUE)
+        {
+            subscriber_msg_release(pending);
+            entry->overwritten++;
+        }
+    }
+
+    message_pool_retain(msg);
+    if (xQueueSend(subscriber->queue, &msg, 0) == pdTRUE)
+    {
+        return;
+    }
+
+    if ((entry->config.overflow == TOPIC_OVERFLOW_DROP_OLDEST) &&
+        (xQueueReceive(subscriber->queue, &pending, 0) == pdTRUE))
+    {
+        subscriber_msg_release(pending);
+        entry->dropped++;
+        if (xQueueSend(subscriber->queue, &msg, 0) == pdTRUE)
+        {
+            return;
+        }
+    }
+
+    subscriber_msg_release(msg);
+    entry->dropped++;
+}
+
+/******************************************************************************
+ * Function Name: deliver_to_mailbox
+ ******************************************************************************
+ * Summary:
+ *  Function that writes a message to the mailbox of a subscriber. A full
+ *  mailbox keeps its message under TOPIC_OVERFLOW_DROP_NEWEST, and is
+ *  overwritten under the other policies.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  const topic_subscriber_t *subscriber : Subscriber to deliver to
+ *  const topic_mailbox_item_t *item : Message
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void deliver_to_mailbox(topic_registry_entry_t *entry,
+                               const topic_subscriber_t *subscriber,
+                               const topic_mailbox_item_t *item)
+{
+    if (entry->config.overflow == TOPIC_OVERFLOW_DROP_NEWEST)
+    {
+        if (xQueueSend(subscriber->queue, item, 0) != pdTRUE)
+        {
+            entry->dropped++;
+        }
+        return;
+    }
+
+    if (uxQueueMessagesWaiting(subscriber->queue) != 0)
+    {
+        entry->overwritten++;
+    }
+    xQueueOverwrite(subscriber->queue, item);
+}
+
+/******************************************************************************
+ * Function Name: deliver_to_message_buffer
+ ******************************************************************************
+ * Summary:
+ *  Function that writes a copy of a payload to the message buffer of a
+ *  subscriber. Under TOPIC_OVERFLOW_OVERWRITE_LATEST the pending messages
+ *  are discarded first; a message buffer has a single reader, so the
+ *  TOPIC_OVERFLOW_DROP_OLDEST policy is not accepted for it at registration.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  const topic_subscriber_t *subscriber : Subscriber to deliver to
+ *  const char *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void deliver_to_message_buffer(topic_registry_entry_t *entry,
+                                      const topic_subscriber_t *subscriber,
+                                      const char *payload, size_t payload_len)
+{
+    if ((entry->config.overflow == TOPIC_OVERFLOW_OVERWRITE_LATEST) &&
+        (xMessageBufferIsEmpty(subscriber->message_buffer) == pdFALSE))
+    {
+        /* A reset only fails while the consumer is blocked, i.e. when empty */
+        if (xMessageBufferReset(subscriber->message_buffer) == pdPASS)
+        {
+            entry->overwritten++;
+        }
+    }
+
+    if (xMessageBufferSend(subscriber->message_buffer, payload, payload_len, 0) == 0)
+    {
+        entry->dropped++;
+    }
+}
+
+/******************************************************************************
+ * Function Name: decode_value
+ ******************************************************************************
+ * Summary:
+ *  Function that decodes a small numeric or boolean payload: an unsigned
+ *  32-bit decimal number, "true"/"on" (1) or "false"/"off" (0).
+ *
+ * Parameters:
+ *  const char *payload : Payload (need not be null-terminated)
+ *  size_t payload_len : Length of the payload
+ *  uint32_t *value : Receives the decoded value
+ *
+ * Return:
+ *  bool : true if the payload was decoded, else false
+ *
+ ******************************************************************************/
+static bool decode_value(const char *payload, size_t payload_len, uint32_t *value)
+{
+    uint32_t decoded = 0;
+
+    if (((payload_len == 4) && (memcmp(payload, "true", 4) == 0)) ||
+        ((payload_len == 2) && (memcmp(payload, "on", 2) == 0)))
+    {
+        *value = 1;
+        return true;
+    }
+
+    if (((payload_len == 5) && (memcmp(payload, "false", 5) == 0)) ||
+        ((payload_len == 3) && (memcmp(payload, "off", 3) == 0)))
+    {
+        *value = 0;
+        return true;
+    }
+
+    if ((payload_len == 0) || (payload_len > TOPIC_VALUE_MAX_LENGTH))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < payload_len; i++)
+    {
+        uint32_t digit = (uint32_t) (payload[i] - '0');
+        if ((digit > 9u) || (decoded > (UINT32_MAX - digit) / 10u))
+        {
+            return false;
+        }
+        decoded = (decoded * 10u) + digit;
+    }
+
+    *value = decoded;
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: deliver_to_task
+ ******************************************************************************
+ * Summary:
+ *  Function that decodes a payload and delivers it as the notification value
+ *  of the subscriber task on TOPIC_NOTIFY_INDEX. A value that has not been
+ *  consumed yet is kept under TOPIC_OVERFLOW_DROP_NEWEST, and is overwritten
+ *  under the other policies. Payloads that do not decode are dropped.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  const topic_subscriber_t *subscriber : Subscriber to deliver to
+ *  const char *payload : Payload
+ *  size_t payload_len : Length of the payload
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void deliver_to_task(topic_registry_entry_t *entry,
+                            const topic_subscriber_t *subscriber,
+                            const char *payload, size_t payload_len)
+{
+    uint32_t value;
+
+    if (!decode_value(payload, payload_len, &value))
+    {
+        LOG_WRN("Payload of %s is not a value", entry->topic);
+        entry->dropped++;
+        return;
+    }
+
+    if (xTaskNotifyIndexed(subscriber->task, TOPIC_NOTIFY_INDEX, value,
+                           eSetValueWithoutOverwrite) == pdPASS)
+    {
+        return;
+    }
+
+    if (entry->config.overflow == TOPIC_OVERFLOW_DROP_NEWEST)
+    {
+        entry->dropped++;
+    }
+    else
+    {
+        xTaskNotifyIndexed(subscriber->task, TOPIC_NOTIFY_INDEX, value,
+                           eSetValueWithOverwrite);
+        entry->overwritten++;
+    }
+}
+
+/******************************************************************************
+ * Function Name: mqtt_subscription_callback
+ ******************************************************************************
+ * Summary:
+ *  Callback to handle incoming MQTT messages. This callback logs the 
+ *  contents of the incoming message and hands it to the storage of every 
+ *  task subscribed to the topic or to a topic filter matching it. Queues 
+ *  share one reference counted copy, message buffers and mailboxes receive 
+ *  a copy of the payload truncated to the maximum payload of the topic. A 
+ *  full storage is handled according to the overflow policy of the topic.
+ *
+ * Parameters:
+ *  cy_mqtt_publish_info_t *received_msg_info : Information structure of the 
+ *                                              received MQTT message
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info)
+{
+    /* Extract the topic and message from the received MQTT message */
+    const char *received_msg = received_msg_info->payload;
+    int received_msg_len = received_msg_info->payload_len;
+    const char *received_topic = received_msg_info->topic;
+    int received_topic_len = received_msg_info->topic_len;
+
+    /* Size of the PUBLISH packet in the network buffer: fixed header, topic,
+     * packet identifier and payload.
+     */
+    uint32_t remaining_len = 2u + (uint32_t) received_topic_len + (uint32_t) received_msg_len +
+                             ((received_msg_info->qos != CY_MQTT_QOS0) ? 2u : 0u);
+    uint32_t packet_len = 2u + remaining_len + ((remaining_len > 127u) ? 1u : 0u) +
+                          ((remaining_len > 16383u) ? 1u : 0u);
+    if (packet_len > rx_peak_bytes)
+    {
+        rx_peak_bytes = packet_len;
+    }
+
+#if MQTT_PERSISTENT_SESSION
+    if ((session_probe_topic_len != 0) && (received_topic_len == session_probe_topic_len) &&
+        (memcmp(received_topic, session_probe_topic, session_probe_topic_len) == 0))
+    {
+        xTaskNotifyGiveIndexed(subscriber_task_handle, SESSION_PROBE_NOTIFY_INDEX);
+        return;
+    }
+#endif /* MQTT_PERSISTENT_SESSION */
+
+    TRACE(TRACE_SUBSCRIBE_RECEIVED, (uint32_t) received_msg_len, (uint32_t) received_msg_info->qos,
+          received_topic_len, received_topic);
+    LOG_INF("Incoming MQTT message on '%.*s' (QoS %d): %.*s",
+            received_msg_info->topic_len, received_msg_info->topic,
+            (int) received_msg_info->qos,
+            (int) received_msg_info->payload_len, (const char *)received_msg_info->payload);
+
+
+    /* Find the exact topic and every matching filter */
+    topic_registry_entry_t *matches[SUBSCRIPTION_MAX_MATCHES];
+    size_t match_count = 0;
+    size_t subscriber_count = 0;
+    topic_registry_entry_t *entry = topic_registry_find(received_topic, received_topic_len);
+    if (entry != NULL)
+    {
+        matches[match_count++] = entry;
+    }
+    match_count += topic_filter_match(received_topic, received_topic_len,
+                                      &matches[match_count],
+                                      SUBSCRIPTION_MAX_MATCHES - match_count);
+    bool stored = false;
+    for (size_t i = 0; i < match_count; i++)
+    {
+        subscriber_count += matches[i]->subscriber_count;
+        stored |= (matches[i]->config.kind != TOPIC_STORAGE_CALLBACK);
+    }
+
+    if ((subscriber_count == 0) || (received_topic_len > TOPIC_MAX_LENGTH))
+    {
+        LOG_WRN("No subscriber for topic %.*s", received_topic_len, received_topic);
+        TRACE(TRACE_SUBSCRIBE_DROPPED, received_topic_len, received_topic);
+        return;
+    }
+
+    /* Handlers of callback topics and value topics get the whole payload */
+    size_t full_msg_len = (size_t) received_msg_len;
+    if (received_msg_len > MESSAGE_POOL_PAYLOAD_SIZE)
+    {
+        if (stored)
+        {
+            LOG_WRN("Payload truncated to %u bytes", MESSAGE_POOL_PAYLOAD_SIZE);
+        }
+        received_msg_len = MESSAGE_POOL_PAYLOAD_SIZE;
+    }
+
+    /* Hand the message to the storage of every subscriber. Queues share a
+     * single copy in a message pool block, taken when first needed.
+     */
+    subscriber_msg_t *msg = NULL;
+    topic_mailbox_item_t item;
+    for (size_t i = 0; i < match_count; i++)
+    {
+        const topic_config_t *config = &matches[i]->config;
+        size_t payload_len = ((size_t) received_msg_len < config->max_payload) ?
+                             (size_t) received_msg_len : config->max_payload;
+
+        for (uint8_t j = 0; j < matches[i]->subscriber_count; j++)
+        {
+            const topic_subscriber_t *subscriber = &matches[i]->subscribers[j];
+
+            switch (config->kind)
+            {
+                case TOPIC_STORAGE_MESSAGE_BUFFER:
+                    deliver_to_message_buffer(matches[i], subscriber, received_msg, payload_len);
+                    break;
+
+                case TOPIC_STORAGE_NOTIFY:
+                    /* Decoded from the full payload, a truncated number would be wrong */
+                    deliver_to_task(matches[i], subscriber, received_msg, full_msg_len);
+                    break;
+
+                case TOPIC_STORAGE_MAILBOX:
+                    item.payload_len = (uint16_t) payload_len;
+                    memcpy(item.payload, received_msg, payload_len);
+                    deliver_to_mailbox(matches[i], subscriber, &item);
+                    break;
+
+                case TOPIC_STORAGE_CALLBACK:
+                    /* One handler per topic, whatever the number of subscribers */
+                    if (j == 0)
+                    {
+                        config->callback(received_topic, (size_t) received_topic_len,
+                                         received_msg, full_msg_len);
+                    }
+                    break;
+
+                case TOPIC_STORAGE_QUEUE:
+                default:
+                    if (msg == NULL)
+                    {
+                        msg = copy_message_to_pool(received_topic, received_topic_len,
+                                                   received_msg, received_msg_len);
+                    }
+                    if (msg == NULL)
+                    {
+                        matches[i]->dropped++;
+                        break;
+                    }
+                    deliver_to_queue(matches[i], subscriber, msg);
+                    break;
+            }
+        }
+    }
+
+    /* Drop the reference held by this callback */
+    if (msg != NULL)
+    {
+        subscriber_msg_release(msg);
+    }
+}
+
+/******************************************************************************
+ * Function Name: subscriber_msg_release
+ ******************************************************************************
+ * Summary:
+ *  Drops a reference to a received message. The message block returns to the
+ *  message pool when the last subscriber releases it.
+ *
+ * Parameters:
+ *  subscriber_msg_t *msg : Received message
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void subscriber_msg_release(subscriber_msg_t *msg)
+{
+    message_pool_release(msg);
+}
+
+/******************************************************************************
+ * Function Name: unsubscribe_from_topic
+ ******************************************************************************
+ * Summary:
+ *  Function that unsubscribes from the topic specified by the macro 
+ *  'MQTT_SUB_TOPIC'.
+ *
+ * Parameters:
+ *  void 
+ *
+ * Return:
+ *  void 
+ *
+ ******************************************************************************/
+static void unsubscribe_from_topic(void)
+{
+    cy_rslt_t result = cy_mqtt_unsubscribe(mqtt_connection, 
+                                           (cy_mqtt_unsubscribe_info_t *) &subscribe_info, 
+                                           SUBSCRIPTION_COUNT);
+
+    if (result != CY_RSLT_SUCCESS)
+    {
+        printf("MQTT Unsubscribe operation failed with error 0x%0X!\n", (int)result);
+    }
+}
+
+/******************************************************************************
+ * Function Name: publish_topic_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the drop and overwrite counters of every topic whose counters
+ *  changed since the previous report on MQTT_DIAGNOSTICS_TOPIC, as a JSON
+ *  object keyed by topic name. Topics that do not fit in the payload are
+ *  reported at the next interval.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_topic_diagnostics(void)
+{
+    /* Counter totals at the previous report, per registry slot. */
+    static uint32_t reported[TOPIC_REGISTRY_SLOTS];
+
+    char payload[TOPIC_DIAGNOSTICS_PAYLOAD_SIZE];
+    size_t len = 0;
+
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
+    {
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        uint32_t dropped = entry->dropped;
+        uint32_t overwritten = entry->overwritten;
+        if (dropped + overwritten == reported[slot])
+        {
+            continue;
+        }
+
+        int written = snprintf(&payload[len], sizeof(payload) - len,
+                               "%c\"%s\":{\"dropped\":%lu,\"overwritten\":%lu}",
+                               (len == 0) ? '{' : ',', entry->topic,
+                               (unsigned long) dropped, (unsigned long) overwritten);
+        /* Keep room for the closing brace */
+        if ((written < 0) || (len + written + 2 > sizeof(payload)))
+        {
+            break;
+        }
+
+        len += written;
+        reported[slot] = dropped + overwritten;
+    }
+
+    if (len == 0)
+    {
+        return;
+    }
+
+    payload[len++] = '}';
+    payload[len] = '\0';
+    PublishMessage(payload, MQTT_DIAGNOSTICS_TOPIC);
+}
+
+/******************************************************************************
+ * Function Name: publish_buffer_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the size and peak use of the RX buffer (largest PUBLISH packet
+ *  received) and of the TX buffer (longest payload published) on
+ *  MQTT_BUFFER_DIAGNOSTICS_TOPIC, when a peak changed since the previous
+ *  report.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void publish_buffer_diagnostics(void)
+{
+    /* Peaks at the previous report. */
+    static uint32_t reported_rx = 0;
+    static size_t reported_tx = 0;
+
+    char payload[TOPIC_DIAGNOSTICS_PAYLOAD_SIZE];
+    uint32_t rx_peak = rx_peak_bytes;
+    size_t tx_peak = publisher_tx_peak();
+
+    if ((rx_peak == reported_rx) && (tx_peak == reported_tx))
+    {
+        return;
+    }
+
+    int written = snprintf(payload, sizeof(payload),
+                           "{\"rx_size\":%u,\"rx_peak\":%lu,\"tx_size\":%u,\"tx_peak\":%u}",
+                           (unsigned) MQTT_RX_BUFFER_SIZE, (unsigned long) rx_peak,
+                           (unsigned) PUBLISH_PAYLOAD_SIZE, (unsigned) tx_peak);
+    if ((written > 0) && ((size_t) written < sizeof(payload)))
+    {
+        reported_rx = rx_peak;
+        reported_tx = tx_peak;
+        PublishMessage(payload, MQTT_BUFFER_DIAGNOSTICS_TOPIC);
+    }
+}
+
+/******************************************************************************
+ * Function Name: print_topic_budget
+ ******************************************************************************
+ * Summary:
+ *  Prints the RAM reserved by the topic registry: the storage of every
+ *  consuming task of every registered topic, and the message pool shared by
+ *  the queues. Sizes are those requested from the FreeRTOS heap, without
+ *  allocator overhead.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void print_topic_budget(void)
+{
+    static const char * const kind_names[] = { "queue", "msgbuf", "mailbox", "notify", "callback" };
+    static const char * const overflow_names[] = { "newest", "oldest", "latest" };
+    size_t storage_total = 0;
+    size_t topic_total = 0;
+    message_pool_stats_t stats;
+
+    printf("\n********** Topic RAM Budget **********\n");
+    printf("%-24s %-8s %-8s %5s %7s %4s %6s\n", "Topic", "Kind", "Overflow", "Depth", "Payload",
+           "Subs", "Bytes");
+
+    for (size_t slot = 0; slot < TOPIC_REGISTRY_SLOTS; slot++)
+    {
+        topic_registry_entry_t *entry = topic_registry_at(slot);
+        if (entry == NULL)
+        {
+            continue;
+        }
+
+        size_t bytes = entry->subscriber_count * topic_storage_size(&entry->config);
+        printf("%-24.24s %-8s %-8s %5u %7u %4u %6u\n", entry->topic,
+               kind_names[entry->config.kind], overflow_names[entry->config.overflow],
+               (unsigned) ((entry->config.kind == TOPIC_STORAGE_MAILBOX) ? 1u : entry->config.depth),
+               (unsigned) entry->config.max_payload,
+               (unsigned) entry->subscriber_count, (unsigned) bytes);
+
+        storage_total += bytes;
+        topic_total += entry->topic_len + 1u;
+    }
+
+    message_pool_get_stats(&stats);
+    printf("Topic storage   : %u bytes\n", (unsigned) storage_total);
+    printf("Topic names     : %u bytes\n", (unsigned) topic_total);
+    printf("Message pool    : %u bytes (static, %u blocks, high water %lu)\n",
+           (unsigned) (MESSAGE_POOL_BLOCKS * sizeof(message_block_t)),
+           (unsigned) MESSAGE_POOL_BLOCKS, (unsigned long) stats.high_water);
+    printf("Heap reserved   : %u of %u bytes\n", (unsigned) (storage_total + topic_total),
+           (unsigned) configTOTAL_HEAP_SIZE);
+    printf("**************************************\n\n");
 }
 
 /* [] END OF FILE */
@@ -47,6 +47,9 @@
 #include "queue.h"
 #include "cy_mqtt_api.h"
 
+#include "topic_registry.h"
+#include "message_pool.h"
+
 /*******************************************************************************
 * Macros
 ********************************************************************************/
@@ -54,10 +57,52 @@
 #define SUBSCRIBER_TASK_PRIORITY           (2)
 #define SUBSCRIBER_TASK_STACK_SIZE         (1024 * 1)
 
+/* Task notification index on which subscribe_request() waits for the result
+ * of its subscription. Index 0 is left to the application.
+ */
+#define SUBSCRIBE_NOTIFY_INDEX             (1u)
+
+/* Task notification index on which topics with TOPIC_STORAGE_NOTIFY storage
+ * deliver their decoded value. A task can consume one such topic.
+ */
+#define TOPIC_NOTIFY_INDEX                 (2u)
+
+/* Task notification index on which the subscriber task waits for its session
+ * probe, see MQTT_PERSISTENT_SESSION.
+ */
+#define SESSION_PROBE_NOTIFY_INDEX         (3u)
+
 /* 8-bit value denoting the device (LED) state. */
 #define DEVICE_ON_STATE                    (0x00u)
 #define DEVICE_OFF_STATE                   (0x01u)
 
+/* Default storage settings of a topic: a queue of shared message pool blocks
+ * that drops new messages while full.
+ */
+#define TOPIC_CONFIG_DEFAULT               { TOPIC_STORAGE_QUEUE, TOPIC_OVERFLOW_DROP_NEWEST, \
+                                             10u, MESSAGE_POOL_PAYLOAD_SIZE }
+
+/* Storage settings of an actuator topic where only the latest one-byte
+ * command matters.
+ */
+#define TOPIC_CONFIG_COMMAND               { TOPIC_STORAGE_MAILBOX, TOPIC_OVERFLOW_OVERWRITE_LATEST, \
+                                             1u, 1u }
+
+/* Longest payload decoded for TOPIC_STORAGE_NOTIFY: a 32-bit decimal value. */
+#define TOPIC_VALUE_MAX_LENGTH             (10u)
+
+/* Storage settings of an actuator topic carrying a small numeric or boolean
+ * value, delivered as a task notification value. Only the latest value is
+ * kept.
+ */
+#define TOPIC_CONFIG_VALUE                 { TOPIC_STORAGE_NOTIFY, TOPIC_OVERFLOW_OVERWRITE_LATEST, \
+                                             1u, TOPIC_VALUE_MAX_LENGTH }
+
+/* Interval in milliseconds at which changed topic drop and overwrite counters
+ * are published on MQTT_DIAGNOSTICS_TOPIC.
+ */
+#define TOPIC_DIAGNOSTICS_INTERVAL_MS      (10000u)
+
 /*******************************************************************************
 * Global Variables
 ********************************************************************************/
@@ -65,6 +110,7 @@
 typedef enum
 {
     SUBSCRIBE_TO_TOPIC,
+    RESUBSCRIBE_ALL_TOPICS,
     UNSUBSCRIBE_FROM_TOPIC,
     UPDATE_DEVICE_STATE
 } subscriber_cmd_t;
@@ -74,13 +120,17 @@ typedef struct{
     subscriber_cmd_t cmd;
     uint8_t data;
     char *topic;
+    TaskHandle_t task;          /* Task that consumes the topic */
+    topic_config_t config;      /* Storage settings of the topic */
+    TickType_t tick;            /* Tick of the disconnection (RESUBSCRIBE_ALL_TOPICS) */
 } subscriber_data_t;
 
-
-typedef struct {
-    char *topic;               // Topic name
-    QueueHandle_t queue;       // Queue for this topic
-} topic_queue_entry_t ;
+/* Inbound MQTT message, held in a block of the message pool. A single copy is
+ * shared by reference between all the tasks subscribed to the topic with
+ * TOPIC_STORAGE_QUEUE storage: each topic queue carries a pointer to it, which
+ * is released by topic_receive() once the payload is copied out.
+ */
+typedef message_block_t subscriber_msg_t;
 
 /*******************************************************************************
 * Extern Variables
@@ -90,16 +140,17 @@ extern QueueHandle_t subscriber_task_q;
 extern uint32_t current_device_state;
 extern int mqttConnected;
 
-//extern topic_queue_entry_t topic_queues[];
-
 
 /*******************************************************************************
 * Function Prototypes
 ********************************************************************************/
 void subscriber_task(void *pvParameters);
 void mqtt_subscription_callback(cy_mqtt_publish_info_t *received_msg_info);
-void subscribe_to_topic(char* topic);
-QueueHandle_t get_queue_for_topic(const char *topic);
+cy_mqtt_qos_t subscribe_request(char *topic, const topic_config_t *config);
+size_t topic_receive(const char *topic, char *buffer, size_t buffer_size, TickType_t wait);
+bool topic_receive_value(const char *topic, uint32_t *value, TickType_t wait);
+void subscriber_msg_release(subscriber_msg_t *msg);
+void print_topic_budget(void);
 #endif /* SUBSCRIBER_TASK_H_ */
 
 /* [] END OF FILE */
@@ -0,0 +1,389 @@
+/******************************************************************************
+* File Name:   telemetry_codec.c
+*
+* Description: This file contains the payload codecs of the sensor telemetry.
+*              The text codec sends the bare value as a decimal string, the
+*              binary codec sends a packed, versioned record carrying the
+*              type, value, unit and timestamp of a sample. Both codecs
+*              format values with integer arithmetic only, so the float
+*              support of printf is not needed.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "publisher_task.h"
+#include "telemetry_codec.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (TELEMETRY_CODEC != TELEMETRY_CODEC_TEXT) && (TELEMETRY_CODEC != TELEMETRY_CODEC_BINARY)
+    #error "TELEMETRY_CODEC must be TELEMETRY_CODEC_TEXT or TELEMETRY_CODEC_BINARY."
+#endif
+
+#if (TELEMETRY_PAYLOAD_MAX_SIZE > PUBLISH_PAYLOAD_SIZE)
+    #error "TELEMETRY_PAYLOAD_MAX_SIZE must not exceed PUBLISH_PAYLOAD_SIZE."
+#endif
+
+#if (TELEMETRY_BINARY_MAX_SIZE > TELEMETRY_PAYLOAD_MAX_SIZE)
+    #error "TELEMETRY_BINARY_MAX_SIZE must not exceed TELEMETRY_PAYLOAD_MAX_SIZE."
+#endif
+
+/* Largest exponent magnitude the text codec handles, 10^9 still fits in
+ * 32 bits.
+ */
+#define TELEMETRY_TEXT_MAX_EXPONENT        (9)
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static size_t telemetry_encode_text(const telemetry_sample_t *sample, char *buffer,
+                                    size_t size);
+static size_t telemetry_encode_binary(const telemetry_sample_t *sample, uint8_t *buffer,
+                                      size_t size);
+static size_t put_varint(uint8_t *buffer, uint32_t value);
+
+/******************************************************************************
+ * Function Name: telemetry_sample_init
+ ******************************************************************************
+ * Summary:
+ *  Fills in a sample and stamps it with the current time since boot.
+ *
+ * Parameters:
+ *  telemetry_sample_t *sample : Sample to fill in
+ *  telemetry_type_t type : Kind of measurement
+ *  telemetry_unit_t unit : Unit of the value
+ *  int32_t value : Value mantissa
+ *  int8_t exponent : Decimal exponent of the value
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void telemetry_sample_init(telemetry_sample_t *sample, telemetry_type_t type,
+                           telemetry_unit_t unit, int32_t value, int8_t exponent)
+{
+    sample->type = type;
+    sample->unit = unit;
+    sample->exponent = exponent;
+    sample->value = value;
+    sample->timestamp_ms = (uint32_t) (xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+/******************************************************************************
+ * Function Name: telemetry_encode
+ ******************************************************************************
+ * Summary:
+ *  Encodes a sample with the codec selected by 'TELEMETRY_CODEC'.
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to encode
+ *  uint8_t *buffer : Output buffer, 'TELEMETRY_PAYLOAD_MAX_SIZE' bytes fit
+ *                    any sample
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  size_t : Length of the payload, 0 if it does not fit the buffer
+ *
+ ******************************************************************************/
+size_t telemetry_encode(const telemetry_sample_t *sample, uint8_t *buffer, size_t size)
+{
+    if (TELEMETRY_CODEC == TELEMETRY_CODEC_BINARY)
+    {
+        return telemetry_encode_binary(sample, buffer, size);
+    }
+
+    return telemetry_encode_text(sample, (char *) buffer, size);
+}
+
+/******************************************************************************
+ * Function Name: telemetry_publish
+ ******************************************************************************
+ * Summary:
+ *  Encodes a sample and publishes it on a topic and publisher lane.
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to publish
+ *  const char *topic : Null-terminated topic name
+ *  publish_lane_t lane : Publisher lane, see PublishAlarm()
+ *
+ * Return:
+ *  bool : true if the sample was handed to the publisher, false otherwise
+ *
+ ******************************************************************************/
+bool telemetry_publish(const telemetry_sample_t *sample, const char *topic,
+                       publish_lane_t lane)
+{
+    uint8_t payload[TELEMETRY_PAYLOAD_MAX_SIZE];
+    size_t payload_len = telemetry_encode(sample, payload, sizeof(payload));
+
+    if (payload_len == 0)
+    {
+        return false;
+    }
+
+    if (lane == PUBLISH_LANE_ALARM)
+    {
+        return PublishAlarm(payload, payload_len, topic);
+    }
+
+    return PublishPayload(payload, payload_len, topic);
+}
+
+/******************************************************************************
+ * Function Name: telemetry_encode_snapshot
+ ******************************************************************************
+ * Summary:
+ *  Encodes the samples of several sensors into one payload with the codec
+ *  selected by 'TELEMETRY_CODEC'. The text codec writes a JSON object keyed
+ *  by sensor name, e.g. {"radar":1,"thermistor":23.45}; the binary codec
+ *  writes 'TELEMETRY_SNAPSHOT_VERSION', the sample count and the binary
+ *  payload of each sample.
+ *
+ * Parameters:
+ *  const char *const names[] : Sensor names, used by the text codec
+ *  const telemetry_sample_t samples[] : Samples, in the order of 'names'
+ *  size_t count : Number of samples, at most 255
+ *  uint8_t *buffer : Output buffer
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  size_t : Length of the payload, 0 if it does not fit the buffer
+ *
+ ******************************************************************************/
+size_t telemetry_encode_snapshot(const char *const names[], const telemetry_sample_t samples[],
+                                 size_t count, uint8_t *buffer, size_t size)
+{
+    size_t len;
+
+    if ((count == 0) || (count > UINT8_MAX))
+    {
+        return 0;
+    }
+
+    if (TELEMETRY_CODEC == TELEMETRY_CODEC_BINARY)
+    {
+        if (size < TELEMETRY_SNAPSHOT_HEADER_SIZE)
+        {
+            return 0;
+        }
+
+        buffer[0] = TELEMETRY_SNAPSHOT_VERSION;
+        buffer[1] = (uint8_t) count;
+        len = TELEMETRY_SNAPSHOT_HEADER_SIZE;
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t written = telemetry_encode_binary(&samples[i], &buffer[len], size - len);
+
+            if (written == 0)
+            {
+                return 0;
+            }
+            len += written;
+        }
+
+        return len;
+    }
+
+    char *text = (char *) buffer;
+
+    len = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int written = snprintf(&text[len], size - len, "%c\"%s\":",
+                               (i == 0) ? '{' : ',', names[i]);
+        size_t value_len;
+
+        if ((written < 0) || (len + written >= size))
+        {
+            return 0;
+        }
+        len += written;
+
+        value_len = telemetry_encode_text(&samples[i], &text[len], size - len);
+        if (value_len == 0)
+        {
+            return 0;
+        }
+        len += value_len;
+    }
+
+    /* Closing brace and null terminator */
+    if (len + 2 > size)
+    {
+        return 0;
+    }
+    text[len++] = '}';
+    text[len] = '\0';
+
+    return len;
+}
+
+/******************************************************************************
+ * Function Name: telemetry_encode_text
+ ******************************************************************************
+ * Summary:
+ *  Formats the value of a sample as a decimal string with as many fraction
+ *  digits as the negative exponent, e.g. 2345 with exponent -2 as "23.45".
+ *  This is the payload the sensors published before the codecs existed; the
+ *  type, unit and timestamp are not sent.
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to encode
+ *  char *buffer : Output buffer, null-terminated on success
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  size_t : Length of the string, 0 if it does not fit the buffer
+ *
+ ******************************************************************************/
+static size_t telemetry_encode_text(const telemetry_sample_t *sample, char *buffer,
+                                    size_t size)
+{
+    const char *sign = (sample->value < 0) ? "-" : "";
+    /* Negate in 32 bits unsigned, INT32_MIN has no positive counterpart. */
+    uint32_t magnitude = (sample->value < 0) ? (0u - (uint32_t) sample->value) :
+                         (uint32_t) sample->value;
+    int decimals = (sample->exponent < 0) ? -sample->exponent : 0;
+    uint32_t divisor = 1;
+    int written;
+
+    if ((sample->exponent > TELEMETRY_TEXT_MAX_EXPONENT) ||
+        (decimals > TELEMETRY_TEXT_MAX_EXPONENT))
+    {
+        return 0;
+    }
+
+    for (int i = 0; i < decimals; i++)
+    {
+        divisor *= 10u;
+    }
+
+    if (decimals == 0)
+    {
+        /* Positive exponents are written as trailing zeros. */
+        written = snprintf(buffer, size, "%s%lu%.*s", sign, (unsigned long) magnitude,
+                           (int) sample->exponent, "000000000");
+    }
+    else
+    {
+        written = snprintf(buffer, size, "%s%lu.%0*lu", sign,
+                           (unsigned long) (magnitude / divisor), decimals,
+                           (unsigned long) (magnitude % divisor));
+    }
+
+    if ((written < 0) || ((size_t) written >= size))
+    {
+        return 0;
+    }
+
+    return (size_t) written;
+}
+
+/******************************************************************************
+ * Function Name: telemetry_encode_binary
+ ******************************************************************************
+ * Summary:
+ *  Packs a sample into the binary layout described in telemetry_codec.h, 4
+ *  to 'TELEMETRY_BINARY_MAX_SIZE' bytes. The fields are written byte by
+ *  byte, so the layout does not depend on the struct packing of the compiler.
+ *
+ * Parameters:
+ *  const telemetry_sample_t *sample : Sample to encode
+ *  uint8_t *buffer : Output buffer
+ *  size_t size : Size of the output buffer
+ *
+ * Return:
+ *  size_t : Length of the payload, 0 if it may not fit the buffer
+ *
+ ******************************************************************************/
+static size_t telemetry_encode_binary(const telemetry_sample_t *sample, uint8_t *buffer,
+                                      size_t size)
+{
+    /* Zigzag in 32 bits unsigned, so that the shift of a negative value is
+     * well defined.
+     */
+    uint32_t value = ((uint32_t) sample->value << 1) ^ ((sample->value < 0) ? UINT32_MAX : 0u);
+    size_t len = 2;
+
+    if (size < TELEMETRY_BINARY_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    buffer[0] = (uint8_t) (((uint32_t) sample->type << 4) | ((uint32_t) sample->unit & 0x0Fu));
+    buffer[1] = (uint8_t) sample->exponent;
+    len += put_varint(&buffer[len], value);
+    len += put_varint(&buffer[len], sample->timestamp_ms);
+
+    return len;
+}
+
+/******************************************************************************
+ * Function Name: put_varint
+ ******************************************************************************
+ * Summary:
+ *  Writes a 32-bit value as a varint, 7 bits per byte, least significant
+ *  group first.
+ *
+ * Parameters:
+ *  uint8_t *buffer : Destination, up to 5 bytes
+ *  uint32_t value : Value to write
+ *
+ * Return:
+ *  size_t : Number of bytes written
+ *
+ ******************************************************************************/
+static size_t put_varint(uint8_t *buffer, uint32_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80u)
+    {
+        buffer[len++] = (uint8_t) (value | 0x80u);
+        value >>= 7;
+    }
+    buffer[len++] = (uint8_t) value;
+
+    return len;
+}
+
+/* [] END OF FILE */
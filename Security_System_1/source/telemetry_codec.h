@@ -0,0 +1,129 @@
+/******************************************************************************
+* File Name:   telemetry_codec.h
+*
+* Description: This file is the public interface of telemetry_codec.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TELEMETRY_CODEC_H_
+#define TELEMETRY_CODEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mqtt_client_config.h"
+#include "publisher_task.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Payload codecs, selected with 'TELEMETRY_CODEC'. */
+#define TELEMETRY_CODEC_TEXT               (0)
+#define TELEMETRY_CODEC_BINARY             (1)
+
+#ifndef TELEMETRY_CODEC
+#define TELEMETRY_CODEC                    TELEMETRY_CODEC_TEXT
+#endif
+
+/* Largest binary payload. The layout is:
+ *   byte 0       type, telemetry_type_t, in the high nibble and unit,
+ *                telemetry_unit_t, in the low nibble
+ *   byte 1       decimal exponent, signed
+ *   1-5 bytes    value mantissa, zigzag-encoded varint
+ *   1-5 bytes    timestamp in ms since boot, varint
+ * The value is mantissa * 10^exponent. A varint holds 7 bits per byte, least
+ * significant group first, with the top bit set on every byte but the last;
+ * zigzag maps 0, -1, 1, -2... to 0, 1, 2, 3... so small negative values stay
+ * short. Types are below 8, so byte 0 never has its top bit set.
+ */
+#define TELEMETRY_BINARY_MAX_SIZE          (12u)
+
+/* First byte of a binary snapshot, followed by the number of samples and
+ * that many binary payloads. It has its top bit set, unlike the first byte
+ * of a single binary payload.
+ */
+#define TELEMETRY_SNAPSHOT_VERSION         (0x81u)
+#define TELEMETRY_SNAPSHOT_HEADER_SIZE     (2u)
+
+/* Buffer size that fits a payload of any codec. */
+#define TELEMETRY_PAYLOAD_MAX_SIZE         (24u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Kind of measurement carried by a sample. */
+typedef enum
+{
+    TELEMETRY_TYPE_TEMPERATURE = 1,
+    TELEMETRY_TYPE_VIBRATION   = 2,
+    TELEMETRY_TYPE_BUTTON      = 3,
+    TELEMETRY_TYPE_PRESENCE    = 4
+} telemetry_type_t;
+
+/* Unit of the value of a sample. */
+typedef enum
+{
+    TELEMETRY_UNIT_NONE        = 0,
+    TELEMETRY_UNIT_CELSIUS     = 1,
+    TELEMETRY_UNIT_MICROVOLT   = 2
+} telemetry_unit_t;
+
+/* Sensor sample, the value is 'value' * 10^'exponent' in 'unit'. */
+typedef struct
+{
+    telemetry_type_t type;
+    telemetry_unit_t unit;
+    int8_t exponent;
+    int32_t value;
+    uint32_t timestamp_ms;
+} telemetry_sample_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void telemetry_sample_init(telemetry_sample_t *sample, telemetry_type_t type,
+                           telemetry_unit_t unit, int32_t value, int8_t exponent);
+size_t telemetry_encode(const telemetry_sample_t *sample, uint8_t *buffer, size_t size);
+bool telemetry_publish(const telemetry_sample_t *sample, const char *topic,
+                       publish_lane_t lane);
+size_t telemetry_encode_snapshot(const char *const names[], const telemetry_sample_t samples[],
+                                 size_t count, uint8_t *buffer, size_t size);
+
+#endif /* TELEMETRY_CODEC_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,439 @@
+/******************************************************************************
+* File Name:   topic_filter.c
+*
+* Description: This file contains the trie of MQTT topic filters that use the
+*              '+' and '#' wildcards. An inbound topic is matched against
+*              all registered filters in a single pass over its levels.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "topic_filter.h"
+
+/* Middleware libraries */
+#include "cy_retarget_io.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* Index used for a missing node link. */
+#define TOPIC_FILTER_NO_NODE                    (-1)
+
+/* Index of the root node, which stands for the start of a topic. */
+#define TOPIC_FILTER_ROOT_NODE                  (0)
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* A node of the trie. Each node stands for one topic level. Exact levels of
+ * a node are kept in a sibling list, while the '+' level and a trailing '#'
+ * level have dedicated links so that they are found without a search.
+ */
+typedef struct
+{
+    const char *level;                      /* Level name, not null-terminated */
+    uint32_t level_hash;                    /* Hash of the level name */
+    uint16_t level_len;                     /* Length of the level name */
+    int16_t first_child;                    /* First exact child level */
+    int16_t next_sibling;                   /* Next exact level of the parent */
+    int16_t single_level_child;             /* '+' child level */
+    topic_registry_entry_t *entry;          /* Filter that ends at this level */
+    topic_registry_entry_t *multi_level;    /* Filter that ends with '/#' here */
+} topic_filter_node_t;
+
+/* Node pool of the trie. Node 0 is the root and nodes are never released.
+ * The level names point into the topic names owned by the topic registry.
+ */
+static topic_filter_node_t topic_filter_nodes[TOPIC_FILTER_MAX_NODES] =
+{
+    [TOPIC_FILTER_ROOT_NODE] =
+    {
+        .first_child = TOPIC_FILTER_NO_NODE,
+        .next_sibling = TOPIC_FILTER_NO_NODE,
+        .single_level_child = TOPIC_FILTER_NO_NODE
+    }
+};
+
+/* Number of nodes in use, including the root. */
+static int16_t topic_filter_node_count = 1;
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static bool topic_filter_validate(const char *filter, size_t filter_len);
+static int16_t topic_filter_new_node(const char *level, uint16_t level_len);
+static int16_t topic_filter_find_child(int16_t node, const char *level,
+                                       uint16_t level_len, uint32_t level_hash);
+
+/******************************************************************************
+ * Function Name: topic_filter_is_wildcard
+ ******************************************************************************
+ * Summary:
+ *  Checks if a topic filter contains a '+' or '#' wildcard.
+ *
+ * Parameters:
+ *  const char *filter : Topic filter (need not be null-terminated)
+ *  size_t filter_len : Length of the topic filter
+ *
+ * Return:
+ *  bool : true if the filter has a wildcard, else false
+ *
+ ******************************************************************************/
+bool topic_filter_is_wildcard(const char *filter, size_t filter_len)
+{
+    return (memchr(filter, TOPIC_FILTER_SINGLE_LEVEL, filter_len) != NULL) ||
+           (memchr(filter, TOPIC_FILTER_MULTI_LEVEL, filter_len) != NULL);
+}
+
+/******************************************************************************
+ * Function Name: topic_filter_validate
+ ******************************************************************************
+ * Summary:
+ *  Checks that the wildcards of a topic filter follow the MQTT rules: '+'
+ *  and '#' must take up a whole level, and '#' must be the last level.
+ *
+ * Parameters:
+ *  const char *filter : Topic filter (need not be null-terminated)
+ *  size_t filter_len : Length of the topic filter
+ *
+ * Return:
+ *  bool : true if the filter is valid, else false
+ *
+ ******************************************************************************/
+static bool topic_filter_validate(const char *filter, size_t filter_len)
+{
+    for (size_t i = 0; i < filter_len; i++)
+    {
+        bool level_start = (i == 0) || (filter[i - 1] == TOPIC_LEVEL_SEPARATOR);
+        bool level_end = (i + 1 == filter_len) ||
+                         (filter[i + 1] == TOPIC_LEVEL_SEPARATOR);
+
+        if ((filter[i] == TOPIC_FILTER_SINGLE_LEVEL) && !(level_start && level_end))
+        {
+            return false;
+        }
+
+        if ((filter[i] == TOPIC_FILTER_MULTI_LEVEL) &&
+            !(level_start && (i + 1 == filter_len)))
+        {
+            return false;
+        }
+    }
+
+    return (filter_len > 0);
+}
+
+/******************************************************************************
+ * Function Name: topic_filter_new_node
+ ******************************************************************************
+ * Summary:
+ *  Takes a node from the pool and initializes it for the given level. Must be
+ *  called from within a critical section.
+ *
+ * Parameters:
+ *  const char *level : Level name (not null-terminated)
+ *  uint16_t level_len : Length of the level name
+ *
+ * Return:
+ *  int16_t : Index of the new node, TOPIC_FILTER_NO_NODE if the pool is empty
+ *
+ ******************************************************************************/
+static int16_t topic_filter_new_node(const char *level, uint16_t level_len)
+{
+    topic_filter_node_t *node;
+
+    if (topic_filter_node_count >= (int16_t) TOPIC_FILTER_MAX_NODES)
+    {
+        return TOPIC_FILTER_NO_NODE;
+    }
+
+    node = &topic_filter_nodes[topic_filter_node_count];
+    node->level = level;
+    node->level_len = level_len;
+    node->level_hash = topic_registry_hash(level, level_len);
+    node->first_child = TOPIC_FILTER_NO_NODE;
+    node->next_sibling = TOPIC_FILTER_NO_NODE;
+    node->single_level_child = TOPIC_FILTER_NO_NODE;
+    node->entry = NULL;
+    node->multi_level = NULL;
+
+    return topic_filter_node_count++;
+}
+
+/******************************************************************************
+ * Function Name: topic_filter_find_child
+ ******************************************************************************
+ * Summary:
+ *  Finds the exact child level of a node.
+ *
+ * Parameters:
+ *  int16_t node : Index of the parent node
+ *  const char *level : Level name (not null-terminated)
+ *  uint16_t level_len : Length of the level name
+ *  uint32_t level_hash : Hash of the level name
+ *
+ * Return:
+ *  int16_t : Index of the child node, TOPIC_FILTER_NO_NODE if not present
+ *
+ ******************************************************************************/
+static int16_t topic_filter_find_child(int16_t node, const char *level,
+                                       uint16_t level_len, uint32_t level_hash)
+{
+    int16_t child = topic_filter_nodes[node].first_child;
+
+    while (child != TOPIC_FILTER_NO_NODE)
+    {
+        const topic_filter_node_t *child_node = &topic_filter_nodes[child];
+
+        if ((child_node->level_hash == level_hash) &&
+            (child_node->level_len == level_len) &&
+            (memcmp(child_node->level, level, level_len) == 0))
+        {
+            break;
+        }
+        child = child_node->next_sibling;
+    }
+
+    return child;
+}
+
+/******************************************************************************
+ * Function Name: topic_filter_add
+ ******************************************************************************
+ * Summary:
+ *  Adds the topic filter of a registry entry to the trie. Inbound topics that
+ *  match the filter are then reported by topic_filter_match().
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry holding the topic filter
+ *
+ * Return:
+ *  bool : true if the filter was added, false if it is not a valid filter or
+ *         the trie is full
+ *
+ ******************************************************************************/
+bool topic_filter_add(topic_registry_entry_t *entry)
+{
+    const char *filter = entry->topic;
+    size_t filter_len = entry->topic_len;
+    int16_t node = TOPIC_FILTER_ROOT_NODE;
+    bool added = false;
+    size_t level_start = 0;
+
+    if (!topic_filter_validate(filter, filter_len))
+    {
+        printf("Error: Invalid topic filter: %.*s\n", (int) filter_len, filter);
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    while (node != TOPIC_FILTER_NO_NODE)
+    {
+        const char *level = &filter[level_start];
+        const char *separator = memchr(level, TOPIC_LEVEL_SEPARATOR,
+                                       filter_len - level_start);
+        uint16_t level_len = (separator == NULL) ?
+                             (uint16_t) (filter_len - level_start) :
+                             (uint16_t) (separator - level);
+        topic_filter_node_t *parent = &topic_filter_nodes[node];
+
+        if ((level_len == 1) && (level[0] == TOPIC_FILTER_MULTI_LEVEL))
+        {
+            /* '#' is always the last level, so it is stored on its parent. */
+            parent->multi_level = entry;
+            added = true;
+            break;
+        }
+
+        if ((level_len == 1) && (level[0] == TOPIC_FILTER_SINGLE_LEVEL))
+        {
+            if (parent->single_level_child == TOPIC_FILTER_NO_NODE)
+            {
+                parent->single_level_child = topic_filter_new_node(level, level_len);
+            }
+            node = parent->single_level_child;
+        }
+        else
+        {
+            int16_t child = topic_filter_find_child(node, level, level_len,
+                                            topic_registry_hash(level, level_len));
+
+            if (child == TOPIC_FILTER_NO_NODE)
+            {
+                child = topic_filter_new_node(level, level_len);
+                if (child != TOPIC_FILTER_NO_NODE)
+                {
+                    /* Link the node last so that a concurrent match never
+                     * sees a partially initialized node.
+                     */
+                    topic_filter_nodes[child].next_sibling = parent->first_child;
+                    parent->first_child = child;
+                }
+            }
+            node = child;
+        }
+
+        if ((node != TOPIC_FILTER_NO_NODE) && (separator == NULL))
+        {
+            topic_filter_nodes[node].entry = entry;
+            added = true;
+            break;
+        }
+        level_start += level_len + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!added)
+    {
+        printf("Error: Topic filter trie full: %.*s\n", (int) filter_len, filter);
+    }
+
+    return added;
+}
+
+/******************************************************************************
+ * Function Name: topic_filter_match
+ ******************************************************************************
+ * Summary:
+ *  Matches an inbound topic against all registered topic filters in a single
+ *  pass over its levels. The set of trie nodes that match the levels seen so
+ *  far is advanced one level at a time, following both the exact level and
+ *  the '+' level of every node in the set. Filters ending in '#' match as
+ *  soon as their parent level is reached. As required by MQTT, topics that
+ *  start with '$' are not matched by a leading wildcard.
+ *
+ * Parameters:
+ *  const char *topic : Inbound topic (need not be null-terminated)
+ *  size_t topic_len : Length of the topic
+ *  topic_registry_entry_t **matches : Array that receives the matching
+ *                                     registry entries
+ *  size_t max_matches : Number of elements in 'matches'
+ *
+ * Return:
+ *  size_t : Number of matching filters stored in 'matches'
+ *
+ ******************************************************************************/
+size_t topic_filter_match(const char *topic, size_t topic_len,
+                          topic_registry_entry_t **matches, size_t max_matches)
+{
+    int16_t active[TOPIC_FILTER_MAX_ACTIVE];
+    int16_t next[TOPIC_FILTER_MAX_ACTIVE];
+    size_t active_count = 1;
+    size_t match_count = 0;
+    size_t level_start = 0;
+    bool system_topic = (topic_len > 0) && (topic[0] == '$');
+
+    active[0] = TOPIC_FILTER_ROOT_NODE;
+
+    while (active_count > 0)
+    {
+        const char *level = &topic[level_start];
+        const char *separator = memchr(level, TOPIC_LEVEL_SEPARATOR,
+                                       topic_len - level_start);
+        uint16_t level_len = (separator == NULL) ?
+                             (uint16_t) (topic_len - level_start) :
+                             (uint16_t) (separator - level);
+        uint32_t level_hash = topic_registry_hash(level, level_len);
+        size_t next_count = 0;
+
+        for (size_t i = 0; i < active_count; i++)
+        {
+            const topic_filter_node_t *node = &topic_filter_nodes[active[i]];
+            int16_t child;
+
+            if (system_topic && (active[i] == TOPIC_FILTER_ROOT_NODE))
+            {
+                child = topic_filter_find_child(active[i], level, level_len, level_hash);
+                if (child != TOPIC_FILTER_NO_NODE)
+                {
+                    next[next_count++] = child;
+                }
+                continue;
+            }
+
+            /* '#' matches the remaining levels, including none at all. */
+            if ((node->multi_level != NULL) && (match_count < max_matches))
+            {
+                matches[match_count++] = node->multi_level;
+            }
+
+            child = topic_filter_find_child(active[i], level, level_len, level_hash);
+            if ((child != TOPIC_FILTER_NO_NODE) && (next_count < TOPIC_FILTER_MAX_ACTIVE))
+            {
+                next[next_count++] = child;
+            }
+
+            if ((node->single_level_child != TOPIC_FILTER_NO_NODE) &&
+                (next_count < TOPIC_FILTER_MAX_ACTIVE))
+            {
+                next[next_count++] = node->single_level_child;
+            }
+        }
+
+        if (separator == NULL)
+        {
+            /* Last level: report the filters ending here, and the filters
+             * ending in '#' directly below them.
+             */
+            for (size_t i = 0; i < next_count; i++)
+            {
+                const topic_filter_node_t *node = &topic_filter_nodes[next[i]];
+
+                if ((node->entry != NULL) && (match_count < max_matches))
+                {
+                    matches[match_count++] = node->entry;
+                }
+                if ((node->multi_level != NULL) && (match_count < max_matches))
+                {
+                    matches[match_count++] = node->multi_level;
+                }
+            }
+            break;
+        }
+
+        memcpy(active, next, next_count * sizeof(next[0]));
+        active_count = next_count;
+        level_start += level_len + 1u;
+    }
+
+    return match_count;
+}
+
+/* [] END OF FILE */
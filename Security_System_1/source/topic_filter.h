@@ -0,0 +1,82 @@
+/******************************************************************************
+* File Name:   topic_filter.h
+*
+* Description: This file is the public interface of topic_filter.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TOPIC_FILTER_H_
+#define TOPIC_FILTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "topic_registry.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Maximum number of levels stored in the topic filter trie, summed over all
+ * registered filters. Can be overridden from the Makefile.
+ */
+#ifndef TOPIC_FILTER_MAX_NODES
+#define TOPIC_FILTER_MAX_NODES             (64u)
+#endif
+
+/* Maximum number of trie nodes that can be active at the same time while an
+ * inbound topic is matched. Every '+' level reachable from an active node
+ * adds one node to the set.
+ */
+#define TOPIC_FILTER_MAX_ACTIVE            (8u)
+
+/* MQTT topic filter wildcard characters. */
+#define TOPIC_FILTER_SINGLE_LEVEL          '+'
+#define TOPIC_FILTER_MULTI_LEVEL           '#'
+#define TOPIC_LEVEL_SEPARATOR              '/'
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+bool topic_filter_is_wildcard(const char *filter, size_t filter_len);
+bool topic_filter_add(topic_registry_entry_t *entry);
+size_t topic_filter_match(const char *topic, size_t topic_len,
+                          topic_registry_entry_t **matches, size_t max_matches);
+
+#endif /* TOPIC_FILTER_H_ */
+
+/* [] END OF FILE */
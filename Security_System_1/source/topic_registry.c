@@ -0,0 +1,466 @@
+/******************************************************************************
+* File Name:   topic_registry.c
+*
+* Description: This file contains the topic registry that maps MQTT topic
+*              names to the queues of the tasks consuming them. Topics are
+*              kept in a fixed-size open-addressing hash table so that the
+*              lookup done for every inbound message is O(1).
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "topic_registry.h"
+
+/* Middleware libraries */
+#include "cy_retarget_io.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* FNV-1a 32-bit parameters. */
+#define FNV1A_OFFSET_BASIS                      (2166136261u)
+#define FNV1A_PRIME                             (16777619u)
+
+/* Mask used to wrap the linear probe sequence around the table. */
+#define TOPIC_REGISTRY_MASK                     (TOPIC_REGISTRY_SLOTS - 1u)
+
+#if ((TOPIC_REGISTRY_SLOTS & TOPIC_REGISTRY_MASK) != 0u)
+    #error "TOPIC_REGISTRY_SLOTS must be a power of two."
+#endif
+
+#if (TOPIC_REGISTRY_MAX_TOPICS >= TOPIC_REGISTRY_SLOTS)
+    #error "TOPIC_REGISTRY_MAX_TOPICS must leave at least one slot unused."
+#endif
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Hash table of the registered topics. A removed topic leaves its slot marked
+ * as removed rather than unused, so a lookup can stop at the first unused slot
+ * of its probe sequence and no entry ever moves under a lookup in progress.
+ */
+static topic_registry_entry_t topic_registry[TOPIC_REGISTRY_SLOTS];
+
+/* Number of topics currently registered. */
+static size_t topic_registry_size = 0;
+
+/* Number of slots marked as removed and not yet claimed again. */
+static size_t topic_registry_removed = 0;
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static topic_registry_entry_t *topic_registry_probe(const char *topic,
+                                                    size_t topic_len,
+                                                    uint32_t hash,
+                                                    topic_registry_entry_t **removed);
+
+/******************************************************************************
+ * Function Name: topic_registry_hash
+ ******************************************************************************
+ * Summary:
+ *  Computes the FNV-1a hash of a topic name. The values reserved for unused
+ *  and removed slots are never returned.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *
+ * Return:
+ *  uint32_t : Hash of the topic name
+ *
+ ******************************************************************************/
+uint32_t topic_registry_hash(const char *topic, size_t topic_len)
+{
+    uint32_t hash = FNV1A_OFFSET_BASIS;
+
+    for (size_t i = 0; i < topic_len; i++)
+    {
+        hash ^= (uint8_t) topic[i];
+        hash *= FNV1A_PRIME;
+    }
+
+    if ((hash == TOPIC_REGISTRY_EMPTY_HASH) || (hash == TOPIC_REGISTRY_REMOVED_HASH))
+    {
+        hash = TOPIC_REGISTRY_REMOVED_HASH + 1u;
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_probe
+ ******************************************************************************
+ * Summary:
+ *  Walks the probe sequence of a topic and returns either the slot holding
+ *  the topic or the first unused slot of the sequence. Removed slots are
+ *  skipped.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *  uint32_t hash : Hash of the topic name
+ *  topic_registry_entry_t **removed : Set to the first removed slot of the
+ *                                     sequence, or NULL if there is none.
+ *                                     May be NULL.
+ *
+ * Return:
+ *  topic_registry_entry_t * : Matching or unused slot
+ *
+ ******************************************************************************/
+static topic_registry_entry_t *topic_registry_probe(const char *topic,
+                                                    size_t topic_len,
+                                                    uint32_t hash,
+                                                    topic_registry_entry_t **removed)
+{
+    uint32_t index = hash & TOPIC_REGISTRY_MASK;
+    topic_registry_entry_t *entry = &topic_registry[index];
+
+    if (removed != NULL)
+    {
+        *removed = NULL;
+    }
+
+    /* The table always has an unused slot, so this loop terminates. */
+    while (entry->hash != TOPIC_REGISTRY_EMPTY_HASH)
+    {
+        if ((entry->hash == TOPIC_REGISTRY_REMOVED_HASH) && (removed != NULL) &&
+            (*removed == NULL))
+        {
+            *removed = entry;
+        }
+        else if ((entry->hash == hash) && (entry->topic_len == topic_len) &&
+            (memcmp(entry->topic, topic, topic_len) == 0))
+        {
+            break;
+        }
+
+        index = (index + 1u) & TOPIC_REGISTRY_MASK;
+        entry = &topic_registry[index];
+    }
+
+    return entry;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_find
+ ******************************************************************************
+ * Summary:
+ *  Looks up a topic in the registry. The lookup does not take any lock; slots
+ *  are published inside a critical section by topic_registry_add() and are
+ *  only ever marked as removed afterwards, never moved.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *
+ * Return:
+ *  topic_registry_entry_t * : Registry entry of the topic, NULL if the topic
+ *                             is not registered
+ *
+ ******************************************************************************/
+topic_registry_entry_t *topic_registry_find(const char *topic, size_t topic_len)
+{
+    topic_registry_entry_t *entry;
+
+    if (topic_len > TOPIC_MAX_LENGTH)
+    {
+        return NULL;
+    }
+
+    entry = topic_registry_probe(topic, topic_len,
+                                 topic_registry_hash(topic, topic_len), NULL);
+
+    return (entry->hash == TOPIC_REGISTRY_EMPTY_HASH) ? NULL : entry;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_add
+ ******************************************************************************
+ * Summary:
+ *  Registers a topic without any subscribers. If the topic is already
+ *  registered, the existing entry and its storage settings are returned
+ *  unchanged.
+ *
+ * Parameters:
+ *  const char *topic : Topic name (need not be null-terminated)
+ *  size_t topic_len : Length of the topic name
+ *  const topic_config_t *config : Storage settings of the topic
+ *
+ * Return:
+ *  topic_registry_entry_t * : Registry entry of the topic, NULL if the topic
+ *                             is too long or the registry is full
+ *
+ ******************************************************************************/
+topic_registry_entry_t *topic_registry_add(const char *topic, size_t topic_len,
+                                           const topic_config_t *config)
+{
+    topic_registry_entry_t *entry;
+    topic_registry_entry_t *removed;
+    uint32_t hash;
+    char *topic_copy;
+    char *stale_copy = NULL;
+
+    if (topic_len > TOPIC_MAX_LENGTH)
+    {
+        printf("Error: Topic too long: %.*s\n", (int) topic_len, topic);
+        return NULL;
+    }
+
+    hash = topic_registry_hash(topic, topic_len);
+
+    /* Allocate the copy of the topic name outside the critical section. */
+    topic_copy = pvPortMalloc(topic_len + 1);
+    if (topic_copy == NULL)
+    {
+        printf("Error: Failed to allocate memory for topic: %.*s\n",
+               (int) topic_len, topic);
+        return NULL;
+    }
+    memcpy(topic_copy, topic, topic_len);
+    topic_copy[topic_len] = '\0';
+
+    taskENTER_CRITICAL();
+    entry = topic_registry_probe(topic, topic_len, hash, &removed);
+    if (entry->hash == TOPIC_REGISTRY_EMPTY_HASH)
+    {
+        /* Claim a removed slot of the probe sequence first. An unused slot is
+         * only claimed while the table keeps another one, so that every probe
+         * sequence still ends.
+         */
+        if (topic_registry_size >= TOPIC_REGISTRY_MAX_TOPICS)
+        {
+            entry = NULL;
+        }
+        else if (removed != NULL)
+        {
+            entry = removed;
+            stale_copy = entry->topic;
+            topic_registry_removed--;
+        }
+        else if ((topic_registry_size + topic_registry_removed) >= (TOPIC_REGISTRY_SLOTS - 1u))
+        {
+            entry = NULL;
+        }
+
+        if (entry != NULL)
+        {
+            entry->topic = topic_copy;
+            entry->topic_len = (uint16_t) topic_len;
+            entry->subscriber_count = 0;
+            entry->subscribed = false;
+            entry->granted_qos = 0;
+            entry->config = *config;
+            entry->dropped = 0;
+            entry->overwritten = 0;
+            entry->hash = hash;
+            topic_registry_size++;
+            topic_copy = NULL;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    /* The topic was already registered or the registry is full. */
+    if (topic_copy != NULL)
+    {
+        vPortFree(topic_copy);
+    }
+
+    /* Name of the topic removed from the claimed slot, see
+     * topic_registry_remove().
+     */
+    if (stale_copy != NULL)
+    {
+        vPortFree(stale_copy);
+    }
+
+    return entry;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_remove
+ ******************************************************************************
+ * Summary:
+ *  Removes a topic that has no subscribers from the registry. The slot is
+ *  marked as removed so that lookups keep walking past it, and is claimed
+ *  again by a later topic_registry_add() of a topic probing through it.
+ *  The copy of the topic name is only released then, as a lookup running
+ *  without lock may still be comparing it.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void topic_registry_remove(topic_registry_entry_t *entry)
+{
+    taskENTER_CRITICAL();
+    if ((entry->hash != TOPIC_REGISTRY_EMPTY_HASH) &&
+        (entry->hash != TOPIC_REGISTRY_REMOVED_HASH) &&
+        (entry->subscriber_count == 0))
+    {
+        entry->hash = TOPIC_REGISTRY_REMOVED_HASH;
+        entry->subscribed = false;
+        topic_registry_size--;
+        topic_registry_removed++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_attach
+ ******************************************************************************
+ * Summary:
+ *  Adds a consuming task and its storage to the subscriber list of a topic.
+ *  A task has at most one storage per topic; if the task is already
+ *  attached, its existing subscriber is returned and the caller is expected
+ *  to release the storage it passed in.
+ *
+ * Parameters:
+ *  topic_registry_entry_t *entry : Registry entry of the topic
+ *  const topic_subscriber_t *subscriber : Consuming task and its storage
+ *
+ * Return:
+ *  const topic_subscriber_t * : Subscriber of the task for this topic, NULL
+ *                               if the subscriber list is full
+ *
+ ******************************************************************************/
+const topic_subscriber_t *topic_registry_attach(topic_registry_entry_t *entry,
+                                                const topic_subscriber_t *subscriber)
+{
+    const topic_subscriber_t *attached;
+
+    taskENTER_CRITICAL();
+    attached = topic_registry_get_subscriber(entry, subscriber->task);
+    if (attached == NULL)
+    {
+        if (entry->subscriber_count < TOPIC_MAX_SUBSCRIBERS)
+        {
+            /* Fill the slot before it is counted, so that the subscription
+             * callback never delivers to a partially written subscriber.
+             */
+            entry->subscribers[entry->subscriber_count] = *subscriber;
+            attached = &entry->subscribers[entry->subscriber_count];
+            entry->subscriber_count++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return attached;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_get_subscriber
+ ******************************************************************************
+ * Summary:
+ *  Returns the subscriber through which a task consumes the messages of a
+ *  topic.
+ *
+ * Parameters:
+ *  const topic_registry_entry_t *entry : Registry entry of the topic
+ *  TaskHandle_t task : Consuming task
+ *
+ * Return:
+ *  const topic_subscriber_t * : Subscriber of the task, NULL if the task is
+ *                               not attached
+ *
+ ******************************************************************************/
+const topic_subscriber_t *topic_registry_get_subscriber(const topic_registry_entry_t *entry,
+                                                        TaskHandle_t task)
+{
+    for (uint8_t i = 0; i < entry->subscriber_count; i++)
+    {
+        if (entry->subscribers[i].task == task)
+        {
+            return &entry->subscribers[i];
+        }
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_count
+ ******************************************************************************
+ * Summary:
+ *  Returns the number of registered topics.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  size_t : Number of registered topics
+ *
+ ******************************************************************************/
+size_t topic_registry_count(void)
+{
+    return topic_registry_size;
+}
+
+/******************************************************************************
+ * Function Name: topic_registry_at
+ ******************************************************************************
+ * Summary:
+ *  Returns the topic held in a slot of the registry, so that the registered
+ *  topics can be walked with a loop over 0 .. TOPIC_REGISTRY_SLOTS - 1.
+ *
+ * Parameters:
+ *  size_t slot : Slot index
+ *
+ * Return:
+ *  topic_registry_entry_t * : Registry entry, NULL if the slot is unused,
+ *                             removed or out of range
+ *
+ ******************************************************************************/
+topic_registry_entry_t *topic_registry_at(size_t slot)
+{
+    if ((slot >= TOPIC_REGISTRY_SLOTS) ||
+        (topic_registry[slot].hash == TOPIC_REGISTRY_EMPTY_HASH) ||
+        (topic_registry[slot].hash == TOPIC_REGISTRY_REMOVED_HASH))
+    {
+        return NULL;
+    }
+
+    return &topic_registry[slot];
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,171 @@
+/******************************************************************************
+* File Name:   topic_registry.h
+*
+* Description: This file is the public interface of topic_registry.c
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TOPIC_REGISTRY_H_
+#define TOPIC_REGISTRY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "message_buffer.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Number of slots in the open-addressing table. Must be a power of two so that
+ * the probe sequence can wrap with a mask instead of a modulo.
+ */
+#ifndef TOPIC_REGISTRY_SLOTS
+#define TOPIC_REGISTRY_SLOTS               (64u)
+#endif
+
+/* Maximum number of topics that can be registered. Kept below the slot count
+ * so that probe sequences stay short and a lookup miss always terminates.
+ * Both sizes can be overridden from the Makefile, e.g. by the host benchmark
+ * in bench/.
+ */
+#ifndef TOPIC_REGISTRY_MAX_TOPICS
+#define TOPIC_REGISTRY_MAX_TOPICS          (50u)
+#endif
+
+/* Longest topic name (excluding the null terminator) accepted by the registry. */
+#define TOPIC_MAX_LENGTH                   (64u)
+
+/* Maximum number of tasks that can consume the messages of one topic. */
+#define TOPIC_MAX_SUBSCRIBERS              (4u)
+
+/* Hash value reserved to mark an unused slot. */
+#define TOPIC_REGISTRY_EMPTY_HASH          (0u)
+
+/* Hash value reserved to mark the slot of a removed topic. */
+#define TOPIC_REGISTRY_REMOVED_HASH        (1u)
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Storage used to hand the messages of a topic to a consuming task. */
+typedef enum
+{
+    TOPIC_STORAGE_QUEUE,            /* Queue of shared message pool blocks */
+    TOPIC_STORAGE_MESSAGE_BUFFER,   /* Message buffer of variable length copies */
+    TOPIC_STORAGE_MAILBOX,          /* Single slot holding the latest message */
+    TOPIC_STORAGE_NOTIFY,           /* Task notification value, no storage */
+    TOPIC_STORAGE_CALLBACK          /* Handler called in the MQTT callback, no storage */
+} topic_storage_kind_t;
+
+/* Handler of a TOPIC_STORAGE_CALLBACK topic. It gets the whole payload, up to
+ * the MQTT network buffer size, runs in the context of the MQTT library and
+ * must not block.
+ */
+typedef void (*topic_receive_callback_t)(const char *topic, size_t topic_len,
+                                         const void *payload, size_t payload_len);
+
+/* What happens to a message delivered to a storage that is already full. */
+typedef enum
+{
+    TOPIC_OVERFLOW_DROP_NEWEST,     /* The incoming message is dropped */
+    TOPIC_OVERFLOW_DROP_OLDEST,     /* The oldest pending message is dropped */
+    TOPIC_OVERFLOW_OVERWRITE_LATEST /* Pending messages are replaced by the incoming one */
+} topic_overflow_policy_t;
+
+/* Per-topic storage settings, applied to the storage of every consuming task
+ * of the topic. The settings of the first registration of a topic are kept.
+ */
+typedef struct
+{
+    topic_storage_kind_t kind;  /* Storage kind */
+    topic_overflow_policy_t overflow; /* Overflow policy */
+    uint8_t depth;              /* Messages held (ignored for a mailbox) */
+    uint16_t max_payload;       /* Longest payload kept, longer ones are truncated */
+    topic_receive_callback_t callback; /* Handler, TOPIC_STORAGE_CALLBACK only */
+} topic_config_t;
+
+/* A task consuming the messages of a topic through its own storage. */
+typedef struct
+{
+    TaskHandle_t task;                          /* Consuming task */
+    union
+    {
+        QueueHandle_t queue;                    /* Queue or mailbox */
+        MessageBufferHandle_t message_buffer;   /* Message buffer */
+    };
+} topic_subscriber_t;
+
+/* A registered topic. The hash and length are computed once at registration
+ * so that a lookup only compares the topic bytes of a slot whose hash and
+ * length already match.
+ */
+typedef struct
+{
+    uint32_t hash;              /* FNV-1a hash of the topic, 0 if unused, 1 if removed */
+    uint16_t topic_len;         /* Length of the topic name */
+    uint8_t subscriber_count;   /* Number of valid entries in 'subscribers' */
+    bool subscribed;            /* Subscription acknowledged by the broker */
+    uint8_t granted_qos;        /* QoS granted by the broker when subscribed */
+    char *topic;                /* Null-terminated copy of the topic name */
+    topic_config_t config;      /* Storage settings of the topic */
+    uint32_t dropped;           /* Messages dropped, written by the MQTT callback only */
+    uint32_t overwritten;       /* Pending messages replaced by newer ones */
+    topic_subscriber_t subscribers[TOPIC_MAX_SUBSCRIBERS];
+} topic_registry_entry_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+uint32_t topic_registry_hash(const char *topic, size_t topic_len);
+topic_registry_entry_t *topic_registry_find(const char *topic, size_t topic_len);
+topic_registry_entry_t *topic_registry_add(const char *topic, size_t topic_len,
+                                           const topic_config_t *config);
+void topic_registry_remove(topic_registry_entry_t *entry);
+const topic_subscriber_t *topic_registry_attach(topic_registry_entry_t *entry,
+                                                const topic_subscriber_t *subscriber);
+const topic_subscriber_t *topic_registry_get_subscriber(const topic_registry_entry_t *entry,
+                                                        TaskHandle_t task);
+size_t topic_registry_count(void);
+topic_registry_entry_t *topic_registry_at(size_t slot);
+
+#endif /* TOPIC_REGISTRY_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/******************************************************************************
+* File Name:   trace_events.h
+*
+* Description: This file is the table of the trace events of trace_log.c.
+*              It is included by trace_log.h and parsed by
+*              scripts/trace_decode.py, which is the only place the format
+*              strings are used; they are not compiled into the firmware.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+/* TRACE_EVENT(name, id, arguments, format)
+ *
+ *  name      : Identifier passed to TRACE()
+ *  id        : Token written to the trace. Never reuse or renumber an id,
+ *              traces of older firmware are decoded with this table.
+ *  arguments : One character per argument: 'i' for a 32-bit integer, 's'
+ *              for a null-terminated string, 'S' for a string given as its
+ *              length (int) and a pointer, as for %.*s. At most
+ *              'TRACE_STRING_MAX' bytes of a string are kept.
+ *  format    : printf() format of the decoded event, one conversion per
+ *              argument, %u %d %x or %s
+ *
+ * Keep each entry on one line, the decoder reads the table line by line.
+ */
+TRACE_EVENT(TRACE_PUBLISH_SUBMIT,     1, "iiiS", "Submitted %u bytes on lane %u with status %u on '%s'")
+TRACE_EVENT(TRACE_PUBLISH_START,      2, "iiS",  "Publishing %u bytes after %u ms queued on '%s'")
+TRACE_EVENT(TRACE_PUBLISH_DONE,       3, "ii",   "Publish result 0x%x after %u ms")
+TRACE_EVENT(TRACE_PUBLISH_ISR_DROP,   4, "i",    "%u messages from interrupt handlers dropped")
+TRACE_EVENT(TRACE_SUBSCRIBE_RECEIVED, 5, "iiS",  "Received %u bytes with QoS %u on '%s'")
+TRACE_EVENT(TRACE_SUBSCRIBE_DROPPED,  6, "S",    "No subscriber for '%s'")
+
+/* [] END OF FILE */
@@ -0,0 +1,355 @@
+/******************************************************************************
+* File Name:   trace_log.c
+*
+* Description: This file contains the tokenized binary trace. TRACE() writes
+*              the id of an event of trace_events.h and its raw arguments
+*              into a RAM ring; the format strings stay on the host, where
+*              scripts/trace_decode.py turns a dump back into text. The ring
+*              is dumped on 'MQTT_TRACE_TOPIC', or over the UART when
+*              'TRACE_DUMP_OVER_MQTT' is 0.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Task header files */
+#include "trace_log.h"
+#include "publisher_task.h"
+#include "mqtt_task.h"
+
+/* Configuration file for MQTT client */
+#include "mqtt_client_config.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+#if (TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1u)) != 0u
+    #error "TRACE_BUFFER_SIZE must be a power of two."
+#endif
+
+/* Size of the record header: length, id and timestamp. */
+#define TRACE_RECORD_HEADER_SIZE        (7u)
+
+/* Largest dump, one MQTT PUBLISH or one line on the UART. */
+#define TRACE_DUMP_SIZE                 (PUBLISH_PAYLOAD_SIZE)
+
+/* Maximum number of dumps per call of trace_log_dump(), so that a full ring
+ * does not take every publish slot.
+ */
+#define TRACE_DUMP_MAX_COUNT            (4u)
+
+/******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static size_t trace_log_fill(uint8_t *dump, size_t size);
+static void trace_log_put_u32(uint8_t *buffer, uint32_t value);
+
+/******************************************************************************
+* Global Variables
+*******************************************************************************/
+/* Argument characters of each event id, the only part of trace_events.h
+ * compiled into the firmware.
+ */
+static const char *const trace_arguments[] =
+{
+#define TRACE_EVENT(name, id, arguments, format)    [id] = arguments,
+#include "trace_events.h"
+#undef TRACE_EVENT
+};
+
+/* Ring of records. 'head' and 'tail' run freely and are only changed inside
+ * a critical section.
+ */
+static uint8_t trace_ring[TRACE_BUFFER_SIZE];
+static uint32_t trace_head = 0;
+static uint32_t trace_tail = 0;
+
+/* Records overwritten or not dumped since the previous dump. */
+static uint32_t trace_lost = 0;
+
+/******************************************************************************
+ * Function Name: trace_log_write
+ ******************************************************************************
+ * Summary:
+ *  Appends a record of an event to the trace ring, overwriting the oldest
+ *  records if the ring is full. Use the TRACE() macro rather than calling it
+ *  directly, so that the call compiles out with 'TRACE_ENABLED'.
+ *
+ * Parameters:
+ *  uint32_t id : Event of trace_events.h, a trace_id_t. Not the enum type
+ *               itself, va_start() needs a type that is not promoted.
+ *  ... : Arguments of the event, uint32_t or int for 'i', const char * for
+ *        's', int and const char * for 'S'
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void trace_log_write(uint32_t id, ...)
+{
+    uint8_t record[TRACE_RECORD_MAX];
+    size_t len = TRACE_RECORD_HEADER_SIZE;
+    const char *arguments;
+    va_list args;
+
+    if ((id >= sizeof(trace_arguments) / sizeof(trace_arguments[0])) ||
+        (trace_arguments[id] == NULL))
+    {
+        return;
+    }
+
+    record[1] = (uint8_t) id;
+    record[2] = (uint8_t) (id >> 8);
+    trace_log_put_u32(&record[3], xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    /* Arguments that do not fit are left out, the decoder stops at the end
+     * of the record.
+     */
+    va_start(args, id);
+    for (arguments = trace_arguments[id]; *arguments != '\0'; arguments++)
+    {
+        if ((*arguments == 's') || (*arguments == 'S'))
+        {
+            const char *string;
+            size_t string_len;
+
+            if (*arguments == 'S')
+            {
+                string_len = (size_t) va_arg(args, int);
+                string = va_arg(args, const char *);
+            }
+            else
+            {
+                string = va_arg(args, const char *);
+                string_len = strlen(string);
+            }
+
+            if (len + 1u > TRACE_RECORD_MAX)
+            {
+                break;
+            }
+            if (string_len > TRACE_STRING_MAX)
+            {
+                string_len = TRACE_STRING_MAX;
+            }
+            if (string_len > TRACE_RECORD_MAX - len - 1u)
+            {
+                string_len = TRACE_RECORD_MAX - len - 1u;
+            }
+
+            record[len++] = (uint8_t) string_len;
+            memcpy(&record[len], string, string_len);
+            len += string_len;
+        }
+        else
+        {
+            uint32_t value = va_arg(args, uint32_t);
+
+            if (len + 4u > TRACE_RECORD_MAX)
+            {
+                break;
+            }
+
+            trace_log_put_u32(&record[len], value);
+            len += 4u;
+        }
+    }
+    va_end(args);
+
+    record[0] = (uint8_t) len;
+
+    taskENTER_CRITICAL();
+    while ((TRACE_BUFFER_SIZE - (trace_tail - trace_head)) < len)
+    {
+        trace_head += trace_ring[trace_head % TRACE_BUFFER_SIZE];
+        trace_lost++;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        trace_ring[(trace_tail + i) % TRACE_BUFFER_SIZE] = record[i];
+    }
+    trace_tail += len;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: trace_log_dump
+ ******************************************************************************
+ * Summary:
+ *  Moves the records of the trace ring into dumps of at most
+ *  'TRACE_DUMP_SIZE' bytes, and publishes them on 'MQTT_TRACE_TOPIC' or
+ *  prints them as hex lines starting with "TRACE " over the UART. Sends at
+ *  most 'TRACE_DUMP_MAX_COUNT' dumps, the rest is left for the next call.
+ *  Records of a dump that could not be published are counted as lost.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void trace_log_dump(void)
+{
+    uint8_t dump[TRACE_DUMP_SIZE];
+    size_t len;
+
+#if TRACE_DUMP_OVER_MQTT
+    /* Kept in the ring until the broker is reachable. */
+    if (!mqtt_is_connected())
+    {
+        return;
+    }
+#endif
+
+    for (uint32_t count = 0; count < TRACE_DUMP_MAX_COUNT; count++)
+    {
+        len = trace_log_fill(dump, sizeof(dump));
+        if (len == 0)
+        {
+            break;
+        }
+
+#if TRACE_DUMP_OVER_MQTT
+        /* Not coalesced, every dump is sent, and never kept in the outbox. */
+        if (!publisher_replay(dump, len, MQTT_TRACE_TOPIC, false))
+        {
+            uint32_t lost = (uint32_t) dump[1] | ((uint32_t) dump[2] << 8);
+
+            for (size_t i = TRACE_DUMP_HEADER_SIZE; i < len; i += dump[i])
+            {
+                lost++;
+            }
+
+            taskENTER_CRITICAL();
+            trace_lost += lost;
+            taskEXIT_CRITICAL();
+            break;
+        }
+#else
+        printf("TRACE ");
+        for (size_t i = 0; i < len; i++)
+        {
+            printf("%02x", dump[i]);
+        }
+        printf("\n");
+#endif
+    }
+}
+
+/******************************************************************************
+ * Function Name: trace_log_fill
+ ******************************************************************************
+ * Summary:
+ *  Moves the oldest records of the ring into a dump and writes the dump
+ *  header.
+ *
+ * Parameters:
+ *  uint8_t *dump : Dump buffer
+ *  size_t size : Size of the dump buffer
+ *
+ * Return:
+ *  size_t : Length of the dump, 0 if the ring is empty and no record was
+ *           lost
+ *
+ ******************************************************************************/
+static size_t trace_log_fill(uint8_t *dump, size_t size)
+{
+    size_t len = TRACE_DUMP_HEADER_SIZE;
+    uint32_t lost;
+
+    taskENTER_CRITICAL();
+    while (trace_head != trace_tail)
+    {
+        size_t record_len = trace_ring[trace_head % TRACE_BUFFER_SIZE];
+
+        if (len + record_len > size)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < record_len; i++)
+        {
+            dump[len + i] = trace_ring[(trace_head + i) % TRACE_BUFFER_SIZE];
+        }
+        len += record_len;
+        trace_head += record_len;
+    }
+    lost = (trace_lost > UINT16_MAX) ? UINT16_MAX : trace_lost;
+    trace_lost -= lost;
+    taskEXIT_CRITICAL();
+
+    if ((len == TRACE_DUMP_HEADER_SIZE) && (lost == 0))
+    {
+        return 0;
+    }
+
+    dump[0] = TRACE_FORMAT_VERSION;
+    dump[1] = (uint8_t) lost;
+    dump[2] = (uint8_t) (lost >> 8);
+
+    return len;
+}
+
+/******************************************************************************
+ * Function Name: trace_log_put_u32
+ ******************************************************************************
+ * Summary:
+ *  Writes a 32-bit integer in little-endian byte order.
+ *
+ * Parameters:
+ *  uint8_t *buffer : Destination, 4 bytes
+ *  uint32_t value : Integer
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+static void trace_log_put_u32(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t) value;
+    buffer[1] = (uint8_t) (value >> 8);
+    buffer[2] = (uint8_t) (value >> 16);
+    buffer[3] = (uint8_t) (value >> 24);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,108 @@
+/******************************************************************************
+* File Name:   trace_log.h
+*
+* Description: This file is the public interface of trace_log.c, the
+*              tokenized binary trace.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef TRACE_LOG_H_
+#define TRACE_LOG_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* 1 records the TRACE() events, 0 compiles them out. Can be overridden from
+ * the Makefile, e.g. DEFINES+=TRACE_ENABLED=0.
+ */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED                         (1)
+#endif
+
+/* Size in bytes of the RAM ring holding the trace. When it is full, the
+ * oldest records are overwritten.
+ */
+#define TRACE_BUFFER_SIZE                     (1024u)
+
+/* Longest string argument kept in a record. */
+#define TRACE_STRING_MAX                      (16u)
+
+/* Longest record: length, id, timestamp and the arguments. */
+#define TRACE_RECORD_MAX                      (48u)
+
+/* Layout version, the first byte of every dump. A dump is the version, the
+ * number of records lost since the previous dump (uint16_t), then records
+ * of: length (uint8_t, including itself), id (uint16_t), timestamp in
+ * milliseconds (uint32_t), and the arguments. An integer takes 4 bytes, a
+ * string its length in one byte followed by its bytes. All integers are
+ * little-endian.
+ */
+#define TRACE_FORMAT_VERSION                  (1u)
+#define TRACE_DUMP_HEADER_SIZE                (3u)
+
+/* Records an event of trace_events.h, e.g.
+ * TRACE(TRACE_PUBLISH_DONE, result, delay_ms). The arguments must match the
+ * argument characters of the event. Not for interrupt handlers.
+ */
+#if TRACE_ENABLED
+#define TRACE(...)          trace_log_write(__VA_ARGS__)
+#else
+#define TRACE(...)          do { } while (0)
+#endif
+
+/*******************************************************************************
+* Global Variables
+********************************************************************************/
+/* Trace event ids. */
+typedef enum
+{
+#define TRACE_EVENT(name, id, arguments, format)    name = (id),
+#include "trace_events.h"
+#undef TRACE_EVENT
+} trace_id_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void trace_log_write(uint32_t id, ...);
+void trace_log_dump(void);
+
+#endif /* TRACE_LOG_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,251 @@
+/******************************************************************************
+* File Name:   wire_stats.c
+*
+* Description: This file counts the bytes of the PUBLISH packets sent, split
+*              into topic, payload and protocol overhead. The MQTT library
+*              only speaks MQTT 3.1.1, so every PUBLISH carries its full
+*              topic name; the same packets are also sized as MQTT 5 would
+*              send them with topic aliases, to tell what moving to MQTT 5
+*              would save on the traffic of this application.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "topic_registry.h"
+#include "publisher_task.h"
+#include "mqtt_client_config.h"
+#include "wire_stats.h"
+
+/******************************************************************************
+* Macros
+******************************************************************************/
+/* MQTT 5 Topic Alias property: identifier byte and 16-bit alias. */
+#define WIRE_STATS_TOPIC_ALIAS_PROPERTY_SIZE   (3u)
+
+/******************************************************************************
+* Typedefs
+******************************************************************************/
+/* Byte counters since start-up. */
+typedef struct
+{
+    uint32_t publishes;
+    uint32_t bytes;                     /* MQTT 3.1.1 PUBLISH packets */
+    uint32_t topic_bytes;               /* Topic names in those packets */
+    uint32_t payload_bytes;
+    uint32_t mqtt5_bytes;               /* Same packets in MQTT 5 with aliases */
+    uint32_t reported;                  /* 'publishes' at the last report */
+} wire_stats_t;
+
+/******************************************************************************
+* Global Variables
+******************************************************************************/
+/* Counters and alias table, updated by the publisher tasks inside critical
+ * sections.
+ */
+static wire_stats_t wire_stats;
+
+/* Topics holding an MQTT 5 alias on the current connection, by hash and
+ * length; a hash collision only makes the estimate slightly optimistic.
+ */
+static uint32_t wire_stats_alias_hash[WIRE_STATS_TOPIC_ALIAS_MAXIMUM];
+static uint16_t wire_stats_alias_len[WIRE_STATS_TOPIC_ALIAS_MAXIMUM];
+static uint32_t wire_stats_alias_count = 0;
+
+/******************************************************************************
+* Function Prototypes
+******************************************************************************/
+static uint32_t wire_stats_packet_size(uint32_t remaining_len);
+
+/******************************************************************************
+ * Function Name: wire_stats_publish
+ ******************************************************************************
+ * Summary:
+ *  Counts a PUBLISH packet put on the wire, retransmissions included. The
+ *  MQTT 5 estimate sends the topic with a new alias the first time it is
+ *  published on the connection, while aliases are left, and only the alias
+ *  afterwards.
+ *
+ * Parameters:
+ *  const char *topic : Topic name
+ *  size_t topic_len : Length of the topic name
+ *  size_t payload_len : Length of the payload
+ *  bool qos0 : true for a QoS 0 publish, which has no packet identifier
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void wire_stats_publish(const char *topic, size_t topic_len, size_t payload_len, bool qos0)
+{
+    uint32_t hash = topic_registry_hash(topic, topic_len);
+    uint32_t packet_id_len = qos0 ? 0u : 2u;
+    uint32_t mqtt5_topic_len = (uint32_t) topic_len;
+    bool aliased = false;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < wire_stats_alias_count; i++)
+    {
+        if ((wire_stats_alias_hash[i] == hash) && (wire_stats_alias_len[i] == topic_len))
+        {
+            aliased = true;
+            mqtt5_topic_len = 0;
+            break;
+        }
+    }
+    if (!aliased && (wire_stats_alias_count < WIRE_STATS_TOPIC_ALIAS_MAXIMUM))
+    {
+        wire_stats_alias_hash[wire_stats_alias_count] = hash;
+        wire_stats_alias_len[wire_stats_alias_count] = (uint16_t) topic_len;
+        wire_stats_alias_count++;
+        aliased = true;
+    }
+
+    /* Topic length field, topic, packet identifier, payload; MQTT 5 adds the
+     * properties length and the Topic Alias property.
+     */
+    uint32_t mqtt5_properties_len = aliased ? WIRE_STATS_TOPIC_ALIAS_PROPERTY_SIZE : 0u;
+
+    wire_stats.publishes++;
+    wire_stats.bytes += wire_stats_packet_size(2u + (uint32_t) topic_len + packet_id_len +
+                                               (uint32_t) payload_len);
+    wire_stats.mqtt5_bytes += wire_stats_packet_size(2u + mqtt5_topic_len + packet_id_len + 1u +
+                                                     mqtt5_properties_len + (uint32_t) payload_len);
+    wire_stats.topic_bytes += (uint32_t) topic_len;
+    wire_stats.payload_bytes += (uint32_t) payload_len;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: wire_stats_connection_reset
+ ******************************************************************************
+ * Summary:
+ *  Forgets the aliases of the MQTT 5 estimate, which only live as long as
+ *  the connection. Called on every new MQTT connection.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void wire_stats_connection_reset(void)
+{
+    taskENTER_CRITICAL();
+    wire_stats_alias_count = 0;
+    taskEXIT_CRITICAL();
+}
+
+/******************************************************************************
+ * Function Name: wire_stats_diagnostics
+ ******************************************************************************
+ * Summary:
+ *  Publishes the byte counters on 'MQTT_WIRE_DIAGNOSTICS_TOPIC' as a JSON
+ *  object, if publishes other than the previous report were counted since.
+ *
+ * Parameters:
+ *  void
+ *
+ * Return:
+ *  void
+ *
+ ******************************************************************************/
+void wire_stats_diagnostics(void)
+{
+    char payload[PUBLISH_PAYLOAD_SIZE + 1];
+    wire_stats_t stats;
+
+    taskENTER_CRITICAL();
+    stats = wire_stats;
+    /* The report is itself a publish, and is counted. */
+    if (wire_stats.publishes > (wire_stats.reported + 1u))
+    {
+        wire_stats.reported = wire_stats.publishes + 1u;
+    }
+    taskEXIT_CRITICAL();
+
+    if (stats.publishes <= (stats.reported + 1u))
+    {
+        return;
+    }
+
+    int written = snprintf(payload, sizeof(payload),
+                           "{\"publishes\":%lu,\"bytes\":%lu,\"topic_bytes\":%lu,"
+                           "\"payload_bytes\":%lu,\"mqtt5_bytes\":%lu}",
+                           (unsigned long) stats.publishes,
+                           (unsigned long) stats.bytes,
+                           (unsigned long) stats.topic_bytes,
+                           (unsigned long) stats.payload_bytes,
+                           (unsigned long) stats.mqtt5_bytes);
+    if ((written > 0) && ((size_t) written < sizeof(payload)))
+    {
+        PublishMessage(payload, MQTT_WIRE_DIAGNOSTICS_TOPIC);
+    }
+}
+
+/******************************************************************************
+ * Function Name: wire_stats_packet_size
+ ******************************************************************************
+ * Summary:
+ *  Returns the size of a packet with the given remaining length: the packet
+ *  type byte, the variable length encoding of the remaining length, and the
+ *  remaining bytes.
+ *
+ * Parameters:
+ *  uint32_t remaining_len : Remaining length of the packet
+ *
+ * Return:
+ *  uint32_t : Packet size in bytes
+ *
+ ******************************************************************************/
+static uint32_t wire_stats_packet_size(uint32_t remaining_len)
+{
+    uint32_t length_bytes = 1u;
+
+    for (uint32_t len = remaining_len; len > 127u; len >>= 7)
+    {
+        length_bytes++;
+    }
+
+    return 1u + length_bytes + remaining_len;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,69 @@
+/******************************************************************************
+* File Name:   wire_stats.h
+*
+* Description: This file is the public interface of wire_stats.c, which
+*              counts the bytes the publishes put on the wire and estimates
+*              what MQTT 5 topic aliases would save on them.
+*
+* Related Document: See README.md
+*
+*
+*******************************************************************************
+* Copyright 2020-2024, Cypress Semiconductor Corporation (an Infineon company) or
+* an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+*
+* This software, including source code, documentation and related
+* materials ("Software") is owned by Cypress Semiconductor Corporation
+* or one of its affiliates ("Cypress") and is protected by and subject to
+* worldwide patent protection (United States and foreign),
+* United States copyright laws and international treaty provisions.
+* Therefore, you may use this Software only as provided in the license
+* agreement accompanying the software package from which you
+* obtained this Software ("EULA").
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software
+* source code solely for use in connection with Cypress's
+* integrated circuit products.  Any reproduction, modification, translation,
+* compilation, or representation of this Software except as specified
+* above is prohibited without the express written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer
+* of such system or application assumes all risk of such use and in doing
+* so agrees to indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef WIRE_STATS_H_
+#define WIRE_STATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Topic Alias Maximum assumed for the MQTT 5 estimate: number of aliases
+ * the broker accepts on a connection. Aliases are taken first come, first
+ * served, and are forgotten with the connection.
+ */
+#define WIRE_STATS_TOPIC_ALIAS_MAXIMUM     (8u)
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+void wire_stats_publish(const char *topic, size_t topic_len, size_t payload_len, bool qos0);
+void wire_stats_connection_reset(void);
+void wire_stats_diagnostics(void);
+
+#endif /* WIRE_STATS_H_ */
+
+/* [] END OF FILE */